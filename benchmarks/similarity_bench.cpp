@@ -0,0 +1,85 @@
+#include "kernels/similarity.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace tarius::kernels;
+
+namespace
+{
+    constexpr std::size_t kDimension = 2048; // Llama 3.2 1B embedding width
+    constexpr std::size_t kRows = 20000;
+    constexpr int kRepeats = 5;
+
+    template <typename Fn>
+    double bestOfMs(Fn &&fn)
+    {
+        double best = 1e30;
+        for (int r = 0; r < kRepeats; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : kRows;
+    std::size_t dim = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : kDimension;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist;
+
+    std::vector<float> query(dim), matrix(rows * dim);
+    for (auto &v : query)
+        v = dist(rng);
+    for (auto &v : matrix)
+        v = dist(rng);
+
+    std::vector<fp16_t> queryF16(dim), matrixF16(rows * dim);
+    floatToHalf(query.data(), queryF16.data(), dim);
+    floatToHalf(matrix.data(), matrixF16.data(), rows * dim);
+
+    std::vector<int8_t> queryI8(dim), matrixI8(rows * dim);
+    std::vector<float> rowScales(rows);
+    float queryScale = quantizeI8(query.data(), queryI8.data(), dim);
+    for (std::size_t i = 0; i < rows; i++)
+    {
+        rowScales[i] = quantizeI8(matrix.data() + i * dim, matrixI8.data() + i * dim, dim);
+    }
+
+    std::vector<float> scores(rows);
+    double bytesF32 = static_cast<double>(rows) * dim * sizeof(float);
+
+    std::printf("rows=%zu dim=%zu (best of %d)\n", rows, dim, kRepeats);
+    std::printf("%-8s %12s %12s %12s %12s\n", "isa", "f32 ms", "f16 ms", "i8 ms", "top10 ms");
+
+    for (Isa isa : {Isa::Scalar, Isa::Avx2, Isa::Avx512, Isa::Neon})
+    {
+        if (!setIsa(isa))
+        {
+            continue;
+        }
+
+        double f32 = bestOfMs([&]
+                              { dotBatchF32(query.data(), matrix.data(), rows, dim, scores.data()); });
+        double f16 = bestOfMs([&]
+                              { dotBatchF16(queryF16.data(), matrixF16.data(), rows, dim, scores.data()); });
+        double i8 = bestOfMs([&]
+                             { dotBatchI8(queryI8.data(), queryScale, matrixI8.data(), rowScales.data(), rows, dim, scores.data()); });
+        volatile std::size_t sink = 0;
+        double top = bestOfMs([&]
+                              { sink += topK(scores.data(), rows, 10).size(); });
+
+        std::printf("%-8s %12.3f %12.3f %12.3f %12.3f   (f32 %.1f GB/s)\n", isaName(isa), f32, f16, i8, top,
+                    bytesF32 / (f32 * 1e6));
+    }
+
+    return 0;
+}
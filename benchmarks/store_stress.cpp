@@ -0,0 +1,214 @@
+#include "ai_secretary/calendar.h"
+#include "ai_secretary/task_list.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Concurrency and scaling check for the calendar and task stores. Reader
+// threads query both while one writer adds, completes, skips and removes
+// entries; build with -fsanitize=thread to check the locking. The stores
+// are then filled to a few tens of thousands of entries to show that a
+// change costs about the same at any size.
+//
+//   tarius_store_stress [seconds] [entries]
+
+using namespace tarius::ai_secretary;
+using Clock = std::chrono::system_clock;
+
+namespace
+{
+    constexpr int kReaders = 3;
+
+    std::atomic<bool> g_failed{false};
+
+    void fail(const char *what)
+    {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+
+    Calendar::Event makeEvent(const std::string &title, Clock::time_point time)
+    {
+        Calendar::Event event;
+        event.title = title;
+        event.time = time;
+        event.duration = std::chrono::minutes(30);
+        return event;
+    }
+
+    void reader(const Calendar &calendar, const TaskList &tasks, Clock::time_point base, std::atomic<bool> &stop,
+                std::atomic<uint64_t> &queries)
+    {
+        while (!stop)
+        {
+            auto all = tasks.getAllTasks();
+            for (const auto &task : all)
+            {
+                if (!task || task->id.empty())
+                {
+                    fail("task view without a task");
+                }
+            }
+            for (const auto &task : tasks.getOverdueTasks(base + std::chrono::hours(24 * 365)))
+            {
+                if (task->completed)
+                {
+                    fail("completed task listed as overdue");
+                }
+            }
+            tasks.getTasksByPriority(1);
+
+            auto events = calendar.getEventsInRange(base, base + std::chrono::hours(24 * 30));
+            for (std::size_t i = 1; i < events.size(); i++)
+            {
+                if (events[i].time < events[i - 1].time)
+                {
+                    fail("range query out of order");
+                }
+            }
+            calendar.getBusy(base, base + std::chrono::hours(24 * 7));
+            calendar.findConflicts(makeEvent("probe", base + std::chrono::hours(5)));
+            queries += 6;
+        }
+    }
+
+    void writer(Calendar &calendar, TaskList &tasks, Clock::time_point base, std::atomic<bool> &stop,
+                std::atomic<uint64_t> &changes)
+    {
+        std::vector<std::string> open;
+        for (uint64_t n = 0; !stop; n++)
+        {
+            TaskList::Task task;
+            task.description = "task " + std::to_string(n);
+            task.dueTime = base + std::chrono::minutes(static_cast<int>(n % 5000));
+            task.priority = static_cast<int>(n % 3);
+            open.push_back(tasks.addTask(task));
+            calendar.addEvent(makeEvent("event " + std::to_string(n % 200), base + std::chrono::minutes(n % 20000)));
+
+            if (n % 3 == 0)
+            {
+                tasks.completeTask(open.back());
+            }
+            if (n % 5 == 0 && open.size() > 1)
+            {
+                tasks.removeTask(open.front());
+                open.erase(open.begin());
+            }
+            if (n % 50 == 0)
+            {
+                Calendar::Event series = makeEvent("standup", base + std::chrono::hours(1));
+                series.recurrence.frequency = Calendar::Recurrence::Frequency::Daily;
+                calendar.addEvent(series);
+                calendar.skipOccurrence("standup", base + std::chrono::hours(25));
+            }
+            if (n % 7 == 0)
+            {
+                calendar.removeEvent("event " + std::to_string((n / 7) % 200));
+            }
+            changes += 4;
+        }
+    }
+
+    // Mean time of one addTask, completeTask and addEvent once the stores hold entries
+    void measure(Calendar &calendar, TaskList &tasks, Clock::time_point base, int entries)
+    {
+        for (int n = 0; n < entries; n++)
+        {
+            TaskList::Task task;
+            task.description = "filler " + std::to_string(n);
+            task.dueTime = base + std::chrono::minutes(n);
+            tasks.addTask(task);
+            calendar.addEvent(makeEvent("filler " + std::to_string(n), base + std::chrono::minutes(n * 7)));
+        }
+
+        constexpr int kSamples = 500;
+        std::vector<std::string> ids;
+        auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < kSamples; n++)
+        {
+            TaskList::Task task;
+            task.description = "sample " + std::to_string(n);
+            task.dueTime = base + std::chrono::minutes(n * 13);
+            ids.push_back(tasks.addTask(task));
+        }
+        auto added = std::chrono::steady_clock::now();
+        for (const auto &id : ids)
+        {
+            tasks.completeTask(id);
+        }
+        auto completed = std::chrono::steady_clock::now();
+        for (int n = 0; n < kSamples; n++)
+        {
+            calendar.addEvent(makeEvent("sample " + std::to_string(n), base + std::chrono::minutes(n * 11)));
+        }
+        auto scheduled = std::chrono::steady_clock::now();
+
+        auto us = [](auto from, auto to)
+        { return std::chrono::duration<double, std::micro>(to - from).count() / kSamples; };
+        std::printf("at %d entries: addTask %.1f us, completeTask %.1f us, addEvent %.1f us\n", entries,
+                    us(start, added), us(added, completed), us(completed, scheduled));
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+    const int entries = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+    tarius::utils::Logger::init();
+    tarius::utils::Logger::setConsoleLevel(spdlog::level::err);
+
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "tarius-store-stress";
+    fs::remove_all(root);
+    const auto base = std::chrono::floor<std::chrono::minutes>(Clock::now()) + std::chrono::hours(24);
+
+    {
+        Calendar calendar(root.string());
+        TaskList tasks(root.string());
+
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> queries{0};
+        std::atomic<uint64_t> changes{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kReaders; i++)
+        {
+            threads.emplace_back(reader, std::cref(calendar), std::cref(tasks), base, std::ref(stop),
+                                 std::ref(queries));
+        }
+        threads.emplace_back(writer, std::ref(calendar), std::ref(tasks), base, std::ref(stop), std::ref(changes));
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        std::printf("%d readers, 1 writer: %llu queries, %llu changes in %.1f s\n", kReaders,
+                    static_cast<unsigned long long>(queries.load()), static_cast<unsigned long long>(changes.load()),
+                    seconds);
+    }
+
+    fs::remove_all(root);
+    {
+        Calendar calendar(root.string());
+        TaskList tasks(root.string());
+        measure(calendar, tasks, base, entries / 10);
+        measure(calendar, tasks, base, entries - entries / 10);
+    }
+    fs::remove_all(root);
+
+    tarius::utils::Logger::shutdown();
+    if (g_failed)
+    {
+        return 1;
+    }
+    std::printf("no failures\n");
+    return 0;
+}
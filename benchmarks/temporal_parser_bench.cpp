@@ -0,0 +1,105 @@
+#include "ai_secretary/intent_classifier.h"
+#include "ai_secretary/temporal_parser.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace tarius::ai_secretary;
+
+namespace
+{
+    constexpr int kIterations = 2000;
+    constexpr int kRepeats = 5;
+
+    const std::vector<std::string> kInputs = {
+        "Schedule a meeting with Dana tomorrow at 3pm",
+        "Remind me to call mom next Tuesday 09:30",
+        "Appointment with the dentist on 2026-11-02 at 9:15 am",
+        "Summarize our conversation from last week",
+        "Set up a team sync in 2 hours",
+        "What do you think about the new design?",
+        "Schedule gym every monday and friday at 6:00 pm",
+        "Don't forget to pay rent on Nov 1st",
+    };
+
+    template <typename Fn>
+    double bestOfUs(Fn &&fn)
+    {
+        double best = 1e30;
+        for (int r = 0; r < kRepeats; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kIterations; i++)
+            {
+                fn();
+            }
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        return best / (static_cast<double>(kIterations) * kInputs.size());
+    }
+
+    // What the secretary used to do per input: lowercase, search the keyword
+    // lists, and run the date and time regexes
+    bool regexBaseline(const std::string &input, std::string &date, std::string &time)
+    {
+        std::string lowerInput = input;
+        std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(),
+                       [](unsigned char c)
+                       { return std::tolower(c); });
+        bool scheduling = (lowerInput.find("schedule") != std::string::npos ||
+                           lowerInput.find("meeting") != std::string::npos) &&
+                          (std::regex_search(lowerInput, std::regex("\\b\\d{1,2}(:\\d{2})?\\s*(am|pm)\\b")) ||
+                           std::regex_search(lowerInput, std::regex("\\b\\d{4}-\\d{2}-\\d{2}\\b")));
+
+        std::smatch match;
+        if (std::regex_search(input, match, std::regex("\\b(\\d{4}-\\d{2}-\\d{2})\\b")))
+        {
+            date = match[1];
+        }
+        if (std::regex_search(input, match, std::regex("\\b(\\d{1,2}:\\d{2})\\s*(am|pm)?\\b", std::regex_constants::icase)))
+        {
+            time = match[1];
+        }
+        return scheduling;
+    }
+} // namespace
+
+int main()
+{
+    IntentClassifier classifier;
+    auto now = std::chrono::system_clock::now();
+    volatile std::size_t sink = 0;
+
+    double regex = bestOfUs([&]
+                            {
+                                for (const auto &input : kInputs)
+                                {
+                                    std::string date, time;
+                                    sink += regexBaseline(input, date, time) + date.size() + time.size();
+                                } });
+    double classify = bestOfUs([&]
+                               {
+                                   for (const auto &input : kInputs)
+                                   {
+                                       sink += static_cast<std::size_t>(classifier.classify(input).intent);
+                                   } });
+    double parse = bestOfUs([&]
+                            {
+                                for (const auto &input : kInputs)
+                                {
+                                    sink += TemporalParser::parse(input, now).spanCount;
+                                } });
+
+    std::printf("%zu inputs x %d (best of %d), per input:\n", kInputs.size(), kIterations, kRepeats);
+    std::printf("%-24s %10.3f us\n", "regex baseline", regex);
+    std::printf("%-24s %10.3f us\n", "intent classifier", classify);
+    std::printf("%-24s %10.3f us\n", "temporal parser", parse);
+    std::printf("%-24s %10.3f us\n", "classifier + parser", classify + parse);
+    return 0;
+}
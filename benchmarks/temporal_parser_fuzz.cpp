@@ -0,0 +1,294 @@
+#include "ai_secretary/intent_classifier.h"
+#include "ai_secretary/temporal_parser.h"
+#include "utils/time_utils.h"
+#include <chrono>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Random-input driver for the intent classifier, the temporal parser and
+// the ISO parsers. Inputs are strung together from the words and numbers
+// these parsers react to, so most of them reach resolution. Build with
+// -fsanitize=address,undefined to catch overflow as well as the invariant
+// failures checked here.
+//
+//   tarius_temporal_fuzz [seconds] [seed]
+//
+// LLVMFuzzerTestOneInput is the same check on one input, for libFuzzer:
+// compile this file with -fsanitize=fuzzer -DTARIUS_LIBFUZZER.
+
+using namespace tarius::ai_secretary;
+using tarius::utils::TimeUtils;
+
+namespace
+{
+    const char *const kVocabulary[] = {
+        "schedule", "meeting", "appointment", "remind", "me", "to", "summarize", "chat", "review", "every",
+        "other", "and", "on", "at", "by", "in", "of", "the", "a", "an", "next", "this", "last", "past",
+        "today", "tonight", "tomorrow", "yesterday", "day", "after", "week", "weeks", "month", "months",
+        "year", "days", "hour", "hours", "min", "minutes", "noon", "midnight", "daily", "weekly", "monthly",
+        "weekdays", "weekday", "monday", "mondays", "tue", "thurs", "friday", "sunday", "may", "nov", "february",
+        "december", "am", "pm", "a.m.", "p.m.", "o'clock", "st", "nd", "th", ",", ":", "-", ".", "'",
+        "0", "1", "2", "9", "12", "13", "24", "28", "29", "30", "31", "59", "60", "99", "1677", "1678", "2026", "2261",
+        "2262", "2999", "9999", "10000", "99999999999", "2026-02-29", "2024-02-29", "2999-01-01", "1000-12-31",
+        "2026-02-30", "2027-02-29", "2026-04-31"};
+
+    const char *const kMonths[] = {"january", "february", "march", "april", "may", "june", "july", "august",
+                                   "september", "october", "november", "december", "jan", "feb", "mar", "apr",
+                                   "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec", "sept"};
+    const int kMonthNumber[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 9};
+
+    // The day a span names, if it is an ISO date or a day and month name;
+    // year is -1 when not given
+    bool dayNamedIn(std::string_view text, int &year, int &month, int &day)
+    {
+        std::vector<std::string> numbers;
+        month = 0;
+        for (std::size_t pos = 0; pos < text.size();)
+        {
+            std::size_t end = pos;
+            bool digits = std::isdigit(static_cast<unsigned char>(text[pos]));
+            while (end < text.size() && (digits ? std::isdigit(static_cast<unsigned char>(text[end]))
+                                                : std::isalpha(static_cast<unsigned char>(text[end]))))
+            {
+                end++;
+            }
+            if (end == pos)
+            {
+                pos++;
+                continue;
+            }
+            std::string token(text.substr(pos, end - pos));
+            if (digits)
+            {
+                numbers.push_back(token);
+            }
+            else
+            {
+                for (auto &c : token)
+                {
+                    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                }
+                for (std::size_t i = 0; i < std::size(kMonths); i++)
+                {
+                    if (token == kMonths[i])
+                    {
+                        month = kMonthNumber[i];
+                    }
+                }
+            }
+            pos = end;
+        }
+
+        year = -1;
+        day = 0;
+        if (month == 0)
+        {
+            // 2026-11-02
+            if (numbers.size() != 3 || numbers[0].size() != 4)
+            {
+                return false;
+            }
+            year = std::stoi(numbers[0]);
+            month = std::stoi(numbers[1]);
+            day = std::stoi(numbers[2]);
+            return true;
+        }
+        for (const auto &number : numbers)
+        {
+            (number.size() == 4 ? year : day) = std::stoi(number);
+        }
+        return day != 0;
+    }
+
+    bool fail(const std::string &input, const char *what)
+    {
+        std::fprintf(stderr, "FAILED (%s) on input: \"%s\"\n", what, input.c_str());
+        return false;
+    }
+
+    bool check(const std::string &input, std::chrono::system_clock::time_point now,
+               const IntentClassifier &classifier)
+    {
+        auto intent = classifier.classify(input);
+        for (int k = 0; k < IntentClassifier::KeywordCount; k++)
+        {
+            auto keyword = static_cast<IntentClassifier::Keyword>(k);
+            if (intent.has(keyword) && (intent.spanOf(keyword).empty() || intent.spanOf(keyword).end > input.size()))
+            {
+                return fail(input, "keyword span out of bounds");
+            }
+        }
+        if (intent.date.end > input.size() || (intent.hasTime && intent.time.span.end > input.size()))
+        {
+            return fail(input, "classifier span out of bounds");
+        }
+
+        auto result = TemporalParser::parse(input, now);
+        std::size_t previousEnd = 0;
+        for (std::size_t i = 0; i < result.spanCount; i++)
+        {
+            const auto &span = result.spans[i];
+            if (span.begin >= span.end || span.end > input.size() || span.begin < previousEnd)
+            {
+                return fail(input, "parser spans out of order or bounds");
+            }
+            previousEnd = span.end;
+        }
+        const auto &repetition = result.repetition;
+        if (repetition.span.end > input.size() ||
+            (repetition.frequency == TemporalParser::Repetition::Frequency::None) != repetition.span.empty())
+        {
+            return fail(input, "repetition span out of bounds");
+        }
+        if (result.lastDays < 0 || result.lastDays > 999)
+        {
+            return fail(input, "period out of range");
+        }
+        if (!result.found() || result.outOfRange)
+        {
+            if (result.when != now)
+            {
+                return fail(input, "unresolved input not at now");
+            }
+        }
+        else
+        {
+            int year = tarius::utils::TimeZone::local().toCivil(result.when).year;
+            if (year < TimeUtils::kMinYear || year > TimeUtils::kMaxYear)
+            {
+                return fail(input, "resolved year out of range");
+            }
+            if (std::chrono::duration_cast<std::chrono::seconds>(result.when.time_since_epoch()).count() % 60 != 0)
+            {
+                return fail(input, "resolved time not on a whole minute");
+            }
+
+            // A date the parser read resolves to that very day; "midnight" is the end of it
+            const auto &zone = tarius::utils::TimeZone::local();
+            for (std::size_t i = 0; i < result.spanCount; i++)
+            {
+                const auto &span = result.spans[i];
+                int namedYear, namedMonth, namedDay;
+                if (!dayNamedIn(std::string_view(input).substr(span.begin, span.size()), namedYear, namedMonth,
+                                namedDay))
+                {
+                    continue;
+                }
+                auto matches = [&](std::chrono::system_clock::time_point time)
+                {
+                    auto civil = zone.toCivil(time);
+                    return civil.month == namedMonth && civil.day == namedDay &&
+                           (namedYear < 0 ? civil.year >= zone.toCivil(now).year : civil.year == namedYear);
+                };
+                auto civil = zone.toCivil(result.when);
+                bool midnight = civil.hour == 0 && civil.minute == 0;
+                if (!matches(result.when) && !(midnight && matches(result.when - std::chrono::hours(24))))
+                {
+                    return fail(input, "named date resolves to another day");
+                }
+            }
+        }
+
+        // Every ISO date that parses formats back to itself
+        for (std::size_t pos = 0; pos + TimeUtils::kIsoDateLength <= input.size(); pos++)
+        {
+            std::string_view text(input.data() + pos, TimeUtils::kIsoDateLength);
+            int days = 0;
+            if (TimeUtils::parseIsoDate(text, days) && TimeUtils::formatIsoDate(days) != text)
+            {
+                return fail(input, "ISO date does not round-trip");
+            }
+            std::chrono::system_clock::time_point time;
+            if (pos + TimeUtils::kIsoDateTimeLength <= input.size() &&
+                TimeUtils::parseIsoDateTime(std::string_view(input.data() + pos, TimeUtils::kIsoDateTimeLength), time))
+            {
+                int year = tarius::utils::TimeZone::local().toCivil(time).year;
+                if (year < TimeUtils::kMinYear - 1 || year > TimeUtils::kMaxYear + 1)
+                {
+                    return fail(input, "ISO timestamp out of range");
+                }
+            }
+        }
+        return true;
+    }
+
+    std::string randomInput(std::mt19937_64 &rng)
+    {
+        std::uniform_int_distribution<int> length(1, 12);
+        std::uniform_int_distribution<std::size_t> word(0, std::size(kVocabulary) - 1);
+        std::uniform_int_distribution<int> glue(0, 5);
+        std::uniform_int_distribution<int> byte(1, 255);
+
+        std::string input;
+        for (int n = length(rng); n > 0; n--)
+        {
+            input += kVocabulary[word(rng)];
+            switch (glue(rng))
+            {
+            case 0:
+                break; // Run into the next token
+            case 1:
+                input += static_cast<char>(byte(rng));
+                break;
+            default:
+                input += ' ';
+                break;
+            }
+        }
+        return input;
+    }
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size)
+{
+    static const IntentClassifier classifier;
+    std::string input(reinterpret_cast<const char *>(data), size);
+    if (!check(input, std::chrono::system_clock::now(), classifier))
+    {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef TARIUS_LIBFUZZER
+int main(int argc, char **argv)
+{
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+    const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::random_device{}();
+
+    IntentClassifier classifier;
+    std::mt19937_64 rng(seed);
+    // A fixed spread of "now"s, so relative expressions cross month and year ends
+    std::uniform_int_distribution<int> nowDay(TimeUtils::daysFromCivil(2000, 1, 1),
+                                              TimeUtils::daysFromCivil(2100, 12, 31));
+    std::uniform_int_distribution<int> nowSecond(0, 86399);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    uint64_t runs = 0;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        for (int i = 0; i < 256; i++, runs++)
+        {
+            auto now = TimeUtils::startOfDay(nowDay(rng), tarius::utils::TimeZone::utc()) +
+                       std::chrono::seconds(nowSecond(rng));
+            if (!check(randomInput(rng), now, classifier))
+            {
+                std::fprintf(stderr, "seed %llu, run %llu\n", static_cast<unsigned long long>(seed),
+                             static_cast<unsigned long long>(runs));
+                return 1;
+            }
+        }
+    }
+
+    std::printf("%llu inputs, no failures (seed %llu)\n", static_cast<unsigned long long>(runs),
+                static_cast<unsigned long long>(seed));
+    return 0;
+}
+#endif
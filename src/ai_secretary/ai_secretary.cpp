@@ -1,219 +1,220 @@
 #include "ai_secretary.h"
 #include "../utils/logger.h"
+#include "../utils/time_utils.h"
 #include <algorithm>
 #include <cctype>
-#include <regex>
 #include <sstream>
+#include <string_view>
 #include <chrono>
-#include <iomanip>
 
 namespace tarius::ai_secretary
 {
-
-    AISecretary::AISecretary()
-        : m_calendar(std::make_unique<Calendar>()),
-          m_taskList(std::make_unique<TaskList>())
+    namespace
     {
-    }
+        // Input with the given keywords and the date and time expressions cut
+        // out, whitespace collapsed
+        std::string removeSpans(const std::string &input, const IntentClassifier::Result &intent,
+                                std::initializer_list<IntentClassifier::Keyword> keywords,
+                                const TemporalParser::Result &when)
+        {
+            std::vector<IntentClassifier::Span> spans(when.spans.begin(), when.spans.begin() + when.spanCount);
+            for (auto keyword : keywords)
+            {
+                if (intent.has(keyword))
+                {
+                    spans.push_back(intent.spanOf(keyword));
+                }
+            }
+            std::sort(spans.begin(), spans.end(), [](const auto &a, const auto &b)
+                      { return a.begin < b.begin; });
 
-    AISecretary::~AISecretary() = default;
+            std::string result;
+            result.reserve(input.size());
+            auto append = [&result](const std::string &text, std::size_t from, std::size_t to)
+            {
+                for (std::size_t i = from; i < to; i++)
+                {
+                    if (!std::isspace(static_cast<unsigned char>(text[i])))
+                    {
+                        result += text[i];
+                    }
+                    else if (!result.empty() && result.back() != ' ')
+                    {
+                        result += ' ';
+                    }
+                }
+            };
 
-    bool AISecretary::isSecretaryTask(const std::string &input)
-    {
-        return isSchedulingTask(input) || isReminderTask(input) || isSummaryTask(input);
-    }
+            std::size_t pos = 0;
+            for (const auto &span : spans)
+            {
+                if (span.begin > pos)
+                {
+                    append(input, pos, span.begin);
+                }
+                pos = std::max(pos, span.end);
+            }
+            append(input, std::min(pos, input.size()), input.size());
 
-    std::string AISecretary::handleTask(const std::string &input)
-    {
-        if (isSchedulingTask(input))
-        {
-            return handleScheduling(input);
-        }
-        else if (isReminderTask(input))
-        {
-            return handleReminder(input);
+            if (!result.empty() && result.back() == ' ')
+            {
+                result.pop_back();
+            }
+            return result;
         }
-        else if (isSummaryTask(input))
+
+        // Word characters as \b sees them
+        bool isWordChar(char c)
         {
-            return handleSummary(input);
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
         }
 
-        return "I'm not sure how to handle that task.";
-    }
-
-    std::vector<std::string> AISecretary::getActiveReminders()
-    {
-        // Get current time
-        auto now = std::chrono::system_clock::now();
-
-        // Check for calendar events
-        auto events = m_calendar->getEventsForTime(now);
-
-        // Check for tasks
-        auto tasks = m_taskList->getDueTasks(now);
-
-        // Combine events and tasks into reminders
-        std::vector<std::string> reminders;
-
-        for (const auto &event : events)
+        // Valid YYYY-MM-DD at pos, standing alone as a word
+        bool isoDateAt(const std::string &input, std::size_t pos)
         {
-            reminders.push_back("Event: " + event.title + " is starting now.");
+            using utils::TimeUtils;
+            const std::size_t end = pos + TimeUtils::kIsoDateLength;
+            int days = 0;
+            return end <= input.size() && (pos == 0 || !isWordChar(input[pos - 1])) &&
+                   (end == input.size() || !isWordChar(input[end])) &&
+                   TimeUtils::parseIsoDate(std::string_view(input).substr(pos, TimeUtils::kIsoDateLength), days);
         }
 
-        for (const auto &task : tasks)
+        std::string outOfRangeReply()
         {
-            reminders.push_back("Task: " + task.description + " is due now.");
+            return "I can only keep track of dates between " + std::to_string(utils::TimeUtils::kMinYear) + " and " +
+                   std::to_string(utils::TimeUtils::kMaxYear) + ".";
         }
+    } // namespace
 
-        return reminders;
+    AISecretary::AISecretary(const std::string &dataDirectory)
+        : m_reminderScheduler(std::make_unique<ReminderScheduler>()),
+          m_calendar(std::make_unique<Calendar>(dataDirectory)),
+          m_taskList(std::make_unique<TaskList>(dataDirectory)),
+          m_memoryManager(nullptr)
+    {
+        m_calendar->setReminderScheduler(m_reminderScheduler.get());
+        m_taskList->setReminderScheduler(m_reminderScheduler.get());
     }
 
-    bool AISecretary::isSchedulingTask(const std::string &input)
-    {
-        std::string lowerInput = input;
-        std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(),
-                       [](unsigned char c)
-                       { return std::tolower(c); });
+    AISecretary::~AISecretary() = default;
 
-        return (lowerInput.find("schedule") != std::string::npos ||
-                lowerInput.find("meeting") != std::string::npos ||
-                lowerInput.find("appointment") != std::string::npos ||
-                lowerInput.find("event") != std::string::npos) &&
-               (lowerInput.find("tomorrow") != std::string::npos ||
-                lowerInput.find("today") != std::string::npos ||
-                lowerInput.find("next") != std::string::npos ||
-                std::regex_search(lowerInput, std::regex("\\b\\d{1,2}(:\\d{2})?\\s*(am|pm)\\b")) ||
-                std::regex_search(lowerInput, std::regex("\\b\\d{4}-\\d{2}-\\d{2}\\b")));
+    void AISecretary::setMemoryManager(models::MemoryManager *memoryManager)
+    {
+        m_memoryManager = memoryManager;
     }
 
-    bool AISecretary::isReminderTask(const std::string &input)
+    void AISecretary::setReminderHandler(ReminderScheduler::Handler handler)
     {
-        std::string lowerInput = input;
-        std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(),
-                       [](unsigned char c)
-                       { return std::tolower(c); });
+        m_reminderScheduler->setHandler(std::move(handler));
+    }
 
-        return (lowerInput.find("remind") != std::string::npos ||
-                lowerInput.find("remember") != std::string::npos ||
-                lowerInput.find("don't forget") != std::string::npos ||
-                lowerInput.find("task") != std::string::npos ||
-                lowerInput.find("to-do") != std::string::npos ||
-                lowerInput.find("todo") != std::string::npos);
+    IntentClassifier::Result AISecretary::classify(const std::string &input) const
+    {
+        auto result = m_classifier.classify(input);
+
+        // The classifier only knows a few date words; "meeting in 2 hours"
+        // or "appointment on Friday" need the full parser
+        bool schedulingWord = result.has(IntentClassifier::Schedule) || result.has(IntentClassifier::Meeting) ||
+                              result.has(IntentClassifier::Appointment) || result.has(IntentClassifier::Event);
+        if (result.intent != IntentClassifier::Intent::Scheduling && schedulingWord &&
+            TemporalParser::parse(input, std::chrono::system_clock::now()).found())
+        {
+            result.intent = IntentClassifier::Intent::Scheduling;
+        }
+        return result;
     }
 
-    bool AISecretary::isSummaryTask(const std::string &input)
+    std::string AISecretary::handleTask(const std::string &input, const IntentClassifier::Result &intent)
     {
-        std::string lowerInput = input;
-        std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(),
-                       [](unsigned char c)
-                       { return std::tolower(c); });
+        switch (intent.intent)
+        {
+        case IntentClassifier::Intent::Scheduling:
+            return handleScheduling(input, intent);
+        case IntentClassifier::Intent::Reminder:
+            return handleReminder(input, intent);
+        case IntentClassifier::Intent::Summary:
+            return handleSummary(input);
+        case IntentClassifier::Intent::None:
+            break;
+        }
 
-        return (lowerInput.find("summarize") != std::string::npos ||
-                lowerInput.find("summary") != std::string::npos) &&
-               (lowerInput.find("conversation") != std::string::npos ||
-                lowerInput.find("chat") != std::string::npos ||
-                lowerInput.find("discussion") != std::string::npos);
+        return "I'm not sure how to handle that task.";
     }
 
-    std::string AISecretary::handleScheduling(const std::string &input)
+    std::string AISecretary::handleScheduling(const std::string &input, const IntentClassifier::Result &intent)
     {
-        // Extract date, time, and event name from input
-        std::string date = extractDate(input);
-        std::string time = extractTime(input);
-        std::string eventName = extractEventName(input);
+        // Date, time and event name in one pass over the input
+        auto when = TemporalParser::parse(input, std::chrono::system_clock::now());
+        if (when.outOfRange)
+        {
+            return outOfRangeReply();
+        }
+        std::string eventName = extractEventName(input, intent, when);
 
         // Create event
         Calendar::Event event;
         event.title = eventName;
+        event.time = when.when;
 
-        // Parse date and time
-        std::tm tm = {};
-        std::stringstream ss;
-
-        if (!date.empty() && !time.empty())
+        auto firstTime = event.time;
+        std::string repeatLabel;
+        if (extractRecurrence(input, when, event.recurrence, repeatLabel))
         {
-            ss << date << " " << time;
-            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M");
-        }
-        else if (!date.empty())
-        {
-            ss << date << " 12:00"; // Default to noon
-            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M");
-        }
-        else
-        {
-            // Default to today
-            auto now = std::chrono::system_clock::now();
-            auto time_t = std::chrono::system_clock::to_time_t(now);
-            tm = *std::localtime(&time_t);
-
-            if (!time.empty())
+            // "every monday" said on a Sunday first happens tomorrow
+            if (auto first = Calendar::nextOccurrence(event, event.time))
             {
-                std::stringstream timeSs(time);
-                int hour, minute;
-                char colon;
-                timeSs >> hour >> colon >> minute;
-                tm.tm_hour = hour;
-                tm.tm_min = minute;
+                firstTime = *first;
             }
         }
 
-        event.time = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-
-        // Add event to calendar
+        // Check against what is already there before adding
+        auto conflicts = m_calendar->findConflicts(event);
         m_calendar->addEvent(event);
 
         // Format response
         std::stringstream response;
         response << "I've scheduled \"" << eventName << "\" for ";
-        response << std::put_time(&tm, "%B %d, %Y at %I:%M %p");
+        response << utils::TimeUtils::formatReadable(firstTime);
+        if (!repeatLabel.empty())
+        {
+            response << ", repeating " << repeatLabel;
+        }
         response << ". I'll remind you when it's time.";
 
-        return response.str();
-    }
-
-    std::string AISecretary::handleReminder(const std::string &input)
-    {
-        // Extract task description and due date/time
-        std::string date = extractDate(input);
-        std::string time = extractTime(input);
-
-        // The task description is everything except the date/time and reminder keywords
-        std::string taskDesc = input;
-
-        // Remove reminder keywords
-        std::vector<std::string> keywords = {"remind", "remember", "don't forget", "task", "to-do", "todo"};
-        for (const auto &keyword : keywords)
+        if (!conflicts.empty())
         {
-            size_t pos = taskDesc.find(keyword);
-            if (pos != std::string::npos)
+            // A few are enough to act on; a daily series can hit many
+            const std::size_t kListed = 3;
+            response << " Heads up, it overlaps with ";
+            for (std::size_t i = 0; i < std::min(conflicts.size(), kListed); i++)
             {
-                taskDesc.erase(pos, keyword.length());
+                response << (i == 0 ? "" : ", ") << "\"" << conflicts[i].title << "\" on "
+                         << utils::TimeUtils::formatReadable(conflicts[i].time, false);
             }
-        }
-
-        // Remove date and time if they exist
-        if (!date.empty())
-        {
-            size_t pos = taskDesc.find(date);
-            if (pos != std::string::npos)
+            if (conflicts.size() > kListed)
             {
-                taskDesc.erase(pos, date.length());
+                response << " and " << conflicts.size() - kListed << " more";
             }
+            response << ".";
         }
 
-        if (!time.empty())
+        return response.str();
+    }
+
+    std::string AISecretary::handleReminder(const std::string &input, const IntentClassifier::Result &intent)
+    {
+        // Due date/time; the description is everything except it and the reminder keywords
+        auto when = TemporalParser::parse(input, std::chrono::system_clock::now());
+        if (when.outOfRange)
         {
-            size_t pos = taskDesc.find(time);
-            if (pos != std::string::npos)
-            {
-                taskDesc.erase(pos, time.length());
-            }
+            return outOfRangeReply();
         }
-
-        // Clean up the task description
-        taskDesc = std::regex_replace(taskDesc, std::regex("\\s+"), " ");
-        taskDesc = std::regex_replace(taskDesc, std::regex("^\\s+|\\s+$"), "");
+        std::string taskDesc = removeSpans(input, intent,
+                                           {IntentClassifier::Remind, IntentClassifier::Remember,
+                                            IntentClassifier::DontForget, IntentClassifier::Task,
+                                            IntentClassifier::ToDoHyphen, IntentClassifier::ToDo},
+                                           when);
 
         // If task description is empty, use a generic one
         if (taskDesc.empty())
@@ -225,39 +226,7 @@ namespace tarius::ai_secretary
         TaskList::Task task;
         task.description = taskDesc;
 
-        // Parse date and time
-        std::tm tm = {};
-        std::stringstream ss;
-
-        if (!date.empty() && !time.empty())
-        {
-            ss << date << " " << time;
-            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M");
-        }
-        else if (!date.empty())
-        {
-            ss << date << " 12:00"; // Default to noon
-            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M");
-        }
-        else
-        {
-            // Default to today
-            auto now = std::chrono::system_clock::now();
-            auto time_t = std::chrono::system_clock::to_time_t(now);
-            tm = *std::localtime(&time_t);
-
-            if (!time.empty())
-            {
-                std::stringstream timeSs(time);
-                int hour, minute;
-                char colon;
-                timeSs >> hour >> colon >> minute;
-                tm.tm_hour = hour;
-                tm.tm_min = minute;
-            }
-        }
-
-        task.dueTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        task.dueTime = when.when;
 
         // Add task to task list
         m_taskList->addTask(task);
@@ -265,178 +234,184 @@ namespace tarius::ai_secretary
         // Format response
         std::stringstream response;
         response << "I'll remind you to \"" << taskDesc << "\" on ";
-        response << std::put_time(&tm, "%B %d, %Y at %I:%M %p");
+        response << utils::TimeUtils::formatReadable(task.dueTime);
 
         return response.str();
     }
 
     std::string AISecretary::handleSummary(const std::string &input)
     {
-        // For MVP, we'll just return a simple message
-        // In a full implementation, this would use the MemoryManager to retrieve and summarize conversations
+        if (!m_memoryManager)
+        {
+            return "I can't access our conversation history right now.";
+        }
 
-        return "I'm still learning how to summarize conversations. This feature will be available in a future update.";
+        std::string from, to, label;
+        if (!extractDateRange(input, from, to, label))
+        {
+            return "I couldn't work out which dates you want summarized.";
+        }
+
+        std::string summary = m_memoryManager->summarizeRange(from, to);
+        if (summary.empty())
+        {
+            return "I don't have any summarized conversations from " + label + ".";
+        }
+
+        return "Here's a summary of our conversations from " + label + ":\n" + summary;
     }
 
-    std::string AISecretary::extractDate(const std::string &input)
+    bool AISecretary::extractDateRange(const std::string &input, std::string &from, std::string &to, std::string &label)
     {
-        // Look for explicit date format (YYYY-MM-DD)
-        std::regex dateRegex("\\b(\\d{4}-\\d{2}-\\d{2})\\b");
-        std::smatch match;
-        if (std::regex_search(input, match, dateRegex))
+        using utils::TimeUtils;
+
+        // Explicit dates: one day, or a range between two
+        std::vector<std::string> dates;
+        for (std::size_t pos = 0; pos < input.size() && dates.size() < 2; pos++)
         {
-            return match[1];
+            if (isoDateAt(input, pos))
+            {
+                dates.push_back(input.substr(pos, TimeUtils::kIsoDateLength));
+            }
+        }
+        if (!dates.empty())
+        {
+            from = dates.front();
+            to = dates.size() > 1 ? dates[1] : dates.front();
+            if (from > to)
+            {
+                std::swap(from, to);
+            }
+            label = from == to ? from : from + " to " + to;
+            return true;
         }
 
-        // Look for relative dates
         std::string lowerInput = input;
         std::transform(lowerInput.begin(), lowerInput.end(), lowerInput.begin(),
                        [](unsigned char c)
                        { return std::tolower(c); });
 
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::tm tm = *std::localtime(&time_t);
+        // Day numbers, so "last month" and friends are plain arithmetic
+        const auto now = std::chrono::system_clock::now();
+        const int today = TimeUtils::dayOf(now);
+        int year, month, dayOfMonth;
+        TimeUtils::civilFromDays(today, year, month, dayOfMonth);
+        const int monday = today - TimeUtils::weekday(today);
+        const int lastDays = TemporalParser::parse(input, now).lastDays;
 
-        if (lowerInput.find("today") != std::string::npos)
+        if (lowerInput.find("yesterday") != std::string::npos)
         {
-            // Use today's date
+            from = to = TimeUtils::formatIsoDate(today - 1);
+            label = "yesterday";
         }
-        else if (lowerInput.find("tomorrow") != std::string::npos)
+        else if (lowerInput.find("today") != std::string::npos)
         {
-            // Add one day
-            tm.tm_mday += 1;
-            std::mktime(&tm); // Normalize the time
+            from = to = TimeUtils::formatIsoDate(today);
+            label = "today";
         }
-        else if (lowerInput.find("next week") != std::string::npos)
+        else if (lowerInput.find("last week") != std::string::npos)
         {
-            // Add one week
-            tm.tm_mday += 7;
-            std::mktime(&tm); // Normalize the time
+            from = TimeUtils::formatIsoDate(monday - 7);
+            to = TimeUtils::formatIsoDate(monday - 1);
+            label = "last week";
         }
-        else if (lowerInput.find("next month") != std::string::npos)
+        else if (lowerInput.find("this week") != std::string::npos)
         {
-            // Add one month
-            tm.tm_mon += 1;
-            std::mktime(&tm); // Normalize the time
+            from = TimeUtils::formatIsoDate(monday);
+            to = TimeUtils::formatIsoDate(today);
+            label = "this week";
         }
-        else
+        else if (lowerInput.find("last month") != std::string::npos)
         {
-            // No date found
-            return "";
+            const int firstOfMonth = today - (dayOfMonth - 1);
+            from = month == 1 ? TimeUtils::formatIsoDate(TimeUtils::daysFromCivil(year - 1, 12, 1))
+                              : TimeUtils::formatIsoDate(TimeUtils::daysFromCivil(year, month - 1, 1));
+            to = TimeUtils::formatIsoDate(firstOfMonth - 1);
+            label = "last month";
         }
-
-        // Format the date
-        std::stringstream ss;
-        ss << std::put_time(&tm, "%Y-%m-%d");
-        return ss.str();
-    }
-
-    std::string AISecretary::extractTime(const std::string &input)
-    {
-        // Look for time format (HH:MM)
-        std::regex timeRegex("\\b(\\d{1,2}:\\d{2})\\s*(am|pm)?\\b", std::regex_constants::icase);
-        std::smatch match;
-        if (std::regex_search(input, match, timeRegex))
+        else if (lowerInput.find("this month") != std::string::npos)
         {
-            std::string time = match[1];
-            std::string ampm = match[2];
-
-            // Parse the time
-            std::stringstream ss(time);
-            int hour, minute;
-            char colon;
-            ss >> hour >> colon >> minute;
-
-            // Adjust for AM/PM
-            if (!ampm.empty())
-            {
-                std::transform(ampm.begin(), ampm.end(), ampm.begin(),
-                               [](unsigned char c)
-                               { return std::tolower(c); });
-
-                if (ampm == "pm" && hour < 12)
-                {
-                    hour += 12;
-                }
-                else if (ampm == "am" && hour == 12)
-                {
-                    hour = 0;
-                }
-            }
-
-            // Format the time
-            std::stringstream result;
-            result << std::setw(2) << std::setfill('0') << hour << ":"
-                   << std::setw(2) << std::setfill('0') << minute;
-            return result.str();
+            from = TimeUtils::formatIsoDate(today - (dayOfMonth - 1));
+            to = TimeUtils::formatIsoDate(today);
+            label = "this month";
+        }
+        else if (lastDays > 0)
+        {
+            from = TimeUtils::formatIsoDate(today + 1 - lastDays);
+            to = TimeUtils::formatIsoDate(today);
+            label = "the last " + std::to_string(lastDays) + " days";
+        }
+        else
+        {
+            // No period given: the last seven days
+            from = TimeUtils::formatIsoDate(today - 6);
+            to = TimeUtils::formatIsoDate(today);
+            label = "the last seven days";
         }
 
-        return "";
+        return true;
     }
 
-    std::string AISecretary::extractEventName(const std::string &input)
+    std::string AISecretary::extractEventName(const std::string &input, const IntentClassifier::Result &intent,
+                                              const TemporalParser::Result &when)
     {
-        // For MVP, we'll use a simple approach
-        // Remove scheduling keywords, date, and time to get the event name
-
-        std::string eventName = input;
+        // Blank out a repetition such as "every other week" or "every monday and friday",
+        // keeping offsets so the spans found earlier still line up
+        std::string masked = input;
+        const auto &repetition = when.repetition.span;
+        std::fill(masked.begin() + repetition.begin, masked.begin() + repetition.end, ' ');
+
+        // Remove scheduling keywords and the date and time
+        std::string eventName = removeSpans(masked, intent,
+                                            {IntentClassifier::Schedule, IntentClassifier::Meeting,
+                                             IntentClassifier::Appointment, IntentClassifier::Event},
+                                            when);
 
-        // Remove scheduling keywords
-        std::vector<std::string> keywords = {"schedule", "meeting", "appointment", "event"};
-        for (const auto &keyword : keywords)
+        // If event name is empty, use a generic one
+        if (eventName.empty())
         {
-            size_t pos = eventName.find(keyword);
-            if (pos != std::string::npos)
-            {
-                eventName.erase(pos, keyword.length());
-            }
+            eventName = "Unnamed event";
         }
 
-        // Remove date and time
-        std::string date = extractDate(input);
-        std::string time = extractTime(input);
+        return eventName;
+    }
 
-        if (!date.empty())
-        {
-            size_t pos = eventName.find(date);
-            if (pos != std::string::npos)
-            {
-                eventName.erase(pos, date.length());
-            }
-        }
+    bool AISecretary::extractRecurrence(const std::string &input, const TemporalParser::Result &when,
+                                        Calendar::Recurrence &recurrence, std::string &label)
+    {
+        using Frequency = TemporalParser::Repetition::Frequency;
 
-        if (!time.empty())
+        const auto &repetition = when.repetition;
+        switch (repetition.frequency)
         {
-            size_t pos = eventName.find(time);
-            if (pos != std::string::npos)
-            {
-                eventName.erase(pos, time.length());
-            }
+        case Frequency::None:
+            return false;
+        case Frequency::Daily:
+            recurrence.frequency = Calendar::Recurrence::Frequency::Daily;
+            break;
+        case Frequency::Weekly:
+            recurrence.frequency = Calendar::Recurrence::Frequency::Weekly;
+            break;
+        case Frequency::Monthly:
+            recurrence.frequency = Calendar::Recurrence::Frequency::Monthly;
+            break;
         }
+        recurrence.interval = repetition.interval;
+        recurrence.byDay = repetition.days;
 
-        // Remove common time-related words
-        std::vector<std::string> timeWords = {"today", "tomorrow", "next week", "next month", "am", "pm"};
-        for (const auto &word : timeWords)
+        // Echo the phrase as written: "daily", "every other week", "every monday and friday"
+        if (repetition.days == 0x1f && repetition.interval == 1)
         {
-            size_t pos = eventName.find(word);
-            if (pos != std::string::npos)
-            {
-                eventName.erase(pos, word.length());
-            }
+            label = "every weekday";
         }
-
-        // Clean up the event name
-        eventName = std::regex_replace(eventName, std::regex("\\s+"), " ");
-        eventName = std::regex_replace(eventName, std::regex("^\\s+|\\s+$"), "");
-
-        // If event name is empty, use a generic one
-        if (eventName.empty())
+        else
         {
-            eventName = "Unnamed event";
+            label = input.substr(repetition.span.begin, repetition.span.size());
+            std::transform(label.begin(), label.end(), label.begin(),
+                           [](unsigned char c)
+                           { return std::tolower(c); });
         }
-
-        return eventName;
+        return true;
     }
 
 } // namespace tarius::ai_secretary
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "calendar.h"
+#include "intent_classifier.h"
+#include "reminder_scheduler.h"
 #include "task_list.h"
+#include "temporal_parser.h"
+#include "../models/memory_manager.h"
 #include <string>
-#include <vector>
 #include <memory>
 
 namespace tarius::ai_secretary
@@ -12,31 +15,39 @@ namespace tarius::ai_secretary
     class AISecretary
     {
     public:
-        AISecretary();
+        // Calendar and tasks are stored under dataDirectory
+        explicit AISecretary(const std::string &dataDirectory = "data");
         ~AISecretary();
 
-        bool isSecretaryTask(const std::string &input);
-        std::string handleTask(const std::string &input);
-        std::vector<std::string> getActiveReminders();
+        // Intent None means the input is not a secretary task
+        IntentClassifier::Result classify(const std::string &input) const;
+        std::string handleTask(const std::string &input, const IntentClassifier::Result &intent);
+
+        // Called from the scheduler thread as each event starts or task falls due
+        void setReminderHandler(ReminderScheduler::Handler handler);
+
+        // Conversation history used for summary requests; not owned
+        void setMemoryManager(models::MemoryManager *memoryManager);
 
     private:
+        // Declared first so it outlives the calendar and task list feeding it
+        std::unique_ptr<ReminderScheduler> m_reminderScheduler;
         std::unique_ptr<Calendar> m_calendar;
         std::unique_ptr<TaskList> m_taskList;
-
-        // Task detection and handling
-        bool isSchedulingTask(const std::string &input);
-        bool isReminderTask(const std::string &input);
-        bool isSummaryTask(const std::string &input);
+        models::MemoryManager *m_memoryManager;
+        IntentClassifier m_classifier;
 
         // Task execution
-        std::string handleScheduling(const std::string &input);
-        std::string handleReminder(const std::string &input);
+        std::string handleScheduling(const std::string &input, const IntentClassifier::Result &intent);
+        std::string handleReminder(const std::string &input, const IntentClassifier::Result &intent);
         std::string handleSummary(const std::string &input);
 
         // Helper methods
-        std::string extractDate(const std::string &input);
-        std::string extractTime(const std::string &input);
-        std::string extractEventName(const std::string &input);
+        std::string extractEventName(const std::string &input, const IntentClassifier::Result &intent,
+                                     const TemporalParser::Result &when);
+        bool extractRecurrence(const std::string &input, const TemporalParser::Result &when,
+                               Calendar::Recurrence &recurrence, std::string &label);
+        bool extractDateRange(const std::string &input, std::string &from, std::string &to, std::string &label);
     };
 
 } // namespace tarius::ai_secretary
\ No newline at end of file
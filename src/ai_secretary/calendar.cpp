@@ -1,45 +1,462 @@
 #include "calendar.h"
+#include "reminder_scheduler.h"
 #include "../utils/logger.h"
-#include <fstream>
+#include "../utils/tracer.h"
+#include "../utils/op_log.h"
+#include "../utils/time_utils.h"
+#include <algorithm>
 #include <nlohmann/json.hpp>
-#include <filesystem>
-#include <iomanip>
-#include <sstream>
 
-namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 namespace tarius::ai_secretary
 {
+    namespace
+    {
+        using TimePoint = std::chrono::system_clock::time_point;
+
+        // How far ahead nextOccurrence looks before giving up on a series
+        constexpr std::chrono::hours kOccurrenceHorizon(24 * 366 * 10);
+
+        // How far ahead a recurring event is checked for conflicts
+        constexpr std::chrono::hours kConflictHorizon(24 * 90);
+
+        // Logged changes after which the whole calendar is snapshotted again,
+        // or as many as it has entries if that is more, so the snapshot's
+        // cost spread over the changes stays the same as the calendar grows
+        constexpr std::size_t kSnapshotInterval = 256;
+
+        const char *const kWeekdayCodes[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+
+        int floorDiv(int a, int b)
+        {
+            return a / b - (a % b != 0 && (a < 0) != (b < 0));
+        }
+
+        int bitCount(unsigned bits)
+        {
+            int n = 0;
+            for (; bits; bits &= bits - 1)
+            {
+                n++;
+            }
+            return n;
+        }
+
+        struct LocalTime
+        {
+            int day; // Local civil day since 1970-01-01
+            int hour;
+            int minute;
+        };
+
+        LocalTime toLocal(const TimePoint &time)
+        {
+            utils::CivilTime civil = utils::TimeZone::local().toCivil(time);
+            return {utils::TimeUtils::daysFromCivil(civil.year, civil.month, civil.day), civil.hour, civil.minute};
+        }
+
+        TimePoint fromLocal(int day, int hour, int minute)
+        {
+            utils::CivilTime civil;
+            utils::TimeUtils::civilFromDays(day, civil.year, civil.month, civil.day);
+            civil.hour = hour;
+            civil.minute = minute;
+            return utils::TimeZone::local().fromCivil(civil);
+        }
+
+        std::string formatTime(const TimePoint &time)
+        {
+            return utils::TimeUtils::formatIsoDateTime(time);
+        }
+
+        TimePoint parseTime(const std::string &text)
+        {
+            TimePoint time{};
+            utils::TimeUtils::parseIsoDateTime(text, time);
+            return time;
+        }
+
+        json recurrenceToJson(const Calendar::Recurrence &rule)
+        {
+            using Frequency = Calendar::Recurrence::Frequency;
+            json j;
+            j["frequency"] = rule.frequency == Frequency::Daily    ? "daily"
+                             : rule.frequency == Frequency::Weekly ? "weekly"
+                                                                   : "monthly";
+            j["interval"] = rule.interval;
+            json byDay = json::array();
+            for (int d = 0; d < 7; d++)
+            {
+                if (rule.byDay & (1 << d))
+                {
+                    byDay.push_back(kWeekdayCodes[d]);
+                }
+            }
+            j["byDay"] = byDay;
+            j["count"] = rule.count;
+            if (rule.until)
+            {
+                j["until"] = formatTime(*rule.until);
+            }
+            json exceptions = json::array();
+            for (const auto &exception : rule.exceptions)
+            {
+                exceptions.push_back(formatTime(exception));
+            }
+            j["exceptions"] = exceptions;
+            return j;
+        }
 
-    Calendar::Calendar()
-        : m_calendarFilePath("data/calendar/events.json")
+        Calendar::Recurrence recurrenceFromJson(const json &j)
+        {
+            using Frequency = Calendar::Recurrence::Frequency;
+            Calendar::Recurrence rule;
+            std::string frequency = j.at("frequency").get<std::string>();
+            rule.frequency = frequency == "daily"    ? Frequency::Daily
+                             : frequency == "weekly" ? Frequency::Weekly
+                                                     : Frequency::Monthly;
+            rule.interval = std::max(1, j.value("interval", 1));
+            for (const auto &code : j.value("byDay", json::array()))
+            {
+                for (int d = 0; d < 7; d++)
+                {
+                    if (code == kWeekdayCodes[d])
+                    {
+                        rule.byDay |= 1 << d;
+                    }
+                }
+            }
+            rule.count = j.value("count", 0);
+            if (j.contains("until"))
+            {
+                rule.until = parseTime(j["until"].get<std::string>());
+            }
+            for (const auto &exception : j.value("exceptions", json::array()))
+            {
+                rule.exceptions.push_back(parseTime(exception.get<std::string>()));
+            }
+            return rule;
+        }
+
+        json eventToJson(const Calendar::Event &event)
+        {
+            json eventJson;
+            eventJson["title"] = event.title;
+            eventJson["description"] = event.description;
+            eventJson["isAllDay"] = event.isAllDay;
+            eventJson["durationMinutes"] = event.duration.count();
+            eventJson["time"] = formatTime(event.time);
+            if (event.isRecurring())
+            {
+                eventJson["recurrence"] = recurrenceToJson(event.recurrence);
+            }
+            return eventJson;
+        }
+
+        Calendar::Event eventFromJson(const json &eventJson)
+        {
+            Calendar::Event event;
+            event.title = eventJson["title"];
+            event.description = eventJson["description"];
+            event.isAllDay = eventJson["isAllDay"];
+            event.duration = std::chrono::minutes(eventJson.value("durationMinutes", 0));
+            event.time = parseTime(eventJson["time"].get<std::string>());
+            if (eventJson.contains("recurrence"))
+            {
+                event.recurrence = recurrenceFromJson(eventJson["recurrence"]);
+            }
+            return event;
+        }
+    } // namespace
+
+    Calendar::Calendar(const std::string &dataDirectory)
+        : m_calendarFilePath(dataDirectory + "/calendar/events.json"),
+          m_opLog(std::make_unique<utils::OpLog>(m_calendarFilePath, dataDirectory + "/calendar/events.log")),
+          m_scheduler(nullptr)
     {
         loadEvents();
     }
 
     Calendar::~Calendar()
     {
-        saveEvents();
+        // Fold the log into the snapshot so the next start replays nothing
+        if (m_opLog->pendingOps() > 0)
+        {
+            saveEvents();
+        }
     }
 
     void Calendar::addEvent(const Event &event)
     {
-        m_events.push_back(event);
-        saveEvents();
+        Event stored = event;
+        stored.time = floorToMinute(stored.time);
+
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        {
+            std::unique_lock<std::shared_mutex> eventsLock(m_eventsMutex);
+            insertEvent(m_events, stored);
+        }
+
+        scheduleReminder(stored);
+        logOperation({{"op", "add"}, {"event", eventToJson(stored)}}, m_events);
         LOG_INFO("Added event: {}", event.title);
     }
 
-    void Calendar::removeEvent(const std::string &title)
+    void Calendar::insertEvent(Events &events, Event event)
+    {
+        event.time = floorToMinute(event.time);
+        if (event.isRecurring())
+        {
+            events.series.push_back(std::move(event));
+            return;
+        }
+
+        events.longestEvent = std::max(events.longestEvent,
+                                       std::chrono::duration_cast<std::chrono::minutes>(endOf(event) - event.time));
+
+        // A multimap inserts after any events starting in the same minute
+        auto start = event.time;
+        auto it = events.single.emplace(start, std::move(event));
+        events.singleByTitle[it->second.title].push_back(it);
+    }
+
+    void Calendar::setReminderScheduler(ReminderScheduler *scheduler)
     {
-        auto it = std::remove_if(m_events.begin(), m_events.end(),
-                                 [&title](const Event &event)
-                                 { return event.title == title; });
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_scheduler = scheduler;
 
-        if (it != m_events.end())
+        // Events that started earlier this minute still get their reminder
+        auto now = floorToMinute(std::chrono::system_clock::now());
+        for (auto it = m_events.single.lower_bound(now); it != m_events.single.end(); ++it)
         {
-            m_events.erase(it, m_events.end());
-            saveEvents();
+            scheduleReminder(it->second);
+        }
+        for (const auto &series : m_events.series)
+        {
+            scheduleReminder(series);
+        }
+    }
+
+    void Calendar::scheduleReminder(const Event &event)
+    {
+        if (!m_scheduler)
+        {
+            return;
+        }
+
+        // A series is only ever scheduled as its next occurrence
+        auto due = nextOccurrence(event, floorToMinute(std::chrono::system_clock::now()));
+        if (!due)
+        {
+            return;
+        }
+
+        ReminderScheduler::Next next;
+        if (event.isRecurring())
+        {
+            next = [event](TimePoint fired)
+            { return nextOccurrence(event, fired + std::chrono::minutes(1)); };
+        }
+        m_scheduler->schedule("event:" + event.title, *due, "Event: " + event.title + " is starting now.",
+                              std::move(next));
+    }
+
+    void Calendar::rescheduleReminders(const Events &events, const std::string &title)
+    {
+        if (!m_scheduler)
+        {
+            return;
+        }
+
+        m_scheduler->cancel("event:" + title);
+        auto now = floorToMinute(std::chrono::system_clock::now());
+        auto sameTitle = events.singleByTitle.find(title);
+        if (sameTitle != events.singleByTitle.end())
+        {
+            for (const auto &it : sameTitle->second)
+            {
+                if (it->first >= now)
+                {
+                    scheduleReminder(it->second);
+                }
+            }
+        }
+        for (const auto &series : events.series)
+        {
+            if (series.title == title)
+            {
+                scheduleReminder(series);
+            }
+        }
+    }
+
+    std::optional<TimePoint> Calendar::nextOccurrence(const Event &event, const TimePoint &after)
+    {
+        std::optional<TimePoint> next;
+        expand(event, after, after + kOccurrenceHorizon, [&next](const TimePoint &start)
+               {
+            next = start;
+            return false; });
+        return next;
+    }
+
+    void Calendar::expand(const Event &event, const TimePoint &from, const TimePoint &to,
+                          const std::function<bool(const TimePoint &)> &visit)
+    {
+        using Frequency = Recurrence::Frequency;
+        const Recurrence &rule = event.recurrence;
+        if (from >= to)
+        {
+            return;
+        }
+        if (!event.isRecurring())
+        {
+            if (event.time >= from && event.time < to)
+            {
+                visit(event.time);
+            }
+            return;
+        }
+
+        const int interval = std::max(1, rule.interval);
+        const LocalTime start = toLocal(event.time);
+
+        // Occurrences fall on whole local days, so a day either side of the
+        // window covers any UTC offset
+        const int firstDay = toLocal(from).day - 1;
+        const int lastDay = toLocal(to).day + 1;
+
+        // Occurrences so far, including skipped ones, for rule.count
+        int index = 0;
+
+        // Returns false once the series or the window is exhausted
+        auto emit = [&](int day)
+        {
+            if (rule.count > 0 && index >= rule.count)
+            {
+                return false;
+            }
+            index++;
+            if (day < firstDay)
+            {
+                return true;
+            }
+
+            TimePoint time = fromLocal(day, start.hour, start.minute);
+            if ((rule.until && time > *rule.until) || time >= to)
+            {
+                return false;
+            }
+            if (time < from || std::find(rule.exceptions.begin(), rule.exceptions.end(), time) != rule.exceptions.end())
+            {
+                return true;
+            }
+            return visit(time);
+        };
+
+        if (rule.frequency == Frequency::Daily)
+        {
+            // Jump straight to the period containing the window
+            int k = std::max(0, floorDiv(firstDay - start.day, interval));
+            index = k;
+            for (;; k++)
+            {
+                int day = start.day + k * interval;
+                if (day > lastDay || !emit(day))
+                {
+                    return;
+                }
+            }
+        }
+        else if (rule.frequency == Frequency::Weekly)
+        {
+            const int startWeekday = utils::TimeUtils::weekday(start.day);
+            const unsigned mask = (rule.byDay & 0x7f) ? (rule.byDay & 0x7f) : (1u << startWeekday);
+            const int monday = start.day - startWeekday;
+            const int firstWeekCount = bitCount(mask >> startWeekday);
+
+            int k = std::max(0, floorDiv(firstDay - monday, 7 * interval));
+            index = k == 0 ? 0 : firstWeekCount + (k - 1) * bitCount(mask);
+            for (;; k++)
+            {
+                int week = monday + 7 * interval * k;
+                if (week > lastDay)
+                {
+                    return;
+                }
+                for (int d = 0; d < 7; d++)
+                {
+                    if ((mask & (1u << d)) && week + d >= start.day && !emit(week + d))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+        else
+        {
+            int y, m, d;
+            utils::TimeUtils::civilFromDays(start.day, y, m, d);
+            for (int k = 0;; k++)
+            {
+                int months = (m - 1) + k * interval;
+                int year = y + months / 12;
+                int month = months % 12 + 1;
+                int first = utils::TimeUtils::daysFromCivil(year, month, 1);
+                if (first > lastDay)
+                {
+                    return;
+                }
+
+                int daysInMonth = (month == 12 ? utils::TimeUtils::daysFromCivil(year + 1, 1, 1)
+                                               : utils::TimeUtils::daysFromCivil(year, month + 1, 1)) -
+                                  first;
+                if (d <= daysInMonth && !emit(first + d - 1))
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    std::chrono::system_clock::time_point Calendar::floorToMinute(const std::chrono::system_clock::time_point &time)
+    {
+        // Time zone offsets are whole minutes, so this matches local rounding
+        auto sinceEpoch = time.time_since_epoch();
+        auto minutes = std::chrono::duration_cast<std::chrono::minutes>(sinceEpoch);
+        if (minutes > sinceEpoch)
+        {
+            minutes -= std::chrono::minutes(1);
+        }
+        return std::chrono::system_clock::time_point(minutes);
+    }
+
+    std::chrono::system_clock::time_point Calendar::endOf(const Event &event)
+    {
+        if (event.duration > std::chrono::minutes(0))
+        {
+            return event.time + event.duration;
+        }
+        // Point events occupy their minute; all-day events without a duration their day
+        return event.time + (event.isAllDay ? std::chrono::minutes(24 * 60) : std::chrono::minutes(1));
+    }
+
+    void Calendar::removeEvent(const std::string &title)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        bool erased;
+        {
+            std::unique_lock<std::shared_mutex> eventsLock(m_eventsMutex);
+            erased = eraseEvents(m_events, title);
+        }
+        if (erased)
+        {
+            if (m_scheduler)
+            {
+                m_scheduler->cancel("event:" + title);
+            }
+            logOperation({{"op", "remove"}, {"title", title}}, m_events);
             LOG_INFO("Removed event: {}", title);
         }
         else
@@ -48,153 +465,379 @@ namespace tarius::ai_secretary
         }
     }
 
-    std::vector<Calendar::Event> Calendar::getEvents(const std::string &date)
+    bool Calendar::eraseEvents(Events &events, const std::string &title)
     {
-        std::vector<Event> events;
+        bool found = false;
+        auto sameTitle = events.singleByTitle.find(title);
+        if (sameTitle != events.singleByTitle.end())
+        {
+            for (const auto &it : sameTitle->second)
+            {
+                events.single.erase(it);
+            }
+            events.singleByTitle.erase(sameTitle);
+            found = true;
+        }
 
-        // Parse the date string
-        std::tm tm = {};
-        std::stringstream ss(date);
-        ss >> std::get_time(&tm, "%Y-%m-%d");
-        auto targetDate = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        auto seriesIt = std::remove_if(events.series.begin(), events.series.end(), [&title](const Event &event)
+                                       { return event.title == title; });
+        found = found || seriesIt != events.series.end();
+        events.series.erase(seriesIt, events.series.end());
+        return found;
+    }
 
-        // Get the start and end of the target date
-        tm.tm_hour = 0;
-        tm.tm_min = 0;
-        tm.tm_sec = 0;
-        auto startOfDay = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    std::vector<Calendar::Event> Calendar::getEvents(const std::string &date) const
+    {
+        int day;
+        if (!utils::TimeUtils::parseIsoDate(date, day))
+        {
+            return {};
+        }
 
-        tm.tm_hour = 23;
-        tm.tm_min = 59;
-        tm.tm_sec = 59;
-        auto endOfDay = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        // Local midnight to the next local midnight, whatever the day's length
+        return getEventsInRange(utils::TimeUtils::startOfDay(day), utils::TimeUtils::startOfDay(day + 1));
+    }
 
-        // Find events on the target date
-        for (const auto &event : m_events)
+    bool Calendar::skipOccurrence(const std::string &title, const TimePoint &occurrence)
+    {
+        auto start = floorToMinute(occurrence);
+
+        std::lock_guard<std::mutex> lock(m_writeMutex);
         {
-            if (event.time >= startOfDay && event.time <= endOfDay)
+            std::unique_lock<std::shared_mutex> eventsLock(m_eventsMutex);
+            if (!addException(m_events, title, start))
             {
-                events.push_back(event);
+                LOG_WARN("No occurrence of {} to skip", title);
+                return false;
             }
         }
 
-        return events;
+        rescheduleReminders(m_events, title);
+        logOperation({{"op", "skip"}, {"title", title}, {"time", formatTime(start)}}, m_events);
+        LOG_INFO("Skipped occurrence of {}", title);
+        return true;
     }
 
-    std::vector<Calendar::Event> Calendar::getEventsForTime(const std::chrono::system_clock::time_point &time)
+    bool Calendar::addException(Events &events, const std::string &title, const TimePoint &start)
     {
-        std::vector<Event> events;
+        for (auto &series : events.series)
+        {
+            if (series.title == title && nextOccurrence(series, start) == start)
+            {
+                series.recurrence.exceptions.push_back(start);
+                return true;
+            }
+        }
+        return false;
+    }
 
-        // Convert time to time_t for easier comparison
-        auto timeT = std::chrono::system_clock::to_time_t(time);
-        std::tm tm = *std::localtime(&timeT);
+    std::vector<Calendar::Event> Calendar::getEventsForTime(const std::chrono::system_clock::time_point &time) const
+    {
+        auto minute = floorToMinute(time);
+        std::shared_lock<std::shared_mutex> lock(m_eventsMutex);
+        auto [first, last] = m_events.single.equal_range(minute);
 
-        // Round to the nearest minute
-        tm.tm_sec = 0;
-        auto roundedTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        std::vector<Event> events;
+        for (auto it = first; it != last; ++it)
+        {
+            events.push_back(it->second);
+        }
+        for (const auto &series : m_events.series)
+        {
+            expand(series, minute, minute + std::chrono::minutes(1), [&](const TimePoint &start)
+                   {
+                events.push_back(series);
+                events.back().time = start;
+                return true; });
+        }
+        return events;
+    }
 
-        // Find events that match the current time (within a minute)
-        for (const auto &event : m_events)
+    void Calendar::visitRange(const Events &events, const TimePoint &from, const TimePoint &to,
+                              const std::function<void(const Event &, const TimePoint &)> &visit)
+    {
+        if (from >= to)
         {
-            auto eventTimeT = std::chrono::system_clock::to_time_t(event.time);
-            std::tm eventTm = *std::localtime(&eventTimeT);
-            eventTm.tm_sec = 0;
-            auto roundedEventTime = std::chrono::system_clock::from_time_t(std::mktime(&eventTm));
+            return;
+        }
 
-            if (roundedEventTime == roundedTime)
+        // Only events starting within the longest event's length before from
+        // can still be running at from
+        for (auto it = events.single.lower_bound(from - events.longestEvent);
+             it != events.single.end() && it->first < to; ++it)
+        {
+            if (endOf(it->second) > from)
             {
-                events.push_back(event);
+                visit(it->second, it->first);
             }
         }
 
+        // Occurrences starting up to one event length before from still overlap
+        for (const auto &series : events.series)
+        {
+            auto length = endOf(series) - series.time;
+            expand(series, from - length, to, [&](const TimePoint &start)
+                   {
+                if (start + length > from)
+                {
+                    visit(series, start);
+                }
+                return true; });
+        }
+    }
+
+    std::vector<Calendar::Event> Calendar::getEventsInRange(const std::chrono::system_clock::time_point &from,
+                                                            const std::chrono::system_clock::time_point &to) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_eventsMutex);
+        std::vector<Event> events;
+        visitRange(m_events, from, to, [&events](const Event &event, const TimePoint &start)
+                   {
+            events.push_back(event);
+            events.back().time = start; });
+
+        if (!m_events.series.empty())
+        {
+            std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+                             { return a.time < b.time; });
+        }
         return events;
     }
 
-    void Calendar::saveEvents()
+    bool Calendar::takesTime(const Event &event)
     {
-        // Create directory if it doesn't exist
-        fs::create_directories("data/calendar");
+        return !event.isAllDay || event.duration > std::chrono::minutes(0);
+    }
 
-        // Create JSON array
-        json eventsJson = json::array();
+    std::vector<Calendar::Interval> Calendar::getBusy(const TimePoint &from, const TimePoint &to) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_eventsMutex);
+        std::vector<Interval> taken;
+        visitRange(m_events, from, to, [&](const Event &event, const TimePoint &start)
+                   {
+            if (takesTime(event))
+            {
+                taken.push_back({std::max(start, from), std::min(start + (endOf(event) - event.time), to)});
+            } });
 
-        for (const auto &event : m_events)
+        bool anySeries = !m_events.series.empty();
+        lock.unlock();
+
+        if (anySeries)
         {
-            json eventJson;
-            eventJson["title"] = event.title;
-            eventJson["description"] = event.description;
-            eventJson["isAllDay"] = event.isAllDay;
+            std::sort(taken.begin(), taken.end(), [](const Interval &a, const Interval &b)
+                      { return a.start < b.start; });
+        }
+
+        // Sweep in order of start, merging whatever touches or overlaps
+        std::vector<Interval> busy;
+        for (const auto &interval : taken)
+        {
+            if (!busy.empty() && interval.start <= busy.back().end)
+            {
+                busy.back().end = std::max(busy.back().end, interval.end);
+            }
+            else
+            {
+                busy.push_back(interval);
+            }
+        }
+        return busy;
+    }
 
-            // Convert time to ISO string
-            auto time_t = std::chrono::system_clock::to_time_t(event.time);
-            std::stringstream ss;
-            ss << std::put_time(std::localtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-            eventJson["time"] = ss.str();
+    std::vector<Calendar::Interval> Calendar::findFreeSlots(const TimePoint &from, const TimePoint &to,
+                                                            std::chrono::minutes minLength) const
+    {
+        return findFreeSlots(from, to, minLength, WorkingHours());
+    }
+
+    std::vector<Calendar::Interval> Calendar::findFreeSlots(const TimePoint &from, const TimePoint &to,
+                                                            std::chrono::minutes minLength,
+                                                            const WorkingHours &hours) const
+    {
+        std::vector<Interval> free;
+        if (from >= to || hours.start >= hours.end)
+        {
+            return free;
+        }
+
+        auto busy = getBusy(from, to);
+        auto next = busy.begin();
+        int lastDay = toLocal(to - std::chrono::seconds(1)).day;
+        for (int day = toLocal(from).day; day <= lastDay; day++)
+        {
+            if (!(hours.days & (1 << utils::TimeUtils::weekday(day))))
+            {
+                continue;
+            }
+
+            auto start = std::max(from, fromLocal(day, 0, static_cast<int>(hours.start.count())));
+            auto end = std::min(to, fromLocal(day, 0, static_cast<int>(hours.end.count())));
+            if (start >= end)
+            {
+                continue;
+            }
+
+            // Busy intervals are in order, so each day picks up where the last one stopped
+            while (next != busy.end() && next->end <= start)
+            {
+                ++next;
+            }
+
+            auto cursor = start;
+            for (auto it = next; it != busy.end() && it->start < end; ++it)
+            {
+                if (it->start - cursor >= minLength)
+                {
+                    free.push_back({cursor, it->start});
+                }
+                cursor = std::max(cursor, it->end);
+            }
+            if (end - cursor >= minLength)
+            {
+                free.push_back({cursor, end});
+            }
+        }
+        return free;
+    }
 
-            eventsJson.push_back(eventJson);
+    std::vector<Calendar::Event> Calendar::findConflicts(const Event &event) const
+    {
+        std::vector<Event> conflicts;
+        if (!takesTime(event))
+        {
+            return conflicts;
         }
 
-        // Write to file
-        std::ofstream file(m_calendarFilePath);
-        if (file.is_open())
+        Event candidate = event;
+        candidate.time = floorToMinute(event.time);
+        auto length = endOf(candidate) - candidate.time;
+
+        std::shared_lock<std::shared_mutex> lock(m_eventsMutex);
+        auto check = [&](const TimePoint &start)
         {
-            file << eventsJson.dump(4);
-            file.close();
-            LOG_INFO("Saved {} events to calendar", m_events.size());
+            visitRange(m_events, start, start + length, [&](const Event &other, const TimePoint &otherStart)
+                       {
+                if (takesTime(other))
+                {
+                    conflicts.push_back(other);
+                    conflicts.back().time = otherStart;
+                } });
+            return true;
+        };
+
+        if (candidate.isRecurring())
+        {
+            expand(candidate, candidate.time, candidate.time + kConflictHorizon, check);
         }
         else
         {
-            LOG_ERROR("Failed to open calendar file for writing: {}", m_calendarFilePath);
+            check(candidate.time);
         }
+
+        std::stable_sort(conflicts.begin(), conflicts.end(), [](const Event &a, const Event &b)
+                         { return a.time < b.time; });
+        return conflicts;
     }
 
-    void Calendar::loadEvents()
+    void Calendar::saveEvents()
     {
-        // Clear existing events
-        m_events.clear();
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        writeSnapshot(m_events);
+    }
 
-        // Check if file exists
-        if (!fs::exists(m_calendarFilePath))
+    void Calendar::writeSnapshot(const Events &events)
+    {
+        TRACE_SCOPE("calendar.snapshot");
+        json eventsJson = json::array();
+        for (const auto &[start, event] : events.single)
         {
-            LOG_INFO("Calendar file does not exist, starting with empty calendar");
-            return;
+            eventsJson.push_back(eventToJson(event));
+        }
+        for (const auto &series : events.series)
+        {
+            eventsJson.push_back(eventToJson(series));
         }
 
-        // Read file
-        std::ifstream file(m_calendarFilePath);
-        if (!file.is_open())
+        if (m_opLog->writeSnapshot(eventsJson))
+        {
+            LOG_INFO("Saved {} events to calendar", eventsJson.size());
+        }
+        else
         {
-            LOG_ERROR("Failed to open calendar file for reading: {}", m_calendarFilePath);
+            LOG_ERROR("Failed to write calendar snapshot: {}", m_calendarFilePath);
+        }
+    }
+
+    void Calendar::loadEvents()
+    {
+        TRACE_SCOPE("calendar.load");
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        Events events;
+        // Swapped in whole; map iterators stay valid across a swap
+        auto install = [this, &events]()
+        {
+            std::unique_lock<std::shared_mutex> eventsLock(m_eventsMutex);
+            std::swap(m_events, events);
+        };
+
+        json eventsJson;
+        std::vector<json> ops;
+        if (!m_opLog->load(eventsJson, ops))
+        {
+            LOG_ERROR("Failed to read calendar file: {}", m_calendarFilePath);
+            install();
             return;
         }
 
         try
         {
-            json eventsJson = json::parse(file);
-            file.close();
-
-            for (const auto &eventJson : eventsJson)
+            if (eventsJson.is_array())
             {
-                Event event;
-                event.title = eventJson["title"];
-                event.description = eventJson["description"];
-                event.isAllDay = eventJson["isAllDay"];
-
-                // Parse time
-                std::tm tm = {};
-                std::stringstream ss(eventJson["time"].get<std::string>());
-                ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-                event.time = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+                for (const auto &eventJson : eventsJson)
+                {
+                    insertEvent(events, eventFromJson(eventJson));
+                }
+            }
 
-                m_events.push_back(event);
+            // Changes made since the snapshot
+            for (const auto &op : ops)
+            {
+                std::string type = op.at("op").get<std::string>();
+                if (type == "add")
+                {
+                    insertEvent(events, eventFromJson(op.at("event")));
+                }
+                else if (type == "remove")
+                {
+                    eraseEvents(events, op.at("title").get<std::string>());
+                }
+                else if (type == "skip")
+                {
+                    addException(events, op.at("title").get<std::string>(),
+                                 parseTime(op.at("time").get<std::string>()));
+                }
             }
 
-            LOG_INFO("Loaded {} events from calendar", m_events.size());
+            LOG_INFO("Loaded {} events and {} recurring series from calendar", events.single.size(),
+                     events.series.size());
         }
         catch (const std::exception &e)
         {
             LOG_ERROR("Failed to parse calendar file: {}", e.what());
         }
+        install();
+    }
+
+    void Calendar::logOperation(const json &op, const Events &events)
+    {
+        TRACE_SCOPE("calendar.append");
+        // A failed append is covered by writing everything out instead
+        std::size_t interval = std::max(kSnapshotInterval, events.single.size() + events.series.size());
+        if (!m_opLog->append(op) || m_opLog->pendingOps() >= interval)
+        {
+            writeSnapshot(events);
+        }
     }
 
-} // namespace tarius::ai_secretary
\ No newline at end of file
+} // namespace tarius::ai_secretary
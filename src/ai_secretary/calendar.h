@@ -3,34 +3,192 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace tarius::utils
+{
+    class OpLog;
+} // namespace tarius::utils
 
 namespace tarius::ai_secretary
 {
+    class ReminderScheduler;
 
     class Calendar
     {
     public:
+        /**
+         * @brief An RRULE-like repetition of an event.
+         *
+         * Occurrences keep the local wall-clock time of the first one across
+         * DST changes. Weekly rules repeat on the byDay weekdays, or the first
+         * occurrence's weekday when byDay is empty; monthly rules repeat on
+         * the first occurrence's day of the month and skip months without it.
+         * As in RFC 5545, count includes occurrences removed by exceptions.
+         */
+        struct Recurrence
+        {
+            enum class Frequency
+            {
+                None,
+                Daily,
+                Weekly,
+                Monthly
+            };
+
+            Frequency frequency = Frequency::None;
+            int interval = 1;  // Every interval days, weeks or months
+            uint8_t byDay = 0; // Weekday bits, Monday = 1 << 0
+            int count = 0;     // Number of occurrences, 0 for no limit
+            std::optional<std::chrono::system_clock::time_point> until;    // Last possible start, inclusive
+            std::vector<std::chrono::system_clock::time_point> exceptions; // Skipped occurrence starts
+        };
+
         struct Event
         {
             std::string title;
-            std::chrono::system_clock::time_point time;
+            std::chrono::system_clock::time_point time; // Whole minutes; first occurrence when recurring
             std::string description;
             bool isAllDay = false;
+            std::chrono::minutes duration{0}; // Zero for a point in time
+            Recurrence recurrence;
+
+            bool isRecurring() const { return recurrence.frequency != Recurrence::Frequency::None; }
         };
 
-        Calendar();
+        struct Interval
+        {
+            std::chrono::system_clock::time_point start;
+            std::chrono::system_clock::time_point end; // Exclusive
+        };
+
+        // The local working day searched for free time
+        struct WorkingHours
+        {
+            std::chrono::minutes start{9 * 60}; // Since local midnight
+            std::chrono::minutes end{17 * 60};
+            uint8_t days = 0x1f; // Weekday bits as in Recurrence::byDay; Monday to Friday
+        };
+
+        // Events are stored under dataDirectory/calendar
+        explicit Calendar(const std::string &dataDirectory = "data");
         ~Calendar();
 
+        // Changes are serialized and update the indexes in place; queries run
+        // side by side and only wait while an index is being changed
         void addEvent(const Event &event);
         void removeEvent(const std::string &title);
-        std::vector<Event> getEvents(const std::string &date);
-        std::vector<Event> getEventsForTime(const std::chrono::system_clock::time_point &time);
+        std::vector<Event> getEvents(const std::string &date) const;
+
+        // Events starting in the same minute as time
+        std::vector<Event> getEventsForTime(const std::chrono::system_clock::time_point &time) const;
+
+        // Events overlapping [from, to), ordered by start time. Recurring
+        // events appear once per occurrence, with time set to its start.
+        std::vector<Event> getEventsInRange(const std::chrono::system_clock::time_point &from,
+                                            const std::chrono::system_clock::time_point &to) const;
+
+        // Time in [from, to) taken up by events, merged and in order. All-day
+        // events without a duration mark a day rather than fill it and are
+        // not counted.
+        std::vector<Interval> getBusy(const std::chrono::system_clock::time_point &from,
+                                      const std::chrono::system_clock::time_point &to) const;
+
+        // Free gaps of at least minLength within working hours in [from, to)
+        std::vector<Interval> findFreeSlots(const std::chrono::system_clock::time_point &from,
+                                            const std::chrono::system_clock::time_point &to,
+                                            std::chrono::minutes minLength, const WorkingHours &hours) const;
+        std::vector<Interval> findFreeSlots(const std::chrono::system_clock::time_point &from,
+                                            const std::chrono::system_clock::time_point &to,
+                                            std::chrono::minutes minLength) const;
+
+        // Events the given one would overlap, ordered by start, with time set
+        // to the overlapping occurrence. A recurring event is checked over
+        // its occurrences in the next 90 days.
+        std::vector<Event> findConflicts(const Event &event) const;
+
+        // Skip one occurrence of a recurring event; false if there is none at that time
+        bool skipOccurrence(const std::string &title, const std::chrono::system_clock::time_point &occurrence);
+
+        // Start of the first occurrence at or after the given time
+        static std::optional<std::chrono::system_clock::time_point> nextOccurrence(
+            const Event &event, const std::chrono::system_clock::time_point &after);
+
+        // Write a full snapshot; changes are otherwise appended to a log
         void saveEvents();
+        // Read the snapshot and replay the log on top of it
         void loadEvents();
 
+        // Schedule a reminder for every upcoming event, and for events added
+        // later; not owned
+        void setReminderScheduler(ReminderScheduler *scheduler);
+
     private:
-        std::vector<Event> m_events;
+        // Start time to event; events starting in the same minute keep their
+        // insertion order
+        using Timeline = std::multimap<std::chrono::system_clock::time_point, Event>;
+
+        // Everything a query reads; adding or removing a single event is O(log n)
+        struct Events
+        {
+            // Events starting before from - longestEvent cannot reach into a
+            // range starting at from, which bounds how far back a range query
+            // has to look
+            Timeline single;
+            std::unordered_map<std::string, std::vector<Timeline::iterator>> singleByTitle;
+            std::chrono::minutes longestEvent{0};
+
+            // Recurring events, expanded per query instead of stored per occurrence
+            std::vector<Event> series;
+        };
+
+        Events m_events;
+        // Shared by queries, exclusive while a change is applied
+        mutable std::shared_mutex m_eventsMutex;
+        // Held across a change, its log record and its reminders. m_events
+        // only changes with it held, so its holder reads m_events without
+        // m_eventsMutex.
+        std::mutex m_writeMutex;
+
         std::string m_calendarFilePath;
+        std::unique_ptr<utils::OpLog> m_opLog;
+        ReminderScheduler *m_scheduler;
+
+        // Record a change in the log, snapshotting when it has grown; the
+        // write lock must be held
+        void logOperation(const nlohmann::json &op, const Events &events);
+        void writeSnapshot(const Events &events);
+
+        static bool eraseEvents(Events &events, const std::string &title);
+        static bool addException(Events &events, const std::string &title,
+                                 const std::chrono::system_clock::time_point &start);
+        static void insertEvent(Events &events, Event event); // Into single, or series
+
+        void scheduleReminder(const Event &event);
+        void rescheduleReminders(const Events &events, const std::string &title);
+        static std::chrono::system_clock::time_point floorToMinute(const std::chrono::system_clock::time_point &time);
+        static std::chrono::system_clock::time_point endOf(const Event &event);
+        static bool takesTime(const Event &event);
+
+        // Visit events overlapping [from, to) with the start of each
+        // overlapping occurrence; single events come in order of start, then
+        // occurrences of each series
+        static void visitRange(const Events &events, const std::chrono::system_clock::time_point &from,
+                               const std::chrono::system_clock::time_point &to,
+                               const std::function<void(const Event &, const std::chrono::system_clock::time_point &)> &visit);
+
+        // Visit the starts of occurrences in [from, to) in order until visit returns false
+        static void expand(const Event &event, const std::chrono::system_clock::time_point &from,
+                           const std::chrono::system_clock::time_point &to,
+                           const std::function<bool(const std::chrono::system_clock::time_point &)> &visit);
     };
 
 } // namespace tarius::ai_secretary
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "intent_classifier.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+namespace tarius::ai_secretary
+{
+    namespace
+    {
+        struct Pattern
+        {
+            const char *text;
+            IntentClassifier::Keyword keyword;
+        };
+
+        const Pattern kPatterns[] = {
+            {"schedule", IntentClassifier::Schedule},
+            {"meeting", IntentClassifier::Meeting},
+            {"appointment", IntentClassifier::Appointment},
+            {"event", IntentClassifier::Event},
+            {"today", IntentClassifier::Today},
+            {"tomorrow", IntentClassifier::Tomorrow},
+            {"next", IntentClassifier::Next},
+            {"next week", IntentClassifier::NextWeek},
+            {"next month", IntentClassifier::NextMonth},
+            {"remind", IntentClassifier::Remind},
+            {"remember", IntentClassifier::Remember},
+            {"don't forget", IntentClassifier::DontForget},
+            {"task", IntentClassifier::Task},
+            {"to-do", IntentClassifier::ToDoHyphen},
+            {"todo", IntentClassifier::ToDo},
+            {"summarize", IntentClassifier::Summarize},
+            {"summary", IntentClassifier::Summary},
+            {"conversation", IntentClassifier::Conversation},
+            {"chat", IntentClassifier::Chat},
+            {"discussion", IntentClassifier::Discussion},
+            {"yesterday", IntentClassifier::Yesterday},
+            {"last week", IntentClassifier::LastWeek},
+            {"last month", IntentClassifier::LastMonth},
+        };
+
+        constexpr uint32_t bit(IntentClassifier::Keyword keyword)
+        {
+            return 1u << keyword;
+        }
+
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        // Word characters as \b sees them
+        bool isWordChar(char c)
+        {
+            return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        bool boundaryAt(const std::string &input, std::size_t pos)
+        {
+            return pos >= input.size() || !isWordChar(input[pos]);
+        }
+
+        // YYYY-MM-DD starting at pos
+        bool matchDate(const std::string &input, std::size_t pos, IntentClassifier::Span &span)
+        {
+            static const char kShape[] = "dddd-dd-dd";
+            const std::size_t length = sizeof(kShape) - 1;
+            if (input.size() - pos < length)
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < length; i++)
+            {
+                char c = input[pos + i];
+                if (kShape[i] == 'd' ? !isDigit(c) : c != kShape[i])
+                {
+                    return false;
+                }
+            }
+            if (!boundaryAt(input, pos + length))
+            {
+                return false;
+            }
+            span = {pos, pos + length};
+            return true;
+        }
+
+        // H, HH, H:MM or HH:MM, then optional spaces and am/pm. A bare
+        // number is not a time.
+        bool matchTime(const std::string &input, std::size_t pos, IntentClassifier::ClockTime &time)
+        {
+            std::size_t i = pos;
+            int hour = 0;
+            while (i < input.size() && isDigit(input[i]) && i - pos < 2)
+            {
+                hour = hour * 10 + (input[i++] - '0');
+            }
+            if (i < input.size() && isDigit(input[i]))
+            {
+                return false;
+            }
+
+            int minute = 0;
+            bool hasMinutes = false;
+            if (i + 2 < input.size() && input[i] == ':' && isDigit(input[i + 1]) && isDigit(input[i + 2]) &&
+                boundaryAt(input, i + 3))
+            {
+                minute = (input[i + 1] - '0') * 10 + (input[i + 2] - '0');
+                hasMinutes = true;
+                i += 3;
+            }
+
+            std::size_t end = i;
+            std::size_t j = i;
+            while (j < input.size() && input[j] == ' ')
+            {
+                j++;
+            }
+            bool pm = false;
+            bool hasMeridiem = false;
+            if (j + 1 < input.size() && (input[j + 1] == 'm' || input[j + 1] == 'M') && boundaryAt(input, j + 2))
+            {
+                char c = input[j];
+                if (c == 'a' || c == 'A' || c == 'p' || c == 'P')
+                {
+                    hasMeridiem = true;
+                    pm = c == 'p' || c == 'P';
+                    end = j + 2;
+                }
+            }
+
+            if (!hasMinutes && !hasMeridiem)
+            {
+                return false;
+            }
+            if (!hasMeridiem && !boundaryAt(input, i))
+            {
+                return false;
+            }
+            if (minute > 59 || (hasMeridiem ? hour < 1 || hour > 12 : hour > 23))
+            {
+                return false;
+            }
+
+            if (hasMeridiem)
+            {
+                hour = hour % 12 + (pm ? 12 : 0);
+            }
+            time.hour = hour;
+            time.minute = minute;
+            time.hasMeridiem = hasMeridiem;
+            time.span = {pos, end};
+            return true;
+        }
+    } // namespace
+
+    IntentClassifier::IntentClassifier()
+    {
+        build();
+    }
+
+    void IntentClassifier::build()
+    {
+        // Lowercase letters, and the punctuation that appears in keywords;
+        // uppercase letters share their lowercase symbol
+        m_symbol.fill(0);
+        uint8_t next = 1;
+        for (char c = 'a'; c <= 'z'; c++)
+        {
+            m_symbol[static_cast<uint8_t>(c)] = next;
+            m_symbol[static_cast<uint8_t>(c - 'a' + 'A')] = next;
+            next++;
+        }
+        for (char c : {' ', '\'', '-'})
+        {
+            m_symbol[static_cast<uint8_t>(c)] = next++;
+        }
+
+        // Trie of the keywords
+        std::vector<std::array<int32_t, kAlphabetSize>> trie(1);
+        trie[0].fill(-1);
+        m_outputs.assign(1, {});
+        for (const auto &pattern : kPatterns)
+        {
+            int32_t state = 0;
+            for (const char *p = pattern.text; *p; p++)
+            {
+                uint8_t symbol = m_symbol[static_cast<uint8_t>(*p)];
+                if (trie[state][symbol] < 0)
+                {
+                    trie[state][symbol] = static_cast<int32_t>(trie.size());
+                    trie.emplace_back();
+                    trie.back().fill(-1);
+                    m_outputs.emplace_back();
+                }
+                state = trie[state][symbol];
+            }
+            m_outputs[state].push_back(pattern.keyword);
+            m_keywordLength[pattern.keyword] = static_cast<uint8_t>(std::strlen(pattern.text));
+        }
+
+        // Breadth-first, fill in missing transitions from the failure links
+        // so matching is a single table lookup per byte
+        std::vector<int32_t> fail(trie.size(), 0);
+        std::deque<int32_t> queue;
+        for (int symbol = 0; symbol < kAlphabetSize; symbol++)
+        {
+            int32_t child = trie[0][symbol];
+            if (child < 0)
+            {
+                trie[0][symbol] = 0;
+            }
+            else
+            {
+                queue.push_back(child);
+            }
+        }
+        // Other bytes always return to the root
+        trie[0][0] = 0;
+
+        while (!queue.empty())
+        {
+            int32_t state = queue.front();
+            queue.pop_front();
+            const auto &inherited = m_outputs[fail[state]];
+            m_outputs[state].insert(m_outputs[state].end(), inherited.begin(), inherited.end());
+
+            for (int symbol = 0; symbol < kAlphabetSize; symbol++)
+            {
+                int32_t child = trie[state][symbol];
+                if (child < 0)
+                {
+                    trie[state][symbol] = trie[fail[state]][symbol];
+                }
+                else
+                {
+                    fail[child] = trie[fail[state]][symbol];
+                    queue.push_back(child);
+                }
+            }
+        }
+
+        m_next.resize(trie.size() * kAlphabetSize);
+        for (std::size_t state = 0; state < trie.size(); state++)
+        {
+            std::copy(trie[state].begin(), trie[state].end(), m_next.begin() + state * kAlphabetSize);
+        }
+    }
+
+    IntentClassifier::Result IntentClassifier::classify(const std::string &input) const
+    {
+        Result result;
+        int32_t state = 0;
+        for (std::size_t i = 0; i < input.size(); i++)
+        {
+            const char c = input[i];
+            state = m_next[state * kAlphabetSize + m_symbol[static_cast<uint8_t>(c)]];
+            for (Keyword keyword : m_outputs[state])
+            {
+                if (!result.has(keyword))
+                {
+                    result.keywords |= bit(keyword);
+                    result.keywordSpans[keyword] = {i + 1 - m_keywordLength[keyword], i + 1};
+                }
+            }
+
+            // Dates and times start with a digit at a word boundary
+            if (isDigit(c) && (i == 0 || !isWordChar(input[i - 1])))
+            {
+                if (result.date.empty())
+                {
+                    matchDate(input, i, result.date);
+                }
+                if (!result.hasTime)
+                {
+                    result.hasTime = matchTime(input, i, result.time);
+                }
+            }
+        }
+
+        const bool schedulingWord = result.keywords & (bit(Schedule) | bit(Meeting) | bit(Appointment) | bit(Event));
+        const bool when = (result.keywords & (bit(Today) | bit(Tomorrow) | bit(Next))) ||
+                          (result.hasTime && result.time.hasMeridiem) || !result.date.empty();
+        const bool reminderWord = result.keywords & (bit(Remind) | bit(Remember) | bit(DontForget) | bit(Task) |
+                                                     bit(ToDoHyphen) | bit(ToDo));
+        const bool summaryWord = result.keywords & (bit(Summarize) | bit(Summary));
+        const bool summaryScope = result.keywords & (bit(Conversation) | bit(Chat) | bit(Discussion) |
+                                                     bit(Yesterday) | bit(LastWeek) | bit(LastMonth));
+
+        if (schedulingWord && when)
+        {
+            result.intent = Intent::Scheduling;
+        }
+        else if (reminderWord)
+        {
+            result.intent = Intent::Reminder;
+        }
+        else if (summaryWord && summaryScope)
+        {
+            result.intent = Intent::Summary;
+        }
+        return result;
+    }
+
+} // namespace tarius::ai_secretary
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tarius::ai_secretary
+{
+    /**
+     * @brief Single-pass classifier for secretary requests.
+     *
+     * The trigger keywords are compiled once into an Aho-Corasick automaton
+     * over a compact alphabet. classify() then walks the input a single time,
+     * lowercasing byte by byte, and in the same pass picks out an ISO date
+     * (YYYY-MM-DD) and a clock time (9:30, 9pm, 9:30 pm). No copies of the
+     * input and no std::regex are involved, and every match is reported as
+     * a span of the original input so handlers can reuse it.
+     */
+    class IntentClassifier
+    {
+    public:
+        enum class Intent
+        {
+            None,
+            Scheduling,
+            Reminder,
+            Summary
+        };
+
+        enum Keyword
+        {
+            // Scheduling
+            Schedule,
+            Meeting,
+            Appointment,
+            Event,
+            Today,
+            Tomorrow,
+            Next,
+            NextWeek,
+            NextMonth,
+            // Reminders
+            Remind,
+            Remember,
+            DontForget,
+            Task,
+            ToDoHyphen,
+            ToDo,
+            // Summaries
+            Summarize,
+            Summary,
+            Conversation,
+            Chat,
+            Discussion,
+            Yesterday,
+            LastWeek,
+            LastMonth,
+            KeywordCount
+        };
+
+        // Half-open byte range of the input
+        struct Span
+        {
+            std::size_t begin = 0;
+            std::size_t end = 0;
+
+            bool empty() const { return begin == end; }
+            std::size_t size() const { return end - begin; }
+        };
+
+        struct ClockTime
+        {
+            int hour = 0; // 0-23, after applying am/pm
+            int minute = 0;
+            bool hasMeridiem = false;
+            Span span;
+        };
+
+        struct Result
+        {
+            Intent intent = Intent::None;
+            uint32_t keywords = 0;                             // Bit per Keyword found
+            std::array<Span, KeywordCount> keywordSpans = {}; // First match of each
+            Span date;                                         // Empty if none
+            bool hasTime = false;
+            ClockTime time;
+
+            bool has(Keyword keyword) const { return keywords & (1u << keyword); }
+            Span spanOf(Keyword keyword) const { return keywordSpans[keyword]; }
+        };
+
+        IntentClassifier();
+
+        Result classify(const std::string &input) const;
+
+    private:
+        static constexpr int kAlphabetSize = 32;
+
+        // Dense transition table: m_next[state * kAlphabetSize + symbol]
+        std::vector<int32_t> m_next;
+        // Keywords ending at each state, including through failure links
+        std::vector<std::vector<Keyword>> m_outputs;
+        std::array<uint8_t, 256> m_symbol;             // Byte to alphabet index; 0 for other bytes
+        std::array<uint8_t, KeywordCount> m_keywordLength;
+
+        void build();
+    };
+
+} // namespace tarius::ai_secretary
@@ -0,0 +1,170 @@
+#include "reminder_scheduler.h"
+#include "../utils/logger.h"
+#include "../utils/tracer.h"
+#include <algorithm>
+
+namespace tarius::ai_secretary
+{
+    ReminderScheduler::ReminderScheduler()
+        : m_nextId(0), m_stopping(false)
+    {
+        m_thread = std::thread(&ReminderScheduler::run, this);
+    }
+
+    ReminderScheduler::~ReminderScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void ReminderScheduler::setHandler(Handler handler)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_handler = std::move(handler);
+    }
+
+    void ReminderScheduler::schedule(const std::string &key, Clock::time_point due, const std::string &message,
+                                     Next next)
+    {
+        bool earliest;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            earliest = m_heap.empty() || due < m_heap.top().due;
+            pushLocked(due, {key, message, std::move(next)});
+        }
+
+        // Only a new earliest reminder changes how long the thread should sleep
+        if (earliest)
+        {
+            m_cv.notify_all();
+        }
+    }
+
+    void ReminderScheduler::pushLocked(Clock::time_point due, Reminder reminder)
+    {
+        uint64_t id = m_nextId++;
+        m_byKey[reminder.key].push_back(id);
+        m_reminders[id] = std::move(reminder);
+        m_heap.push({due, id});
+    }
+
+    void ReminderScheduler::cancel(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_byKey.find(key);
+        if (it == m_byKey.end())
+        {
+            return;
+        }
+
+        for (uint64_t id : it->second)
+        {
+            m_reminders.erase(id);
+        }
+        m_byKey.erase(it);
+        compactLocked();
+    }
+
+    std::size_t ReminderScheduler::pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reminders.size();
+    }
+
+    void ReminderScheduler::compactLocked()
+    {
+        if (m_heap.size() < 64 || m_heap.size() < 2 * m_reminders.size())
+        {
+            return;
+        }
+
+        std::vector<HeapEntry> live;
+        live.reserve(m_reminders.size());
+        while (!m_heap.empty())
+        {
+            if (m_reminders.count(m_heap.top().id))
+            {
+                live.push_back(m_heap.top());
+            }
+            m_heap.pop();
+        }
+        m_heap = decltype(m_heap)(std::greater<HeapEntry>(), std::move(live));
+    }
+
+    void ReminderScheduler::run()
+    {
+        utils::Tracer::setThreadName("reminders");
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopping)
+        {
+            if (m_heap.empty())
+            {
+                m_cv.wait(lock);
+                continue;
+            }
+
+            HeapEntry next = m_heap.top();
+            auto it = m_reminders.find(next.id);
+            if (it == m_reminders.end())
+            {
+                m_heap.pop(); // Cancelled
+                continue;
+            }
+
+            if (Clock::now() < next.due)
+            {
+                // Woken early by a new earliest reminder or shutdown
+                m_cv.wait_until(lock, next.due);
+                continue;
+            }
+
+            // Everything from here to the handler returning; waits aren't traced
+            TRACE_SCOPE("reminder.dispatch");
+            m_heap.pop();
+            Reminder reminder = std::move(it->second);
+            m_reminders.erase(it);
+
+            auto ids = m_byKey.find(reminder.key);
+            if (ids != m_byKey.end())
+            {
+                ids->second.erase(std::remove(ids->second.begin(), ids->second.end(), next.id), ids->second.end());
+                if (ids->second.empty())
+                {
+                    m_byKey.erase(ids);
+                }
+            }
+
+            // Queued before unlocking, so a cancel during the handler covers it
+            if (reminder.next)
+            {
+                std::optional<Clock::time_point> following = reminder.next(next.due);
+                if (following && *following > next.due)
+                {
+                    pushLocked(*following, reminder);
+                }
+            }
+
+            Handler handler = m_handler;
+            lock.unlock();
+            if (handler)
+            {
+                handler(reminder.message);
+            }
+            else
+            {
+                LOG_INFO("Reminder with no handler: {}", reminder.message);
+            }
+            lock.lock();
+        }
+    }
+
+} // namespace tarius::ai_secretary
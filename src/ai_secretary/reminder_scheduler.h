@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tarius::ai_secretary
+{
+    /**
+     * @brief Fires reminders at their due time from a single background thread.
+     *
+     * Pending reminders sit in a min-heap keyed on due time and the thread
+     * sleeps on a condition variable until the earliest one is due, so an
+     * idle scheduler uses no CPU. Reminders are grouped under a caller-chosen
+     * key (one per event or task) so they can be cancelled when the item is
+     * removed or completed; cancelled heap entries are dropped lazily.
+     *
+     * A repeating reminder is only ever held as its next occurrence: when it
+     * fires, its next function supplies the following due time.
+     */
+    class ReminderScheduler
+    {
+    public:
+        using Clock = std::chrono::system_clock;
+        using Handler = std::function<void(const std::string &message)>;
+
+        // Due time of the occurrence after the one that just fired, if any
+        using Next = std::function<std::optional<Clock::time_point>(Clock::time_point fired)>;
+
+        ReminderScheduler();
+        ~ReminderScheduler();
+
+        // Receives each reminder on the scheduler thread. Reminders due while
+        // no handler is set are logged and dropped.
+        void setHandler(Handler handler);
+
+        // Fire message at due, and again at each time next returns; a due
+        // time in the past fires immediately
+        void schedule(const std::string &key, Clock::time_point due, const std::string &message,
+                      Next next = nullptr);
+
+        // Drop every pending reminder scheduled under key
+        void cancel(const std::string &key);
+
+        std::size_t pending() const;
+
+    private:
+        struct Reminder
+        {
+            std::string key;
+            std::string message;
+            Next next;
+        };
+
+        struct HeapEntry
+        {
+            Clock::time_point due;
+            uint64_t id;
+
+            bool operator>(const HeapEntry &other) const
+            {
+                return due != other.due ? due > other.due : id > other.id;
+            }
+        };
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> m_heap;
+        std::unordered_map<uint64_t, Reminder> m_reminders;              // Live reminders by id
+        std::unordered_map<std::string, std::vector<uint64_t>> m_byKey; // Ids scheduled under each key
+        uint64_t m_nextId;
+        Handler m_handler;
+        bool m_stopping;
+
+        std::thread m_thread;
+
+        void run();
+        void pushLocked(Clock::time_point due, Reminder reminder);
+
+        // Rebuild the heap once cancelled entries outnumber live ones
+        void compactLocked();
+    };
+
+} // namespace tarius::ai_secretary
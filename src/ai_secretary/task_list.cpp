@@ -1,201 +1,393 @@
 #include "task_list.h"
+#include "reminder_scheduler.h"
+#include "../utils/id_generator.h"
 #include "../utils/logger.h"
-#include <fstream>
+#include "../utils/tracer.h"
+#include "../utils/op_log.h"
+#include "../utils/time_utils.h"
+#include <algorithm>
 #include <nlohmann/json.hpp>
-#include <filesystem>
-#include <iomanip>
-#include <sstream>
 
-namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 namespace tarius::ai_secretary
 {
+    namespace
+    {
+        // Logged changes after which the whole list is snapshotted again, or
+        // as many as it has tasks if that is more, so the snapshot's cost
+        // spread over the changes stays the same as the list grows
+        constexpr std::size_t kSnapshotInterval = 256;
+
+        json taskToJson(const TaskList::Task &task)
+        {
+            json taskJson;
+            taskJson["id"] = task.id;
+            taskJson["description"] = task.description;
+            taskJson["completed"] = task.completed;
+            taskJson["priority"] = task.priority;
 
-    TaskList::TaskList()
-        : m_taskFilePath("data/tasks/tasks.json")
+            // Convert due time to ISO string
+            taskJson["dueTime"] = utils::TimeUtils::formatIsoDateTime(task.dueTime);
+            return taskJson;
+        }
+
+        TaskList::Task taskFromJson(const json &taskJson)
+        {
+            TaskList::Task task;
+            task.id = taskJson.value("id", "");
+            task.description = taskJson["description"];
+            task.completed = taskJson["completed"];
+            task.priority = taskJson["priority"];
+
+            // Parse due time
+            utils::TimeUtils::parseIsoDateTime(taskJson["dueTime"].get<std::string>(), task.dueTime);
+            return task;
+        }
+    } // namespace
+
+    TaskList::TaskList(const std::string &dataDirectory)
+        : m_taskFilePath(dataDirectory + "/tasks/tasks.json"),
+          m_opLog(std::make_unique<utils::OpLog>(m_taskFilePath, dataDirectory + "/tasks/tasks.log")),
+          m_scheduler(nullptr)
     {
         loadTasks();
     }
 
     TaskList::~TaskList()
     {
-        saveTasks();
+        // Fold the log into the snapshot so the next start replays nothing
+        if (m_opLog->pendingOps() > 0)
+        {
+            saveTasks();
+        }
+    }
+
+    std::string TaskList::addTask(const Task &task)
+    {
+        Task added = task;
+        added.id = utils::IdGenerator::next("task");
+
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        {
+            std::unique_lock<std::shared_mutex> tasksLock(m_tasksMutex);
+            insertTask(m_tasks, added);
+        }
+
+        scheduleReminder(added);
+        logOperation({{"op", "add"}, {"task", taskToJson(added)}}, m_tasks);
+        LOG_INFO("Added task {}: {}", added.id, added.description);
+        return added.id;
     }
 
-    void TaskList::addTask(const Task &task)
+    void TaskList::insertTask(Tasks &tasks, Task task)
     {
-        m_tasks.push_back(task);
-        saveTasks();
-        LOG_INFO("Added task: {}", task.description);
+        // Replaying a log can repeat an add whose id is already present
+        if (tasks.byId.count(task.id))
+        {
+            return;
+        }
+
+        auto view = std::make_shared<const Task>(std::move(task));
+        tasks.byId[view->id] = tasks.order.insert(tasks.order.end(), view);
+        indexPending(tasks, *view);
     }
 
-    void TaskList::completeTask(const std::string &description)
+    void TaskList::indexPending(Tasks &tasks, const Task &task)
     {
-        bool found = false;
-        for (auto &task : m_tasks)
+        if (!task.completed)
         {
-            if (task.description == description)
+            tasks.pendingByDue.emplace(task.dueTime, task.id);
+            tasks.pendingByPriority[task.priority].emplace(task.dueTime, task.id);
+        }
+    }
+
+    void TaskList::unindexPending(Tasks &tasks, const Task &task)
+    {
+        tasks.pendingByDue.erase({task.dueTime, task.id});
+        auto bucket = tasks.pendingByPriority.find(task.priority);
+        if (bucket != tasks.pendingByPriority.end())
+        {
+            bucket->second.erase({task.dueTime, task.id});
+            if (bucket->second.empty())
             {
-                task.completed = true;
-                found = true;
-                break;
+                tasks.pendingByPriority.erase(bucket);
             }
         }
+    }
 
-        if (found)
+    void TaskList::setReminderScheduler(ReminderScheduler *scheduler)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_scheduler = scheduler;
+        for (const auto &[due, id] : m_tasks.pendingByDue)
         {
-            saveTasks();
-            LOG_INFO("Completed task: {}", description);
+            scheduleReminder(**m_tasks.byId.at(id));
         }
-        else
+    }
+
+    void TaskList::scheduleReminder(const Task &task)
+    {
+        // Tasks due earlier in the current minute still get their reminder
+        auto minuteStart = std::chrono::time_point_cast<std::chrono::minutes>(std::chrono::system_clock::now());
+        if (!m_scheduler || task.completed || task.dueTime < minuteStart)
         {
-            LOG_WARN("Task not found: {}", description);
+            return;
         }
+        m_scheduler->schedule("task:" + task.id, task.dueTime, "Task: " + task.description + " is due now.");
     }
 
-    void TaskList::removeTask(const std::string &description)
+    bool TaskList::completeTask(const std::string &id)
     {
-        auto it = std::remove_if(m_tasks.begin(), m_tasks.end(),
-                                 [&description](const Task &task)
-                                 { return task.description == description; });
-
-        if (it != m_tasks.end())
+        std::lock_guard<std::mutex> lock(m_writeMutex);
         {
-            m_tasks.erase(it, m_tasks.end());
-            saveTasks();
-            LOG_INFO("Removed task: {}", description);
+            std::unique_lock<std::shared_mutex> tasksLock(m_tasksMutex);
+            if (!markCompleted(m_tasks, id))
+            {
+                LOG_WARN("Task not found or already completed: {}", id);
+                return false;
+            }
         }
-        else
+
+        if (m_scheduler)
         {
-            LOG_WARN("Task not found: {}", description);
+            m_scheduler->cancel("task:" + id);
         }
+        logOperation({{"op", "complete"}, {"id", id}}, m_tasks);
+        LOG_INFO("Completed task: {}", id);
+        return true;
     }
 
-    std::vector<TaskList::Task> TaskList::getAllTasks()
+    bool TaskList::markCompleted(Tasks &tasks, const std::string &id)
     {
-        return m_tasks;
+        auto it = tasks.byId.find(id);
+        if (it == tasks.byId.end() || (*it->second)->completed)
+        {
+            return false;
+        }
+
+        // Views handed out earlier still hold the open task
+        auto completed = std::make_shared<Task>(**it->second);
+        completed->completed = true;
+        unindexPending(tasks, *completed);
+        *it->second = std::move(completed);
+        return true;
     }
 
-    std::vector<TaskList::Task> TaskList::getDueTasks(const std::chrono::system_clock::time_point &time)
+    bool TaskList::eraseTask(Tasks &tasks, const std::string &id)
     {
-        std::vector<Task> dueTasks;
-
-        // Convert time to time_t for easier comparison
-        auto timeT = std::chrono::system_clock::to_time_t(time);
-        std::tm tm = *std::localtime(&timeT);
+        auto it = tasks.byId.find(id);
+        if (it == tasks.byId.end())
+        {
+            return false;
+        }
 
-        // Round to the nearest minute
-        tm.tm_sec = 0;
-        auto roundedTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        unindexPending(tasks, **it->second);
+        tasks.order.erase(it->second);
+        tasks.byId.erase(it);
+        return true;
+    }
 
-        // Find tasks that are due at the current time (within a minute)
-        for (const auto &task : m_tasks)
+    bool TaskList::removeTask(const std::string &id)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
         {
-            if (task.completed)
+            std::unique_lock<std::shared_mutex> tasksLock(m_tasksMutex);
+            if (!eraseTask(m_tasks, id))
             {
-                continue; // Skip completed tasks
+                LOG_WARN("Task not found: {}", id);
+                return false;
             }
+        }
 
-            auto taskTimeT = std::chrono::system_clock::to_time_t(task.dueTime);
-            std::tm taskTm = *std::localtime(&taskTimeT);
-            taskTm.tm_sec = 0;
-            auto roundedTaskTime = std::chrono::system_clock::from_time_t(std::mktime(&taskTm));
+        if (m_scheduler)
+        {
+            m_scheduler->cancel("task:" + id);
+        }
+        logOperation({{"op", "remove"}, {"id", id}}, m_tasks);
+        LOG_INFO("Removed task: {}", id);
+        return true;
+    }
 
-            if (roundedTaskTime == roundedTime)
-            {
-                dueTasks.push_back(task);
-            }
+    TaskList::TaskView TaskList::findTask(const std::string &id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_tasksMutex);
+        auto it = m_tasks.byId.find(id);
+        return it == m_tasks.byId.end() ? nullptr : *it->second;
+    }
+
+    std::vector<TaskList::TaskView> TaskList::getAllTasks() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_tasksMutex);
+        return std::vector<TaskView>(m_tasks.order.begin(), m_tasks.order.end());
+    }
+
+    std::vector<TaskList::TaskView> TaskList::viewsOf(const Tasks &tasks, std::set<DueKey>::const_iterator first,
+                                                      std::set<DueKey>::const_iterator last)
+    {
+        std::vector<TaskView> views;
+        for (auto it = first; it != last; ++it)
+        {
+            views.push_back(*tasks.byId.at(it->second));
         }
+        return views;
+    }
 
-        return dueTasks;
+    std::vector<TaskList::TaskView> TaskList::getDueTasks(const std::chrono::system_clock::time_point &time) const
+    {
+        // Time zone offsets are whole minutes, so this matches local rounding
+        auto minuteStart = std::chrono::floor<std::chrono::minutes>(time);
+        auto minuteEnd = minuteStart + std::chrono::minutes(1);
+        std::shared_lock<std::shared_mutex> lock(m_tasksMutex);
+        return viewsOf(m_tasks, m_tasks.pendingByDue.lower_bound({minuteStart, std::string()}),
+                       m_tasks.pendingByDue.lower_bound({minuteEnd, std::string()}));
     }
 
-    void TaskList::saveTasks()
+    std::vector<TaskList::TaskView> TaskList::getOverdueTasks(const std::chrono::system_clock::time_point &time) const
     {
-        // Create directory if it doesn't exist
-        fs::create_directories("data/tasks");
+        auto after = time + std::chrono::system_clock::duration(1);
+        std::shared_lock<std::shared_mutex> lock(m_tasksMutex);
+        return viewsOf(m_tasks, m_tasks.pendingByDue.begin(), m_tasks.pendingByDue.lower_bound({after, std::string()}));
+    }
 
-        // Create JSON array
-        json tasksJson = json::array();
+    std::vector<TaskList::TaskView> TaskList::getTasksByPriority(int priority) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_tasksMutex);
+        auto bucket = m_tasks.pendingByPriority.find(priority);
+        if (bucket == m_tasks.pendingByPriority.end())
+        {
+            return {};
+        }
+        return viewsOf(m_tasks, bucket->second.begin(), bucket->second.end());
+    }
 
-        for (const auto &task : m_tasks)
+    std::string TaskList::resolveId(const Tasks &tasks, const json &op)
+    {
+        if (op.contains("id"))
         {
-            json taskJson;
-            taskJson["description"] = task.description;
-            taskJson["completed"] = task.completed;
-            taskJson["priority"] = task.priority;
+            return op["id"].get<std::string>();
+        }
 
-            // Convert due time to ISO string
-            auto time_t = std::chrono::system_clock::to_time_t(task.dueTime);
-            std::stringstream ss;
-            ss << std::put_time(std::localtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-            taskJson["dueTime"] = ss.str();
+        std::string description = op.value("description", "");
+        for (const auto &task : tasks.order)
+        {
+            if (task->description == description)
+            {
+                return task->id;
+            }
+        }
+        return "";
+    }
 
-            tasksJson.push_back(taskJson);
+    void TaskList::saveTasks()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        writeSnapshot(m_tasks);
+    }
+
+    void TaskList::writeSnapshot(const Tasks &tasks)
+    {
+        TRACE_SCOPE("tasks.snapshot");
+        json tasksJson = json::array();
+        for (const auto &task : tasks.order)
+        {
+            tasksJson.push_back(taskToJson(*task));
         }
 
-        // Write to file
-        std::ofstream file(m_taskFilePath);
-        if (file.is_open())
+        if (m_opLog->writeSnapshot(tasksJson))
         {
-            file << tasksJson.dump(4);
-            file.close();
-            LOG_INFO("Saved {} tasks", m_tasks.size());
+            LOG_INFO("Saved {} tasks", tasks.order.size());
         }
         else
         {
-            LOG_ERROR("Failed to open task file for writing: {}", m_taskFilePath);
+            LOG_ERROR("Failed to write task snapshot: {}", m_taskFilePath);
         }
     }
 
     void TaskList::loadTasks()
     {
-        // Clear existing tasks
-        m_tasks.clear();
-
-        // Check if file exists
-        if (!fs::exists(m_taskFilePath))
+        TRACE_SCOPE("tasks.load");
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        Tasks tasks;
+        // Swapped in whole; list and map iterators stay valid across a swap
+        auto install = [this, &tasks]()
         {
-            LOG_INFO("Task file does not exist, starting with empty task list");
-            return;
-        }
+            std::unique_lock<std::shared_mutex> tasksLock(m_tasksMutex);
+            std::swap(m_tasks, tasks);
+        };
 
-        // Read file
-        std::ifstream file(m_taskFilePath);
-        if (!file.is_open())
+        json tasksJson;
+        std::vector<json> ops;
+        if (!m_opLog->load(tasksJson, ops))
         {
-            LOG_ERROR("Failed to open task file for reading: {}", m_taskFilePath);
+            LOG_ERROR("Failed to read task file: {}", m_taskFilePath);
+            install();
             return;
         }
 
         try
         {
-            json tasksJson = json::parse(file);
-            file.close();
+            // Tasks saved before ids existed get one now, and a snapshot
+            // below so the ids stay the same on the next start
+            bool assignedIds = false;
+            auto insertLoaded = [&](Task task)
+            {
+                if (task.id.empty())
+                {
+                    task.id = utils::IdGenerator::next("task");
+                    assignedIds = true;
+                }
+                insertTask(tasks, std::move(task));
+            };
+
+            if (tasksJson.is_array())
+            {
+                for (const auto &taskJson : tasksJson)
+                {
+                    insertLoaded(taskFromJson(taskJson));
+                }
+            }
 
-            for (const auto &taskJson : tasksJson)
+            // Changes made since the snapshot
+            for (const auto &op : ops)
             {
-                Task task;
-                task.description = taskJson["description"];
-                task.completed = taskJson["completed"];
-                task.priority = taskJson["priority"];
-
-                // Parse due time
-                std::tm tm = {};
-                std::stringstream ss(taskJson["dueTime"].get<std::string>());
-                ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-                task.dueTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
-
-                m_tasks.push_back(task);
+                std::string type = op.at("op").get<std::string>();
+                if (type == "add")
+                {
+                    insertLoaded(taskFromJson(op.at("task")));
+                }
+                else if (type == "complete")
+                {
+                    markCompleted(tasks, resolveId(tasks, op));
+                }
+                else if (type == "remove")
+                {
+                    eraseTask(tasks, resolveId(tasks, op));
+                }
             }
 
-            LOG_INFO("Loaded {} tasks", m_tasks.size());
+            LOG_INFO("Loaded {} tasks", tasks.order.size());
+            if (assignedIds)
+            {
+                writeSnapshot(tasks);
+            }
         }
         catch (const std::exception &e)
         {
             LOG_ERROR("Failed to parse task file: {}", e.what());
         }
+        install();
+    }
+
+    void TaskList::logOperation(const json &op, const Tasks &tasks)
+    {
+        TRACE_SCOPE("tasks.append");
+        // A failed append is covered by writing everything out instead
+        std::size_t interval = std::max(kSnapshotInterval, tasks.order.size());
+        if (!m_opLog->append(op) || m_opLog->pendingOps() >= interval)
+        {
+            writeSnapshot(tasks);
+        }
     }
 
-} // namespace tarius::ai_secretary
\ No newline at end of file
+} // namespace tarius::ai_secretary
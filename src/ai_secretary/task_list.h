@@ -3,35 +3,118 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <nlohmann/json.hpp>
+
+namespace tarius::utils
+{
+    class OpLog;
+} // namespace tarius::utils
 
 namespace tarius::ai_secretary
 {
+    class ReminderScheduler;
 
     class TaskList
     {
     public:
         struct Task
         {
+            std::string id; // Assigned by addTask
             std::string description;
             std::chrono::system_clock::time_point dueTime;
             bool completed = false;
             int priority = 0; // 0 = normal, 1 = important, 2 = urgent
         };
 
-        TaskList();
+        // Tasks handed out by queries are immutable; a change to a task
+        // replaces it, so a view keeps showing the task as it was
+        using TaskView = std::shared_ptr<const Task>;
+
+        // Tasks are stored under dataDirectory/tasks
+        explicit TaskList(const std::string &dataDirectory = "data");
         ~TaskList();
 
-        void addTask(const Task &task);
-        void completeTask(const std::string &description);
-        void removeTask(const std::string &description);
-        std::vector<Task> getAllTasks();
-        std::vector<Task> getDueTasks(const std::chrono::system_clock::time_point &time);
+        // Changes are serialized and update the indexes in place; queries run
+        // side by side and only wait while an index is being changed.
+        // Returns the new task's id.
+        std::string addTask(const Task &task);
+        bool completeTask(const std::string &id);
+        bool removeTask(const std::string &id);
+
+        // nullptr if there is no task with that id
+        TaskView findTask(const std::string &id) const;
+
+        // Every task, oldest first
+        std::vector<TaskView> getAllTasks() const;
+
+        // Open tasks due in the same minute as time
+        std::vector<TaskView> getDueTasks(const std::chrono::system_clock::time_point &time) const;
+
+        // Open tasks due at or before time, earliest first
+        std::vector<TaskView> getOverdueTasks(const std::chrono::system_clock::time_point &time) const;
+
+        // Open tasks of one priority, earliest due first
+        std::vector<TaskView> getTasksByPriority(int priority) const;
+
+        // Write a full snapshot; changes are otherwise appended to a log
         void saveTasks();
+        // Read the snapshot and replay the log on top of it
         void loadTasks();
 
+        // Schedule a reminder for every open task that is not yet due, and
+        // for tasks added later; not owned
+        void setReminderScheduler(ReminderScheduler *scheduler);
+
     private:
-        std::vector<Task> m_tasks;
+        using DueKey = std::pair<std::chrono::system_clock::time_point, std::string>; // Due time, id
+
+        // Everything a query reads; every change is O(1) or O(log n)
+        struct Tasks
+        {
+            std::list<TaskView> order; // Insertion order
+            std::unordered_map<std::string, std::list<TaskView>::iterator> byId;
+
+            // Open tasks ordered by due time, overall and per priority
+            std::set<DueKey> pendingByDue;
+            std::map<int, std::set<DueKey>> pendingByPriority;
+        };
+
+        Tasks m_tasks;
+        // Shared by queries, exclusive while a change is applied
+        mutable std::shared_mutex m_tasksMutex;
+        // Held across a change, its log record and its reminder. m_tasks only
+        // changes with it held, so its holder reads m_tasks without m_tasksMutex.
+        std::mutex m_writeMutex;
+
         std::string m_taskFilePath;
+        std::unique_ptr<utils::OpLog> m_opLog;
+        ReminderScheduler *m_scheduler;
+
+        // Record a change in the log, snapshotting when it has grown; the
+        // write lock must be held
+        void logOperation(const nlohmann::json &op, const Tasks &tasks);
+        void writeSnapshot(const Tasks &tasks);
+
+        static void insertTask(Tasks &tasks, Task task);
+        static bool markCompleted(Tasks &tasks, const std::string &id);
+        static bool eraseTask(Tasks &tasks, const std::string &id);
+        static void indexPending(Tasks &tasks, const Task &task);
+        static void unindexPending(Tasks &tasks, const Task &task);
+        static std::vector<TaskView> viewsOf(const Tasks &tasks, std::set<DueKey>::const_iterator first,
+                                             std::set<DueKey>::const_iterator last);
+
+        // Tasks logged before ids existed are looked up by description
+        static std::string resolveId(const Tasks &tasks, const nlohmann::json &op);
+
+        void scheduleReminder(const Task &task);
     };
 
-} // namespace tarius::ai_secretary
\ No newline at end of file
+} // namespace tarius::ai_secretary
@@ -0,0 +1,832 @@
+#include "temporal_parser.h"
+#include "../utils/time_utils.h"
+#include <algorithm>
+#include <iterator>
+
+namespace tarius::ai_secretary
+{
+    namespace
+    {
+        enum class TokenKind
+        {
+            End,
+            Word,
+            Number,
+            Symbol
+        };
+
+        struct Token
+        {
+            TokenKind kind = TokenKind::End;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            int value = 0; // Numbers only, capped
+
+            std::size_t size() const { return end - begin; }
+        };
+
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        bool isAlpha(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        char toLower(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        // The token starting at or after pos; words keep apostrophes
+        Token lex(std::string_view input, std::size_t pos)
+        {
+            while (pos < input.size() && (input[pos] == ' ' || input[pos] == '\t' || input[pos] == '\n'))
+            {
+                pos++;
+            }
+
+            Token token;
+            token.begin = pos;
+            token.end = pos;
+            if (pos >= input.size())
+            {
+                return token;
+            }
+
+            if (isDigit(input[pos]))
+            {
+                token.kind = TokenKind::Number;
+                while (token.end < input.size() && isDigit(input[token.end]))
+                {
+                    if (token.value < 1000000)
+                    {
+                        token.value = token.value * 10 + (input[token.end] - '0');
+                    }
+                    token.end++;
+                }
+            }
+            else if (isAlpha(input[pos]))
+            {
+                token.kind = TokenKind::Word;
+                while (token.end < input.size() && (isAlpha(input[token.end]) || input[token.end] == '\''))
+                {
+                    token.end++;
+                }
+            }
+            else
+            {
+                token.kind = TokenKind::Symbol;
+                token.end = pos + 1;
+            }
+            return token;
+        }
+
+        bool is(std::string_view input, const Token &token, std::string_view word)
+        {
+            if (token.kind != TokenKind::Word || token.size() != word.size())
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < word.size(); i++)
+            {
+                if (toLower(input[token.begin + i]) != word[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool isSymbol(std::string_view input, const Token &token, char symbol)
+        {
+            return token.kind == TokenKind::Symbol && input[token.begin] == symbol;
+        }
+
+        // Next token, only if nothing separates it from after
+        Token adjacent(std::string_view input, const Token &after)
+        {
+            Token token = lex(input, after.end);
+            if (token.begin != after.end)
+            {
+                token.kind = TokenKind::End;
+            }
+            return token;
+        }
+
+        // Sunday first, as in std::tm
+        int weekdayOf(std::string_view input, const Token &token)
+        {
+            static constexpr std::string_view kNames[] = {
+                "sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday",
+                "sun", "mon", "tue", "wed", "thu", "fri", "sat",
+                "suns", "mons", "tues", "weds", "thur", "thurs", "sats"};
+            static constexpr int kDay[] = {0, 1, 2, 3, 4, 5, 6, 0, 1, 2, 3, 4, 5, 6, 0, 1, 2, 3, 4, 4, 6};
+            for (std::size_t i = 0; i < std::size(kNames); i++)
+            {
+                if (is(input, token, kNames[i]))
+                {
+                    return kDay[i];
+                }
+            }
+            return -1;
+        }
+
+        // 0-11
+        int monthOf(std::string_view input, const Token &token)
+        {
+            static constexpr std::string_view kNames[] = {
+                "january", "february", "march", "april", "may", "june", "july", "august", "september",
+                "october", "november", "december",
+                "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec", "sept"};
+            static constexpr int kMonth[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                             0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 8};
+            for (std::size_t i = 0; i < std::size(kNames); i++)
+            {
+                if (is(input, token, kNames[i]))
+                {
+                    return kMonth[i];
+                }
+            }
+            return -1;
+        }
+
+        constexpr uint8_t kWeekdays = 0x1f; // Monday to Friday
+
+        // 28-31; month is 1-12
+        int daysInMonth(int year, int month)
+        {
+            return month == 12 ? 31
+                               : utils::TimeUtils::daysFromCivil(year, month + 1, 1) -
+                                     utils::TimeUtils::daysFromCivil(year, month, 1);
+        }
+
+        class Parser
+        {
+        public:
+            Parser(std::string_view input, TemporalParser::Result &result)
+                : m_input(input), m_result(result)
+            {
+            }
+
+            void run()
+            {
+                Token previous;
+                std::size_t consumed = 0;
+                std::size_t pos = 0;
+                while (true)
+                {
+                    Token token = lex(m_input, pos);
+                    if (token.kind == TokenKind::End)
+                    {
+                        break;
+                    }
+
+                    // "every monday and friday" names a repetition, not a day
+                    std::size_t end = matchRepetition(token);
+                    if (end == 0)
+                    {
+                        end = matchPeriod(token);
+                    }
+                    if (end != 0)
+                    {
+                        previous = Token();
+                        pos = end;
+                        continue;
+                    }
+
+                    end = match(token);
+                    if (end == 0)
+                    {
+                        previous = token;
+                        pos = token.end;
+                        continue;
+                    }
+
+                    // Take a leading preposition along with the expression
+                    std::size_t begin = token.begin;
+                    if (previous.kind == TokenKind::Word && previous.begin >= consumed &&
+                        (is(m_input, previous, "at") || is(m_input, previous, "on") || is(m_input, previous, "by")))
+                    {
+                        begin = previous.begin;
+                    }
+                    if (m_result.spanCount < TemporalParser::kMaxSpans)
+                    {
+                        m_result.spans[m_result.spanCount++] = {begin, end};
+                    }
+
+                    consumed = end;
+                    previous = Token();
+                    pos = end;
+                }
+            }
+
+            void resolve(std::chrono::system_clock::time_point now)
+            {
+                if (!m_result.found())
+                {
+                    m_result.when = now;
+                    return;
+                }
+
+                const utils::TimeZone &zone = utils::TimeZone::local();
+                const utils::CivilTime base = zone.toCivil(now);
+
+                // Fields may run past their range; fromCivil carries them as mktime would
+                utils::CivilTime civil = base;
+                if (m_month >= 0)
+                {
+                    int year = m_year;
+                    if (year < 0)
+                    {
+                        // The next such day, counting today; February 29th waits for a leap year
+                        year = base.year;
+                        if (m_month + 1 < base.month || (m_month + 1 == base.month && m_day < base.day))
+                        {
+                            year++;
+                        }
+                        while (m_day > daysInMonth(year, m_month + 1))
+                        {
+                            year++;
+                        }
+                    }
+                    civil.year = year;
+                    civil.month = m_month + 1;
+                    civil.day = m_day;
+                }
+                else
+                {
+                    if (m_hasOffset)
+                    {
+                        civil = zone.toCivil(now + std::chrono::minutes(m_minuteOffset));
+                    }
+                    if (m_weekday >= 0)
+                    {
+                        int days = utils::TimeUtils::daysFromCivil(civil.year, civil.month, civil.day);
+                        int sundayFirst = (utils::TimeUtils::weekday(days) + 1) % 7;
+                        int ahead = (m_weekday - sundayFirst + 7) % 7;
+                        if (ahead == 0 && !m_weekdayIncludesToday)
+                        {
+                            ahead = 7;
+                        }
+                        m_dayOffset += ahead;
+                    }
+                    civil.day += m_dayOffset;
+                    civil.month += m_monthOffset;
+                }
+
+                if (m_hour >= 0)
+                {
+                    civil.hour = m_hour;
+                    civil.minute = m_minute;
+                }
+                else if (!m_hasOffset)
+                {
+                    civil.hour = m_defaultHour;
+                    civil.minute = 0;
+                }
+                civil.second = 0;
+                m_result.when = zone.fromCivil(civil);
+
+                // fromCivil clamps, so anything past the clock's range lands outside these years
+                const int year = zone.toCivil(m_result.when).year;
+                if (year < utils::TimeUtils::kMinYear || year > utils::TimeUtils::kMaxYear)
+                {
+                    m_result.outOfRange = true;
+                    m_result.when = now;
+                }
+            }
+
+        private:
+            std::string_view m_input;
+            TemporalParser::Result &m_result;
+
+            // Explicit date; year -1 for the next such day
+            int m_year = -1;
+            int m_month = -1;
+            int m_day = 0;
+            // Relative date
+            int m_dayOffset = 0;
+            int m_monthOffset = 0;
+            int m_weekday = -1;
+            bool m_weekdayIncludesToday = false;
+            // "in ..." counts from now and keeps its time of day, even when zero
+            bool m_hasOffset = false;
+            long m_minuteOffset = 0;
+            // Time of day; 24 is midnight at the end of the day
+            int m_hour = -1;
+            int m_minute = 0;
+            int m_defaultHour = 12;
+
+            // End of the expression starting at token, or 0 if there is none
+            std::size_t match(const Token &token)
+            {
+                std::size_t end = 0;
+                if (!m_result.hasDate && (end = matchIsoDate(token)))
+                {
+                    return end;
+                }
+                if (!m_result.hasDate && (end = matchDayMonth(token)))
+                {
+                    return end;
+                }
+                if (!m_result.hasTime && (end = matchClock(token)))
+                {
+                    return end;
+                }
+                if ((end = matchOffset(token)))
+                {
+                    return end;
+                }
+                return matchWords(token);
+            }
+
+            // 2026-11-02
+            std::size_t matchIsoDate(const Token &year)
+            {
+                if (year.kind != TokenKind::Number || year.size() != 4)
+                {
+                    return 0;
+                }
+                Token dash1 = adjacent(m_input, year);
+                Token month = adjacent(m_input, dash1);
+                Token dash2 = adjacent(m_input, month);
+                Token day = adjacent(m_input, dash2);
+                if (!isSymbol(m_input, dash1, '-') || month.kind != TokenKind::Number || month.size() != 2 ||
+                    !isSymbol(m_input, dash2, '-') || day.kind != TokenKind::Number || day.size() != 2 ||
+                    adjacent(m_input, day).kind == TokenKind::Word)
+                {
+                    return 0;
+                }
+                if (month.value < 1 || month.value > 12 || day.value < 1 ||
+                    day.value > daysInMonth(year.value, month.value))
+                {
+                    return 0;
+                }
+
+                m_year = year.value;
+                m_month = month.value - 1;
+                m_day = day.value;
+                m_result.hasDate = true;
+                return day.end;
+            }
+
+            // Day of the month, with an optional ordinal suffix
+            bool dayNumber(const Token &token, int &day, std::size_t &end)
+            {
+                if (token.kind != TokenKind::Number || token.size() > 2 || token.value < 1 || token.value > 31)
+                {
+                    return false;
+                }
+                day = token.value;
+                end = token.end;
+                Token suffix = adjacent(m_input, token);
+                if (is(m_input, suffix, "st") || is(m_input, suffix, "nd") || is(m_input, suffix, "rd") ||
+                    is(m_input, suffix, "th"))
+                {
+                    end = suffix.end;
+                }
+                else if (suffix.kind == TokenKind::Word)
+                {
+                    return false;
+                }
+                return true;
+            }
+
+            // "Nov 2", "November 2nd, 2027", "2 Nov", "2nd of November"
+            std::size_t matchDayMonth(const Token &token)
+            {
+                int month = monthOf(m_input, token);
+                int day = 0;
+                std::size_t end = 0;
+                if (month >= 0)
+                {
+                    // "may" is usually the verb unless a day follows
+                    if (!dayNumber(lex(m_input, token.end), day, end))
+                    {
+                        return 0;
+                    }
+                }
+                else if (dayNumber(token, day, end))
+                {
+                    Token next = lex(m_input, end);
+                    if (is(m_input, next, "of"))
+                    {
+                        next = lex(m_input, next.end);
+                    }
+                    month = monthOf(m_input, next);
+                    if (month < 0)
+                    {
+                        return 0;
+                    }
+                    end = next.end;
+                }
+                else
+                {
+                    return 0;
+                }
+
+                // Optional year, possibly after a comma
+                Token next = lex(m_input, end);
+                if (isSymbol(m_input, next, ','))
+                {
+                    Token year = lex(m_input, next.end);
+                    if (year.kind == TokenKind::Number && year.size() == 4)
+                    {
+                        next = year;
+                    }
+                }
+                int year = -1;
+                if (next.kind == TokenKind::Number && next.size() == 4)
+                {
+                    year = next.value;
+                    end = next.end;
+                }
+
+                // No such day: "Feb 30", or "Feb 29 2027"; any leap year will do without a year
+                if (day > daysInMonth(year < 0 ? 2000 : year, month + 1))
+                {
+                    return 0;
+                }
+
+                m_year = year;
+                m_month = month;
+                m_day = day;
+                m_result.hasDate = true;
+                return end;
+            }
+
+            // 9:30, 3pm, 9:30 a.m., 7 o'clock
+            std::size_t matchClock(const Token &hour)
+            {
+                if (hour.kind != TokenKind::Number || hour.size() > 2 ||
+                    (hour.begin > 0 && (isAlpha(m_input[hour.begin - 1]) || m_input[hour.begin - 1] == ':')))
+                {
+                    return 0;
+                }
+
+                int minute = 0;
+                bool hasMinutes = false;
+                std::size_t end = hour.end;
+                Token colon = adjacent(m_input, hour);
+                if (isSymbol(m_input, colon, ':'))
+                {
+                    Token minutes = adjacent(m_input, colon);
+                    if (minutes.kind != TokenKind::Number || minutes.size() != 2 || minutes.value > 59)
+                    {
+                        return 0;
+                    }
+                    minute = minutes.value;
+                    hasMinutes = true;
+                    end = minutes.end;
+                }
+
+                // am/pm, a.m./p.m., or o'clock
+                int meridiem = 0; // 1 am, 2 pm
+                Token next = lex(m_input, end);
+                if (is(m_input, next, "am") || is(m_input, next, "pm"))
+                {
+                    meridiem = toLower(m_input[next.begin]) == 'a' ? 1 : 2;
+                    end = next.end;
+                }
+                else if (is(m_input, next, "a") || is(m_input, next, "p"))
+                {
+                    Token dot = adjacent(m_input, next);
+                    Token m = adjacent(m_input, dot);
+                    if (isSymbol(m_input, dot, '.') && is(m_input, m, "m"))
+                    {
+                        meridiem = toLower(m_input[next.begin]) == 'a' ? 1 : 2;
+                        Token dot2 = adjacent(m_input, m);
+                        end = isSymbol(m_input, dot2, '.') ? dot2.end : m.end;
+                    }
+                }
+                else if (is(m_input, next, "o'clock") && !hasMinutes)
+                {
+                    hasMinutes = true;
+                    end = next.end;
+                }
+
+                if (!hasMinutes && meridiem == 0)
+                {
+                    return 0; // A bare number
+                }
+                int h = hour.value;
+                if (meridiem != 0)
+                {
+                    if (h < 1 || h > 12)
+                    {
+                        return 0;
+                    }
+                    h = h % 12 + (meridiem == 2 ? 12 : 0);
+                }
+                else if (h > 23)
+                {
+                    return 0;
+                }
+
+                m_hour = h;
+                m_minute = minute;
+                m_result.hasTime = true;
+                return end;
+            }
+
+            // "in 2 hours", "in an hour", "in 3 weeks"
+            std::size_t matchOffset(const Token &in)
+            {
+                if (!is(m_input, in, "in"))
+                {
+                    return 0;
+                }
+                Token amount = lex(m_input, in.end);
+                int n = 0;
+                if (amount.kind == TokenKind::Number && amount.value <= 10000)
+                {
+                    n = amount.value;
+                }
+                else if (is(m_input, amount, "a") || is(m_input, amount, "an"))
+                {
+                    n = 1;
+                }
+                else
+                {
+                    return 0;
+                }
+
+                Token unit = lex(m_input, amount.end);
+                auto unitIs = [&](std::string_view singular, std::string_view plural)
+                {
+                    return is(m_input, unit, singular) || is(m_input, unit, plural);
+                };
+
+                if ((unitIs("minute", "minutes") || unitIs("min", "mins")) && !m_result.hasTime)
+                {
+                    m_minuteOffset += n;
+                    m_result.hasTime = true;
+                }
+                else if ((unitIs("hour", "hours") || unitIs("hr", "hrs")) && !m_result.hasTime)
+                {
+                    m_minuteOffset += 60L * n;
+                    m_result.hasTime = true;
+                }
+                else if (unitIs("day", "days") && !m_result.hasDate)
+                {
+                    m_dayOffset += n;
+                    m_result.hasDate = true;
+                }
+                else if (unitIs("week", "weeks") && !m_result.hasDate)
+                {
+                    m_dayOffset += 7 * n;
+                    m_result.hasDate = true;
+                }
+                else if (unitIs("month", "months") && !m_result.hasDate)
+                {
+                    m_monthOffset += n;
+                    m_result.hasDate = true;
+                }
+                else
+                {
+                    return 0;
+                }
+                m_hasOffset = true;
+                return unit.end;
+            }
+
+            std::size_t matchWords(const Token &token)
+            {
+                if (token.kind != TokenKind::Word)
+                {
+                    return 0;
+                }
+
+                if (!m_result.hasTime)
+                {
+                    if (is(m_input, token, "noon") || is(m_input, token, "midday"))
+                    {
+                        return setTime(12, token.end);
+                    }
+                    if (is(m_input, token, "midnight"))
+                    {
+                        return setTime(24, token.end);
+                    }
+                }
+
+                if (m_result.hasDate)
+                {
+                    return 0;
+                }
+
+                if (is(m_input, token, "today"))
+                {
+                    return setDayOffset(0, token.end);
+                }
+                if (is(m_input, token, "tonight"))
+                {
+                    m_defaultHour = 20;
+                    return setDayOffset(0, token.end);
+                }
+                if (is(m_input, token, "tomorrow"))
+                {
+                    return setDayOffset(1, token.end);
+                }
+                if (is(m_input, token, "day"))
+                {
+                    Token after = lex(m_input, token.end);
+                    Token tomorrow = lex(m_input, after.end);
+                    if (is(m_input, after, "after") && is(m_input, tomorrow, "tomorrow"))
+                    {
+                        return setDayOffset(2, tomorrow.end);
+                    }
+                    return 0;
+                }
+
+                bool next = is(m_input, token, "next");
+                bool self = is(m_input, token, "this");
+                if (next || self)
+                {
+                    Token what = lex(m_input, token.end);
+                    int weekday = weekdayOf(m_input, what);
+                    if (weekday >= 0)
+                    {
+                        return setWeekday(weekday, self, what.end);
+                    }
+                    if (next && is(m_input, what, "week"))
+                    {
+                        return setDayOffset(7, what.end);
+                    }
+                    if (next && is(m_input, what, "month"))
+                    {
+                        m_monthOffset = 1;
+                        return setDayOffset(0, what.end);
+                    }
+                    if (next && is(m_input, what, "year"))
+                    {
+                        m_monthOffset = 12;
+                        return setDayOffset(0, what.end);
+                    }
+                    return 0;
+                }
+
+                int weekday = weekdayOf(m_input, token);
+                if (weekday >= 0)
+                {
+                    return setWeekday(weekday, false, token.end);
+                }
+                return 0;
+            }
+
+            // "daily", "every other week", "every weekday", "on weekdays", "every mon, wed and fri"
+            std::size_t matchRepetition(const Token &token)
+            {
+                using Frequency = TemporalParser::Repetition::Frequency;
+
+                TemporalParser::Repetition repetition;
+                std::size_t end = token.end;
+                if (is(m_input, token, "daily") || is(m_input, token, "weekly") || is(m_input, token, "monthly"))
+                {
+                    repetition.frequency = is(m_input, token, "daily")    ? Frequency::Daily
+                                           : is(m_input, token, "weekly") ? Frequency::Weekly
+                                                                          : Frequency::Monthly;
+                }
+                else if (is(m_input, token, "on"))
+                {
+                    Token what = lex(m_input, token.end);
+                    if (!is(m_input, what, "weekdays"))
+                    {
+                        return 0;
+                    }
+                    repetition.frequency = Frequency::Weekly;
+                    repetition.days = kWeekdays;
+                    end = what.end;
+                }
+                else if (is(m_input, token, "every"))
+                {
+                    Token what = lex(m_input, token.end);
+                    if (is(m_input, what, "other"))
+                    {
+                        repetition.interval = 2;
+                        what = lex(m_input, what.end);
+                    }
+
+                    if (is(m_input, what, "day") || is(m_input, what, "week") || is(m_input, what, "month"))
+                    {
+                        repetition.frequency = is(m_input, what, "day")    ? Frequency::Daily
+                                               : is(m_input, what, "week") ? Frequency::Weekly
+                                                                           : Frequency::Monthly;
+                        end = what.end;
+                    }
+                    else if (is(m_input, what, "weekday"))
+                    {
+                        repetition.frequency = Frequency::Weekly;
+                        repetition.days = kWeekdays;
+                        end = what.end;
+                    }
+                    else
+                    {
+                        // A list of days: "monday and friday", "mon, wed, and fri"
+                        for (int weekday; (weekday = repeatedWeekdayOf(what)) >= 0;)
+                        {
+                            repetition.days |= 1 << ((weekday + 6) % 7);
+                            end = what.end;
+                            what = lex(m_input, end);
+                            if (isSymbol(m_input, what, ','))
+                            {
+                                what = lex(m_input, what.end);
+                            }
+                            if (is(m_input, what, "and"))
+                            {
+                                what = lex(m_input, what.end);
+                            }
+                        }
+                        if (repetition.days == 0)
+                        {
+                            return 0;
+                        }
+                        repetition.frequency = Frequency::Weekly;
+                    }
+                }
+                else
+                {
+                    return 0;
+                }
+
+                // Only the first counts, but later ones are still not dates
+                if (m_result.repetition.frequency == Frequency::None)
+                {
+                    repetition.span = {token.begin, end};
+                    m_result.repetition = repetition;
+                }
+                return end;
+            }
+
+            // Weekday of "monday" or "mondays"
+            int repeatedWeekdayOf(const Token &token)
+            {
+                int weekday = weekdayOf(m_input, token);
+                if (weekday < 0 && token.kind == TokenKind::Word && token.size() > 3 &&
+                    toLower(m_input[token.end - 1]) == 's')
+                {
+                    Token singular = token;
+                    singular.end--;
+                    weekday = weekdayOf(m_input, singular);
+                }
+                return weekday;
+            }
+
+            // "last 3 days", "past 10 days"
+            std::size_t matchPeriod(const Token &token)
+            {
+                if (!is(m_input, token, "last") && !is(m_input, token, "past"))
+                {
+                    return 0;
+                }
+                Token count = lex(m_input, token.end);
+                Token unit = lex(m_input, count.end);
+                if (count.kind != TokenKind::Number || count.size() > 3 ||
+                    !(is(m_input, unit, "day") || is(m_input, unit, "days")))
+                {
+                    return 0;
+                }
+                if (m_result.lastDays == 0)
+                {
+                    m_result.lastDays = std::max(1, count.value);
+                }
+                return unit.end;
+            }
+
+            std::size_t setTime(int hour, std::size_t end)
+            {
+                m_hour = hour;
+                m_minute = 0;
+                m_result.hasTime = true;
+                return end;
+            }
+
+            std::size_t setDayOffset(int days, std::size_t end)
+            {
+                m_dayOffset = days;
+                m_result.hasDate = true;
+                return end;
+            }
+
+            std::size_t setWeekday(int weekday, bool includesToday, std::size_t end)
+            {
+                m_weekday = weekday;
+                m_weekdayIncludesToday = includesToday;
+                m_result.hasDate = true;
+                return end;
+            }
+        };
+    } // namespace
+
+    TemporalParser::Result TemporalParser::parse(std::string_view input, std::chrono::system_clock::time_point now)
+    {
+        Result result;
+        Parser parser(input, result);
+        parser.run();
+        parser.resolve(now);
+        return result;
+    }
+
+} // namespace tarius::ai_secretary
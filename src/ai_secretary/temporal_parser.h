@@ -0,0 +1,78 @@
+#pragma once
+
+#include "intent_classifier.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace tarius::ai_secretary
+{
+    /**
+     * @brief Hand-written parser for dates and times in free text.
+     *
+     * Understands ISO dates ("2026-11-02"), month names ("Nov 2nd",
+     * "2 November 2027"), relative days ("today", "tonight", "tomorrow",
+     * "day after tomorrow", "next week", "next month"), weekdays ("Tuesday",
+     * "this Friday", "next Tuesday"), offsets ("in 2 hours", "in a week") and
+     * clock times ("9:30", "3pm", "9:30 a.m.", "noon", "midnight"). It also
+     * picks out a repetition ("every other week", "daily", "on weekdays",
+     * "every Monday and Friday") and a trailing period ("last 3 days"),
+     * which leave the resolved time alone. Days that don't exist, such as
+     * "Feb 30" or "2027-02-29", are not read as dates.
+     *
+     * The input is tokenized lazily and walked once; nothing is copied or
+     * allocated. The result carries the resolved local time and the spans
+     * that were consumed, including a leading "at"/"on"/"by", so callers can
+     * cut them out of the text.
+     */
+    class TemporalParser
+    {
+    public:
+        using Span = IntentClassifier::Span;
+
+        static constexpr std::size_t kMaxSpans = 4;
+
+        struct Repetition
+        {
+            enum class Frequency
+            {
+                None,
+                Daily,
+                Weekly,
+                Monthly
+            };
+
+            Frequency frequency = Frequency::None;
+            int interval = 1;  // 2 for "every other"
+            uint8_t days = 0;  // Weekday bits, Monday = 1 << 0; Weekly only
+            Span span;         // The whole phrase, e.g. "every Monday and Friday"
+        };
+
+        struct Result
+        {
+            bool hasDate = false; // A day was named
+            bool hasTime = false; // A time of day was named, or an offset in minutes or hours
+            // What was named lies outside TimeUtils::kMinYear-kMaxYear; when is now
+            bool outOfRange = false;
+            // Resolved time: a day without a time is at noon, a time without a
+            // day is today, and an offset ("in 3 days", "in 0 minutes") keeps
+            // now's time of day. Always on a whole minute. now if nothing was
+            // found.
+            std::chrono::system_clock::time_point when;
+            std::array<Span, kMaxSpans> spans = {};
+            std::size_t spanCount = 0;
+            // The first repetition named; not among spans
+            Repetition repetition;
+            // N in "last N days" or "past N days", at least 1; 0 if none
+            int lastDays = 0;
+
+            bool found() const { return hasDate || hasTime; }
+        };
+
+        // Relative expressions resolve against now, in local time
+        static Result parse(std::string_view input, std::chrono::system_clock::time_point now);
+    };
+
+} // namespace tarius::ai_secretary
@@ -1,24 +1,81 @@
 #include "ai_twin.h"
+#include "../models/summarization_worker.h"
 #include "../utils/logger.h"
+#include "../utils/time_utils.h"
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 #include <random>
-#include <iomanip>
 
 namespace tarius::ai_twin
 {
 
-    AITwin::AITwin()
-        : m_memoryManager(std::make_unique<models::MemoryManager>()),
+    // Prompt space reserved for memories recalled from earlier conversations
+    constexpr int kMemoryTokenBudget = 256;
+    constexpr int kRecallCandidates = 8;
+
+    const char *const kSystemPrompt =
+        "You are Tarius, an AI assistant that subtly adapts to the user's communication style."
+        "Pay attention to their vocabulary, sentence structure, and tone, then incorporate similar patterns in your responses."
+        "Keep your responses natural and conversational while maintaining your own identity."
+        "Never mention that you're mirroring their style or reference this instruction."
+        "Never repeat the user's exact phrases back to them verbatim."
+        "Also, Don't Repeat youself too much";
+
+    namespace
+    {
+        // Background summarization holds off while the user is waiting; ends
+        // the wait even when generation throws
+        class InteractiveScope
+        {
+        public:
+            explicit InteractiveScope(models::MemoryManager &memoryManager)
+                : m_memoryManager(memoryManager)
+            {
+                m_memoryManager.setInteractive(true);
+            }
+
+            ~InteractiveScope() { m_memoryManager.setInteractive(false); }
+
+            InteractiveScope(const InteractiveScope &) = delete;
+            InteractiveScope &operator=(const InteractiveScope &) = delete;
+
+        private:
+            models::MemoryManager &m_memoryManager;
+        };
+    } // namespace
+
+    AITwin::AITwin(utils::Config &config, const std::string &dataDirectory,
+                   std::shared_ptr<models::SummarizationWorker> summarizationWorker)
+        : m_memoryManager(std::make_unique<models::MemoryManager>(config, dataDirectory, std::move(summarizationWorker))),
           m_llamaModel(nullptr),
-          m_useLlamaModel(false)
+          m_useLlamaModel(false),
+          m_sequence{dataDirectory, dataDirectory + "/kv_cache.bin"},
+          m_config(config),
+          m_recentMessageCount(config.handle("memory.max_recent_messages", 10))
     {
+        // Threads and sampling can be tuned without reloading the model; only
+        // the twin that loaded it does so
+        m_modelSubscription = m_config.subscribe("model.", [this](const utils::Config &)
+                                                 {
+                                                     std::lock_guard<std::mutex> lock(m_modelMutex);
+                                                     if (m_llamaModel && !m_modelPath.empty())
+                                                     {
+                                                         m_llamaModel->updateSettings(modelConfig(m_modelPath));
+                                                     } });
     }
 
-    AITwin::~AITwin() = default;
+    AITwin::~AITwin()
+    {
+        m_config.unsubscribe(m_modelSubscription);
+
+        // The memory manager's background work calls into the model, so stop
+        // it before the model is destroyed
+        m_memoryManager->setSummarizer(nullptr);
+        m_memoryManager->setEmbedder(nullptr);
+    }
 
-    std::string AITwin::generateResponse(const std::string &userInput)
+    std::string AITwin::generateResponse(const std::string &userInput, const models::LlamaModel::TokenCallback &onToken)
     {
         // Log the user input
         m_memoryManager->addMessage("user", userInput);
@@ -30,12 +87,18 @@ namespace tarius::ai_twin
         {
             LOG_INFO("Generating response using LlamaModel");
             std::string prompt = createPrompt(userInput);
-            response = m_llamaModel->generate(prompt);
+
+            InteractiveScope interactive(*m_memoryManager);
+            response = m_llamaModel->generate(prompt, kSystemPrompt, onToken, m_sequence);
         }
         else
         {
             LOG_INFO("Generating simple response");
             response = generateSimpleResponse(userInput);
+            if (onToken)
+            {
+                onToken(response);
+            }
         }
 
         // Log the AI response
@@ -44,29 +107,64 @@ namespace tarius::ai_twin
         return response;
     }
 
+    std::vector<std::string> AITwin::generateResponses(const std::vector<std::string> &userInputs)
+    {
+        std::vector<std::string> responses;
+
+        if (m_useLlamaModel && m_llamaModel && m_llamaModel->isInitialized())
+        {
+            LOG_INFO("Generating {} responses using LlamaModel", userInputs.size());
+
+            // Every prompt sees the same history
+            std::vector<std::string> prompts;
+            prompts.reserve(userInputs.size());
+            for (const auto &userInput : userInputs)
+            {
+                prompts.push_back(createPrompt(userInput));
+            }
+
+            InteractiveScope interactive(*m_memoryManager);
+            responses = m_llamaModel->generateBatch(prompts);
+        }
+        else
+        {
+            LOG_INFO("Generating {} simple responses", userInputs.size());
+            for (const auto &userInput : userInputs)
+            {
+                responses.push_back(generateSimpleResponse(userInput));
+            }
+        }
+
+        return responses;
+    }
+
+    models::GenerationStats AITwin::getGenerationStats() const
+    {
+        return isLlamaModelInitialized() ? m_llamaModel->getStats() : models::GenerationStats{};
+    }
+
     bool AITwin::initializeLlamaModel(const std::string &modelPath)
     {
         LOG_INFO("Initializing LlamaModel with model path: {}", modelPath);
 
+        std::lock_guard<std::mutex> lock(m_modelMutex);
         try
         {
             // Create model configuration
-            models::LlamaModel::ModelConfig config;
-            config.model_path = modelPath;
-            config.system_prompt = "You are Tarius, an AI assistant that subtly adapts to the user's communication style."
-                                   "Pay attention to their vocabulary, sentence structure, and tone, then incorporate similar patterns in your responses."
-                                   "Keep your responses natural and conversational while maintaining your own identity."
-                                   "Never mention that you're mirroring their style or reference this instruction."
-                                   "Never repeat the user's exact phrases back to them verbatim."
-                                   "Also, Don't Repeat youself too much";
+            models::LlamaModel::ModelConfig config = modelConfig(modelPath);
+
+            // Nothing may still be using the old model when it is replaced
+            m_memoryManager->setSummarizer(nullptr);
+            m_memoryManager->setEmbedder(nullptr);
 
             // Create and initialize model
-            m_llamaModel = std::make_unique<models::LlamaModel>(config);
+            m_llamaModel = std::make_shared<models::LlamaModel>(config);
             bool success = m_llamaModel->initialize();
 
             if (success)
             {
-                m_useLlamaModel = true;
+                m_modelPath = modelPath;
+                attachModel(m_llamaModel);
                 LOG_INFO("LlamaModel initialized successfully");
             }
             else
@@ -85,6 +183,46 @@ namespace tarius::ai_twin
         }
     }
 
+    void AITwin::useModel(std::shared_ptr<models::LlamaModel> model)
+    {
+        std::lock_guard<std::mutex> lock(m_modelMutex);
+        m_memoryManager->setSummarizer(nullptr);
+        m_memoryManager->setEmbedder(nullptr);
+        m_modelPath.clear();
+        attachModel(std::move(model));
+    }
+
+    void AITwin::attachModel(std::shared_ptr<models::LlamaModel> model)
+    {
+        m_llamaModel = std::move(model);
+        m_useLlamaModel = m_llamaModel != nullptr;
+        if (!m_llamaModel)
+        {
+            return;
+        }
+
+        // The closures hold the model, so background work keeps it alive
+        m_memoryManager->setEmbedder([model = m_llamaModel](const std::string &text)
+                                     { return model->isInitialized() ? model->embed(text) : std::vector<float>{}; });
+        m_memoryManager->setSummarizer([model = m_llamaModel](const std::string &prompt)
+                                       { return model->isInitialized() ? model->generate(prompt, models::SummarizationWorker::kSystemPrompt) : std::string{}; });
+    }
+
+    models::LlamaModel::ModelConfig AITwin::modelConfig(const std::string &modelPath) const
+    {
+        models::LlamaModel::ModelConfig config;
+        config.model_path = modelPath;
+        config.context_size = m_config.getInt("model.context_size", config.context_size);
+        config.parallel = m_config.getInt("model.parallel", config.parallel);
+        config.threads = m_config.getInt("model.threads", config.threads);
+        config.n_predict = m_config.getInt("model.n_predict", config.n_predict);
+        config.temperature = static_cast<float>(m_config.getDouble("model.temperature", config.temperature));
+        config.top_k = m_config.getInt("model.top_k", config.top_k);
+        config.top_p = static_cast<float>(m_config.getDouble("model.top_p", config.top_p));
+        config.system_prompt = kSystemPrompt;
+        return config;
+    }
+
     bool AITwin::isLlamaModelInitialized() const
     {
         return m_useLlamaModel && m_llamaModel && m_llamaModel->isInitialized();
@@ -137,18 +275,13 @@ namespace tarius::ai_twin
 
         if (input.find("time") != std::string::npos)
         {
-            time_t current_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-            std::stringstream ss;
-            ss << "The current time is " << std::put_time(std::localtime(&current_time), "%H:%M:%S");
-            return ss.str();
+            // The clock part of YYYY-MM-DDTHH:MM:SS
+            return "The current time is " + utils::TimeUtils::formatIsoDateTime(std::chrono::system_clock::now()).substr(11);
         }
 
         if (input.find("date") != std::string::npos)
         {
-            time_t current_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-            std::stringstream ss;
-            ss << "Today's date is " << std::put_time(std::localtime(&current_time), "%Y-%m-%d");
-            return ss.str();
+            return "Today's date is " + utils::TimeUtils::formatIsoDate(std::chrono::system_clock::now());
         }
 
         if (input.find("joke") != std::string::npos)
@@ -188,10 +321,23 @@ namespace tarius::ai_twin
         return defaultResponses[distrib(gen)];
     }
 
+    int AITwin::estimateTokens(const std::string &text)
+    {
+        if (isLlamaModelInitialized())
+        {
+            int tokens = m_llamaModel->countTokens(text);
+            if (tokens >= 0)
+            {
+                return tokens;
+            }
+        }
+        return static_cast<int>(text.length() / 4) + 1; // Rough estimate
+    }
+
     std::string AITwin::createPrompt(const std::string &userInput)
     {
         // Get recent conversation history
-        auto recentMessages = m_memoryManager->getRecentMessages(5);
+        auto recentMessages = m_memoryManager->getRecentMessages(m_recentMessageCount.get());
 
         std::stringstream prompt;
 
@@ -200,6 +346,58 @@ namespace tarius::ai_twin
         //        << "Engage naturally, mirroring their tone, pace, and lingo. "
         //        << "Keep responses conversational, relevant, and fluid.\n\n";
 
+        // Pull in older memories related to what the user is talking about:
+        // semantic recall first, then keyword matches, until the budget is spent
+        std::vector<std::string> memories;
+        for (const auto &recalled : m_memoryManager->recall(userInput, kRecallCandidates))
+        {
+            memories.push_back(recalled.isSummary ? "Summary: " + recalled.text : recalled.text);
+        }
+        for (const auto &result : m_memoryManager->search(userInput, kRecallCandidates))
+        {
+            memories.push_back((result.message.speaker == "user" ? "User: " : "Tarius: ") + result.message.content);
+        }
+
+        int budget = kMemoryTokenBudget;
+        std::vector<std::string> included;
+        for (const auto &memory : memories)
+        {
+            // Skip anything already covered by the recent history or this turn;
+            // an empty message covers nothing
+            auto endsWith = [&memory](const std::string &suffix)
+            {
+                return !suffix.empty() && memory.size() >= suffix.size() &&
+                       memory.compare(memory.size() - suffix.size(), std::string::npos, suffix) == 0;
+            };
+            bool duplicate = std::find(included.begin(), included.end(), memory) != included.end() ||
+                             endsWith(userInput) ||
+                             std::any_of(recentMessages.begin(), recentMessages.end(),
+                                         [&endsWith](const models::Message &msg)
+                                         { return endsWith(msg.content); });
+            if (duplicate)
+            {
+                continue;
+            }
+
+            int cost = estimateTokens(memory);
+            if (cost > budget)
+            {
+                continue;
+            }
+            budget -= cost;
+            included.push_back(memory);
+        }
+
+        if (!included.empty())
+        {
+            prompt << "Relevant things from earlier conversations:\n";
+            for (const auto &memory : included)
+            {
+                prompt << "- " << memory << "\n";
+            }
+            prompt << "\n";
+        }
+
         // Add conversation history to the prompt
         for (const auto &msg : recentMessages)
         {
@@ -2,8 +2,11 @@
 
 #include "../models/memory_manager.h"
 #include "../models/llama_model.h"
+#include "../utils/config.h"
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace tarius::ai_twin
 {
@@ -11,17 +14,47 @@ namespace tarius::ai_twin
     class AITwin
     {
     public:
-        AITwin();
+        // Conversation memory, and the model's KV cache for it when evicted,
+        // are kept under dataDirectory. Background summaries run on
+        // summarizationWorker when given, else on a worker of its own.
+        explicit AITwin(utils::Config &config, const std::string &dataDirectory = "data",
+                        std::shared_ptr<models::SummarizationWorker> summarizationWorker = nullptr);
         ~AITwin();
 
-        std::string generateResponse(const std::string &userInput);
+        // onToken, if set, gets the response piece by piece as it is generated
+        std::string generateResponse(const std::string &userInput,
+                                     const models::LlamaModel::TokenCallback &onToken = nullptr);
+
+        // Responses to several independent turns, generated together. Each
+        // sees the history as it stands and none is added to it, so a reply
+        // doesn't depend on which others it was generated with.
+        std::vector<std::string> generateResponses(const std::vector<std::string> &userInputs);
         bool initializeLlamaModel(const std::string &modelPath);
         bool isLlamaModelInitialized() const;
 
+        // Share a model another twin loaded, or pass nullptr to stop using one.
+        // Settings changes are applied by the twin that loaded it.
+        void useModel(std::shared_ptr<models::LlamaModel> model);
+        std::shared_ptr<models::LlamaModel> getModel() const { return m_llamaModel; }
+
+        models::MemoryManager *getMemoryManager() const { return m_memoryManager.get(); }
+        models::GenerationStats getGenerationStats() const;
+
     private:
         std::unique_ptr<models::MemoryManager> m_memoryManager;
-        std::unique_ptr<models::LlamaModel> m_llamaModel;
+        std::shared_ptr<models::LlamaModel> m_llamaModel;
         bool m_useLlamaModel;
+        std::string m_modelPath; // Empty unless this twin loaded the model
+        models::LlamaModel::CachedSequence m_sequence; // This conversation's KV cache on the model
+        std::mutex m_modelMutex; // Held while the model is replaced or retuned
+
+        // Model settings follow the config while the app runs
+        utils::Config &m_config;
+        std::size_t m_modelSubscription;
+        utils::Config::Handle<int> m_recentMessageCount;
+
+        models::LlamaModel::ModelConfig modelConfig(const std::string &modelPath) const;
+        void attachModel(std::shared_ptr<models::LlamaModel> model); // Caller holds m_modelMutex
 
         // For MVP, we'll use a simple approach to generate responses
         // when the LLM is not available
@@ -29,6 +62,7 @@ namespace tarius::ai_twin
 
         // Helper methods
         std::string createPrompt(const std::string &userInput);
+        int estimateTokens(const std::string &text);
     };
 
 } // namespace tarius::ai_twin
\ No newline at end of file
@@ -1,50 +1,199 @@
 #include "app_controller.h"
+#include "../models/summarization_worker.h"
 #include "../utils/logger.h"
+#include "../utils/tracer.h"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 
 namespace tarius::app
 {
+    namespace
+    {
+        constexpr std::size_t kMaxSessionIdLength = 64;
+    } // namespace
 
-    AppController::AppController()
-        : m_aiTwin(std::make_unique<ai_twin::AITwin>()), m_aiSecretary(std::make_unique<ai_secretary::AISecretary>())
+    AppController::AppController(utils::Config &config)
+        : m_config(config),
+          m_summarizationWorker(std::make_shared<models::SummarizationWorker>()),
+          m_defaultSession(std::make_shared<Session>("", "data", config, m_summarizationWorker)),
+          m_useClock(0)
     {
+        // Reminders arrive on the scheduler thread while the prompt is waiting for input
+        m_defaultSession->setReminderHandler([](const std::string &reminder)
+                                             {
+            std::cout << "\nTarius Reminder: " << reminder << std::endl;
+            std::cout << "You: " << std::flush; });
     }
 
     AppController::~AppController() = default;
 
     std::string AppController::processUserInput(const std::string &input)
     {
+        TRACE_SCOPE("app.process_input");
         LOG_INFO("Processing user input: {}", input);
+        return m_defaultSession->processInput(input);
+    }
+
+    std::string AppController::processUserInput(const std::string &sessionId, const std::string &input,
+                                                const models::LlamaModel::TokenCallback &onToken)
+    {
+        TRACE_SCOPE("app.process_input");
+        LOG_INFO("Processing input for session '{}': {}", sessionId, input);
+        return getSession(sessionId)->processInput(input, onToken);
+    }
+
+    bool AppController::isValidSessionId(const std::string &sessionId)
+    {
+        if (sessionId.size() > kMaxSessionIdLength)
+        {
+            return false;
+        }
+        for (char c : sessionId)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::shared_ptr<Session> AppController::getSession(const std::string &sessionId)
+    {
+        if (sessionId.empty())
+        {
+            return m_defaultSession;
+        }
+
+        std::shared_ptr<Session> closing;
+        {
+            std::unique_lock<std::mutex> lock(m_sessionsMutex);
+            m_sessionsChanged.wait(lock, [&]()
+                                   {
+                auto it = m_sessions.find(sessionId);
+                return m_closingSessions.count(sessionId) == 0 && (it == m_sessions.end() || it->second.session); });
+            m_useClock++;
+
+            auto it = m_sessions.find(sessionId);
+            if (it != m_sessions.end())
+            {
+                it->second.lastUsed = m_useClock;
+                return it->second.session;
+            }
 
-        // Check if this is a secretary task (scheduling, reminders, etc.)
-        if (m_aiSecretary->isSecretaryTask(input))
+            // Close the least recently used session nobody is using to make room.
+            // Its KV cache stays on the model until another session needs the space.
+            std::size_t maxOpen = static_cast<std::size_t>(std::max(1, m_config.getInt("sessions.max_open", 16)));
+            if (m_sessions.size() >= maxOpen)
+            {
+                auto oldest = m_sessions.end();
+                for (auto candidate = m_sessions.begin(); candidate != m_sessions.end(); ++candidate)
+                {
+                    bool idle = candidate->second.session.use_count() == 1;
+                    if (idle && (oldest == m_sessions.end() || candidate->second.lastUsed < oldest->second.lastUsed))
+                    {
+                        oldest = candidate;
+                    }
+                }
+                if (oldest != m_sessions.end())
+                {
+                    // Its id stays reserved until it is saved
+                    closing = std::move(oldest->second.session);
+                    m_closingSessions.insert(oldest->first);
+                    m_sessions.erase(oldest);
+                }
+            }
+
+            // Reserve the id; other requests for it wait until it is open
+            m_sessions[sessionId] = {nullptr, m_useClock};
+        }
+
+        if (closing)
+        {
+            std::string closingId = closing->id();
+            LOG_INFO("Closing idle session '{}'", closingId);
+            closing.reset();
+            {
+                std::lock_guard<std::mutex> lock(m_sessionsMutex);
+                m_closingSessions.erase(closingId);
+            }
+            m_sessionsChanged.notify_all();
+        }
+
+        LOG_INFO("Opening session '{}'", sessionId);
+        std::shared_ptr<Session> session;
+        try
+        {
+            session = std::make_shared<Session>(sessionId, "data/sessions/" + sessionId, m_config,
+                                                m_summarizationWorker);
+        }
+        catch (...)
         {
-            return m_aiSecretary->handleTask(input);
+            {
+                std::lock_guard<std::mutex> lock(m_sessionsMutex);
+                m_sessions.erase(sessionId);
+            }
+            m_sessionsChanged.notify_all();
+            throw;
         }
+        session->holdReminders();
 
-        // Otherwise, treat as a conversation with the AI twin
-        return m_aiTwin->generateResponse(input);
+        {
+            // Under the lock, so a model loaded meanwhile reaches this session too
+            std::lock_guard<std::mutex> lock(m_sessionsMutex);
+            session->useModel(m_defaultSession->twin().getModel());
+            m_sessions[sessionId].session = session;
+        }
+        m_sessionsChanged.notify_all();
+        return session;
     }
 
-    void AppController::checkReminders()
+    std::vector<std::string> AppController::takeReminders(const std::string &sessionId)
     {
-        auto reminders = m_aiSecretary->getActiveReminders();
-        for (const auto &reminder : reminders)
+        std::shared_ptr<Session> session;
         {
-            std::cout << "\nTarius Reminder: " << reminder << std::endl;
-            std::cout << "You: ";
+            std::lock_guard<std::mutex> lock(m_sessionsMutex);
+            auto it = m_sessions.find(sessionId);
+            if (it == m_sessions.end() || !it->second.session)
+            {
+                return {};
+            }
+            session = it->second.session;
         }
+        return session->takeReminders();
     }
 
     bool AppController::initializeLlamaModel(const std::string &modelPath)
     {
         LOG_INFO("Initializing LlamaModel from AppController with model path: {}", modelPath);
-        return m_aiTwin->initializeLlamaModel(modelPath);
+        bool success = m_defaultSession->loadModel(modelPath);
+
+        // Open sessions move to the new model too
+        std::lock_guard<std::mutex> lock(m_sessionsMutex);
+        for (auto &[id, open] : m_sessions)
+        {
+            if (open.session)
+            {
+                open.session->useModel(m_defaultSession->twin().getModel());
+            }
+        }
+        return success;
     }
 
     bool AppController::isLlamaModelInitialized() const
     {
-        return m_aiTwin->isLlamaModelInitialized();
+        return m_defaultSession->twin().isLlamaModelInitialized();
+    }
+
+    models::MemoryStats AppController::getMemoryStats() const
+    {
+        return m_defaultSession->twin().getMemoryManager()->getStats();
+    }
+
+    models::GenerationStats AppController::getGenerationStats() const
+    {
+        return m_defaultSession->twin().getGenerationStats();
     }
 
-} // namespace tarius::app
\ No newline at end of file
+} // namespace tarius::app
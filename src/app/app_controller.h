@@ -1,9 +1,14 @@
 #pragma once
 
-#include "../ai_twin/ai_twin.h"
-#include "../ai_secretary/ai_secretary.h"
+#include "session.h"
+#include "../utils/config.h"
+#include <condition_variable>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace tarius::app
 {
@@ -11,19 +16,55 @@ namespace tarius::app
     class AppController
     {
     public:
-        AppController();
+        explicit AppController(utils::Config &config);
         ~AppController();
 
         std::string processUserInput(const std::string &input);
-        void checkReminders();
+
+        // Same, for the session named sessionId ("" is the default one, kept
+        // under data/ and shared with the interactive prompt). Other sessions
+        // live under data/sessions/<id>. onToken streams the reply and returns
+        // false to cancel it.
+        std::string processUserInput(const std::string &sessionId, const std::string &input,
+                                     const models::LlamaModel::TokenCallback &onToken);
+
+        // Reminders that fell due in an open session other than the default
+        // since they were last taken; the default session prints its own
+        std::vector<std::string> takeReminders(const std::string &sessionId);
+
+        // Letters, digits, '-' and '_', up to 64 characters; "" is the default
+        static bool isValidSessionId(const std::string &sessionId);
 
         // LlamaModel integration
         bool initializeLlamaModel(const std::string &modelPath);
         bool isLlamaModelInitialized() const;
 
+        // Hit rates and sizes of the conversation and summary caches
+        models::MemoryStats getMemoryStats() const;
+
+        // Responses and tokens the model has produced since it was loaded
+        models::GenerationStats getGenerationStats() const;
+
     private:
-        std::unique_ptr<ai_twin::AITwin> m_aiTwin;
-        std::unique_ptr<ai_secretary::AISecretary> m_aiSecretary;
+        struct OpenSession
+        {
+            std::shared_ptr<Session> session; // Copied out for each turn; null while it opens
+            uint64_t lastUsed;
+        };
+
+        utils::Config &m_config;
+        std::shared_ptr<models::SummarizationWorker> m_summarizationWorker; // Shared by every session
+        std::shared_ptr<Session> m_defaultSession;                          // Loads and owns the model
+
+        // Sessions are opened and closed outside the mutex; requests for one
+        // that is opening or still being saved wait on m_sessionsChanged
+        std::unordered_map<std::string, OpenSession> m_sessions;
+        std::unordered_set<std::string> m_closingSessions;
+        uint64_t m_useClock;
+        std::mutex m_sessionsMutex;
+        std::condition_variable m_sessionsChanged;
+
+        std::shared_ptr<Session> getSession(const std::string &sessionId);
     };
 
-} // namespace tarius::app
\ No newline at end of file
+} // namespace tarius::app
@@ -0,0 +1,182 @@
+#include "batch_runner.h"
+#include "../utils/logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace tarius::app
+{
+    namespace
+    {
+        // Inputs handed to the controller at once, per parallel sequence; a
+        // few per sequence keep the batch full while short replies finish
+        constexpr int kChunkPerSequence = 8;
+
+        // A fresh directory for this run under the system's temporary directory
+        std::string temporaryDirectory()
+        {
+            namespace fs = std::filesystem;
+            std::error_code ec;
+            fs::path base = fs::temp_directory_path(ec);
+            if (ec)
+            {
+                base = "/tmp";
+            }
+            fs::path directory = base / ("tarius-batch-" + std::to_string(getpid()));
+            fs::remove_all(directory, ec);
+            return directory.string();
+        }
+    } // namespace
+
+    BatchRunner::BatchRunner(utils::Config &config, const std::string &dataDirectory)
+        : m_config(config),
+          m_dataDirectory(dataDirectory.empty() ? temporaryDirectory() : dataDirectory),
+          m_temporary(dataDirectory.empty()),
+          m_summarizationWorker(std::make_shared<models::SummarizationWorker>())
+    {
+        LOG_INFO("Batch data directory: {}{}", m_dataDirectory, m_temporary ? " (temporary)" : "");
+        m_session = std::make_unique<Session>("batch", m_dataDirectory, config, m_summarizationWorker);
+    }
+
+    BatchRunner::~BatchRunner()
+    {
+        // The session saves on the way out, so it goes before its directory
+        m_session.reset();
+        if (m_temporary)
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(m_dataDirectory, ec);
+        }
+    }
+
+    bool BatchRunner::run(const std::string &inputPath, const std::string &outputPath)
+    {
+        std::ifstream in(inputPath);
+        if (!in.is_open())
+        {
+            LOG_ERROR("Failed to open batch input: {}", inputPath);
+            return false;
+        }
+        std::ofstream out(outputPath, std::ios::trunc);
+        if (!out.is_open())
+        {
+            LOG_ERROR("Failed to open batch output: {}", outputPath);
+            return false;
+        }
+
+        // Canned replies are no use for a regression run
+        if (!m_session->loadModel(m_config.getString("model.path")))
+        {
+            LOG_ERROR("Batch mode needs a model, and it failed to load");
+            return false;
+        }
+
+        std::size_t chunkSize = static_cast<std::size_t>(std::max(1, m_config.getInt("model.parallel", 1))) * kChunkPerSequence;
+        LOG_INFO("Running batch {} -> {} in chunks of {}", inputPath, outputPath, chunkSize);
+
+        auto started = std::chrono::steady_clock::now();
+        models::GenerationStats before = m_session->twin().getGenerationStats();
+
+        std::vector<json> records;
+        std::vector<std::string> inputs;
+        std::vector<std::size_t> inputRecords; // Index into records of each input
+        std::size_t processed = 0;
+        std::size_t failed = 0;
+
+        auto flushChunk = [&]()
+        {
+            std::vector<std::string> responses;
+            if (!inputs.empty())
+            {
+                responses = m_session->processInputs(inputs);
+            }
+            for (std::size_t i = 0; i < inputRecords.size(); i++)
+            {
+                records[inputRecords[i]]["response"] = std::move(responses[i]);
+            }
+            for (const auto &record : records)
+            {
+                out << record.dump() << '\n';
+            }
+            out.flush();
+
+            processed += inputs.size();
+            records.clear();
+            inputs.clear();
+            inputRecords.clear();
+        };
+
+        std::string line;
+        std::size_t lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+
+            json record;
+            try
+            {
+                record = json::parse(line);
+            }
+            catch (const json::parse_error &e)
+            {
+                LOG_WARN("Skipping batch line {}: {}", lineNumber, e.what());
+                records.push_back({{"line", lineNumber}, {"error", e.what()}});
+                failed++;
+                continue;
+            }
+
+            auto input = record.is_object() ? record.find("input") : record.end();
+            if (!record.is_object() || input == record.end() || !input->is_string())
+            {
+                LOG_WARN("Skipping batch line {}: no \"input\" string", lineNumber);
+                records.push_back({{"line", lineNumber}, {"error", "expected an object with an \"input\" string"}});
+                failed++;
+                continue;
+            }
+
+            inputs.push_back(input->get<std::string>());
+            inputRecords.push_back(records.size());
+            records.push_back(std::move(record));
+            if (inputs.size() >= chunkSize)
+            {
+                flushChunk();
+            }
+        }
+        flushChunk();
+
+        if (!out)
+        {
+            LOG_ERROR("Failed to write batch output: {}", outputPath);
+            return false;
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        models::GenerationStats after = m_session->twin().getGenerationStats();
+        uint64_t promptTokens = after.promptTokens - before.promptTokens;
+        uint64_t generatedTokens = after.generatedTokens - before.generatedTokens;
+        seconds = std::max(seconds, 1e-9);
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Batch: " << processed << " inputs (" << failed << " bad lines) in " << seconds << " s, "
+                  << processed / seconds << " inputs/s; " << promptTokens << " prompt tokens ("
+                  << promptTokens / seconds << "/s), " << generatedTokens << " generated tokens ("
+                  << generatedTokens / seconds << "/s)" << std::endl;
+        LOG_INFO("Batch finished: {} inputs, {} bad lines, {:.1f} s, {} prompt tokens, {} generated tokens", processed,
+                 failed, seconds, promptTokens, generatedTokens);
+        return true;
+    }
+
+} // namespace tarius::app
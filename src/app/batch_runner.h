@@ -0,0 +1,43 @@
+#pragma once
+
+#include "session.h"
+#include "../models/summarization_worker.h"
+#include "../utils/config.h"
+#include <string>
+#include <memory>
+
+namespace tarius::app
+{
+    /**
+     * @brief Runs a JSONL file of inputs through a session of its own, no terminal needed.
+     *
+     * Each input line is a JSON object with an "input" string. It is copied
+     * to the output with a "response" added, or with an "error" when the line
+     * can't be used, keeping the input order. Inputs are handed over in
+     * chunks so chat turns share the model's decode steps, and throughput is
+     * printed when the run ends.
+     *
+     * The session keeps its data under dataDirectory, or under a temporary
+     * directory removed afterwards, never under the interactive data/. Every
+     * chat input starts from the history found there and none is added to
+     * it, so a reply doesn't depend on the chunk size. Scheduling and
+     * reminder inputs still run in input order against that root.
+     */
+    class BatchRunner
+    {
+    public:
+        BatchRunner(utils::Config &config, const std::string &dataDirectory = "");
+        ~BatchRunner();
+
+        // false if a file can't be opened or the model doesn't load
+        bool run(const std::string &inputPath, const std::string &outputPath);
+
+    private:
+        utils::Config &m_config;
+        std::string m_dataDirectory;
+        bool m_temporary; // m_dataDirectory is ours to remove
+        std::shared_ptr<models::SummarizationWorker> m_summarizationWorker;
+        std::unique_ptr<Session> m_session;
+    };
+
+} // namespace tarius::app
@@ -1,8 +1,9 @@
 #include "cli_interface.h"
 #include "../utils/logger.h"
+#include "../utils/tracer.h"
+#include <iomanip>
 #include <iostream>
 #include <string>
-#include <thread>
 #include <chrono>
 #include <sstream>
 #include <filesystem>
@@ -10,8 +11,8 @@
 namespace tarius::app
 {
 
-    CLIInterface::CLIInterface()
-        : m_controller(std::make_unique<AppController>()), m_running(false)
+    CLIInterface::CLIInterface(utils::Config &config)
+        : m_config(config), m_controller(std::make_unique<AppController>(config)), m_running(false)
     {
     }
 
@@ -20,8 +21,8 @@ namespace tarius::app
     void CLIInterface::run()
     {
         m_running = true;
-        // load in the default model
-        bool success = m_controller->initializeLlamaModel("./models/Dolphin3.0-Llama3.2-1B-Q4_K_M.gguf");
+        // load in the configured model
+        bool success = m_controller->initializeLlamaModel(m_config.getString("model.path"));
 
         if (success)
         {
@@ -34,14 +35,6 @@ namespace tarius::app
 
         displayWelcome();
 
-        // Start a background thread for checking reminders and scheduled tasks
-        std::thread reminderThread([this]()
-                                   {
-        while (m_running) {
-            m_controller->checkReminders();
-            std::this_thread::sleep_for(std::chrono::seconds(60)); // Check every minute
-        } });
-
         // Main input loop
         std::string input;
         while (m_running)
@@ -67,12 +60,6 @@ namespace tarius::app
                 }
             }
         }
-
-        // Wait for reminder thread to finish
-        if (reminderThread.joinable())
-        {
-            reminderThread.join();
-        }
     }
 
     bool CLIInterface::processSpecialCommand(const std::string &input)
@@ -134,6 +121,58 @@ namespace tarius::app
             }
             return true;
         }
+        else if (cmd == "memory_stats")
+        {
+            models::MemoryStats stats = m_controller->getMemoryStats();
+            auto print = [](const char *name, const models::CacheStats &cache)
+            {
+                uint64_t lookups = cache.hits + cache.misses;
+                double hitRate = lookups ? 100.0 * cache.hits / lookups : 0.0;
+                std::cout << "  " << name << ": " << cache.entries << " entries, "
+                          << cache.bytes / 1024 << " / " << cache.capacityBytes / 1024 << " KiB, "
+                          << cache.hits << " hits, " << cache.misses << " misses ("
+                          << std::fixed << std::setprecision(1) << hitRate << "% hit rate), "
+                          << cache.evictions << " evictions" << std::endl;
+            };
+            std::cout << "Tarius: Memory cache statistics:" << std::endl;
+            print("Conversations", stats.conversations);
+            print("Summaries", stats.summaries);
+            return true;
+        }
+        else if (cmd == "trace")
+        {
+            std::string action;
+            iss >> action;
+
+            if (action == "start")
+            {
+                utils::Tracer::start();
+                std::cout << "Tarius: Tracing started. Use /trace stop to write the trace." << std::endl;
+            }
+            else if (action == "stop")
+            {
+                std::string tracePath = "logs/trace.json";
+                iss >> tracePath;
+
+                utils::Tracer::stop();
+                std::size_t spans = 0;
+                if (utils::Tracer::writeChromeTrace(tracePath, spans))
+                {
+                    std::cout << "Tarius: Wrote " << spans << " spans to " << tracePath
+                              << " (open it in chrome://tracing or ui.perfetto.dev)." << std::endl;
+                }
+                else
+                {
+                    std::cout << "Tarius: Failed to write the trace. Please check the logs for details." << std::endl;
+                }
+            }
+            else
+            {
+                std::cout << "Tarius: Tracing is " << (utils::Tracer::isActive() ? "on" : "off") << "." << std::endl;
+                std::cout << "Usage: /trace start | /trace stop [output.json]" << std::endl;
+            }
+            return true;
+        }
 
         return false;
     }
@@ -161,6 +200,8 @@ namespace tarius::app
         std::cout << "  exit/quit - Exit the application" << std::endl;
         std::cout << "  /load_model [path_to_model] - Load a LLaMA model from the specified path" << std::endl;
         std::cout << "  /model_status - Check if the LLaMA model is active" << std::endl;
+        std::cout << "  /memory_stats - Show conversation and summary cache statistics" << std::endl;
+        std::cout << "  /trace start|stop [file] - Record timing spans and write them as a Chrome trace" << std::endl;
         std::cout << std::endl;
         std::cout << "You can also:" << std::endl;
         std::cout << "  - Chat naturally with your AI twin" << std::endl;
@@ -11,7 +11,7 @@ namespace tarius::app
     class CLIInterface
     {
     public:
-        CLIInterface();
+        explicit CLIInterface(utils::Config &config);
         ~CLIInterface();
 
         void run();
@@ -22,6 +22,7 @@ namespace tarius::app
         void displayHelp();
         bool processSpecialCommand(const std::string &input); // Returns true if command was processed
 
+        utils::Config &m_config;
         std::unique_ptr<AppController> m_controller;
         std::atomic<bool> m_running;
     };
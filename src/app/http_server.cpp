@@ -0,0 +1,919 @@
+#include "http_server.h"
+#include "../utils/logger.h"
+#include "../utils/tracer.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace tarius::app
+{
+    namespace
+    {
+        // epoll keys below the first connection id
+        constexpr uint64_t kListenKey = 0;
+        constexpr uint64_t kWakeKey = 1;
+
+        constexpr std::size_t kMaxHeaderBytes = 16 * 1024;
+        constexpr std::size_t kMaxBodyBytes = 1024 * 1024;
+        constexpr std::size_t kMaxOutputBytes = 1024 * 1024; // Unsent reply to a client that stopped reading
+        constexpr std::size_t kMaxConnections = 256;
+        constexpr std::size_t kMaxQueuedJobs = 64;
+        constexpr int kMaxEvents = 64;
+
+        const char *reasonPhrase(int status)
+        {
+            switch (status)
+            {
+            case 200:
+                return "OK";
+            case 400:
+                return "Bad Request";
+            case 404:
+                return "Not Found";
+            case 405:
+                return "Method Not Allowed";
+            case 413:
+                return "Payload Too Large";
+            case 431:
+                return "Request Header Fields Too Large";
+            case 500:
+                return "Internal Server Error";
+            case 501:
+                return "Not Implemented";
+            case 503:
+                return "Service Unavailable";
+            default:
+                return "Error";
+            }
+        }
+
+        // Model output can end mid-character; never let that fail a reply
+        std::string toJson(const json &value)
+        {
+            return value.dump(-1, ' ', false, json::error_handler_t::replace);
+        }
+
+        std::string lowercase(std::string text)
+        {
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                           { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        std::string trim(const std::string &text)
+        {
+            auto first = text.find_first_not_of(" \t");
+            if (first == std::string::npos)
+            {
+                return "";
+            }
+            auto last = text.find_last_not_of(" \t");
+            return text.substr(first, last - first + 1);
+        }
+
+        std::string sseEvent(const char *event, const json &data)
+        {
+            std::string out;
+            if (event)
+            {
+                out += "event: ";
+                out += event;
+                out += '\n';
+            }
+            out += "data: ";
+            out += toJson(data);
+            out += "\n\n";
+            return out;
+        }
+    } // namespace
+
+    struct HttpServer::Connection
+    {
+        uint64_t id;
+        int fd;
+        std::string in;
+        std::string out;
+
+        bool keepAlive = true;
+        bool busy = false; // A chat turn is in flight; later requests wait
+        bool streaming = false;
+        bool closeAfterWrite = false;
+        bool failed = false;
+        bool watchingWrite = false;
+
+        std::string session;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    HttpServer::HttpServer(AppController &controller, utils::Config &config)
+        : m_controller(controller), m_config(config),
+          m_epollFd(epoll_create1(EPOLL_CLOEXEC)), m_listenFd(-1),
+          m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_stopping(false),
+          m_nextConnectionId(kWakeKey + 1), m_workersStopping(false)
+    {
+        if (m_epollFd < 0 || m_wakeFd < 0)
+        {
+            LOG_ERROR("Failed to create server event loop: {}", std::strerror(errno));
+            return;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kWakeKey;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+    }
+
+    HttpServer::~HttpServer()
+    {
+        for (auto &[id, connection] : m_connections)
+        {
+            close(connection->fd);
+        }
+        if (m_listenFd >= 0)
+        {
+            close(m_listenFd);
+        }
+        if (!m_unixPath.empty())
+        {
+            unlink(m_unixPath.c_str());
+        }
+        if (m_wakeFd >= 0)
+        {
+            close(m_wakeFd);
+        }
+        if (m_epollFd >= 0)
+        {
+            close(m_epollFd);
+        }
+    }
+
+    bool HttpServer::listenTcp(int port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            LOG_ERROR("Failed to create server socket: {}", std::strerror(errno));
+            return false;
+        }
+
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        // Local clients only
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            LOG_ERROR("Failed to bind 127.0.0.1:{}: {}", port, std::strerror(errno));
+            close(fd);
+            return false;
+        }
+
+        if (!setUpListener(fd))
+        {
+            return false;
+        }
+        LOG_INFO("Listening on http://127.0.0.1:{}", port);
+        return true;
+    }
+
+    bool HttpServer::listenUnix(const std::string &path)
+    {
+        sockaddr_un address{};
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+        {
+            LOG_ERROR("Unix socket path is empty or too long: {}", path);
+            return false;
+        }
+
+        // A socket left behind by an earlier run would make bind fail
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0)
+        {
+            if (!S_ISSOCK(info.st_mode))
+            {
+                LOG_ERROR("Refusing to replace {}, which is not a socket", path);
+                return false;
+            }
+            unlink(path.c_str());
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            LOG_ERROR("Failed to create server socket: {}", std::strerror(errno));
+            return false;
+        }
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        // Conversations are private to the user running the server, so the
+        // socket is created owner-only rather than narrowed after the fact
+        mode_t previousMask = umask(077);
+        int bound = bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        int bindError = errno;
+        umask(previousMask);
+        if (bound < 0)
+        {
+            LOG_ERROR("Failed to bind {}: {}", path, std::strerror(bindError));
+            close(fd);
+            return false;
+        }
+        m_unixPath = path;
+
+        if (!setUpListener(fd))
+        {
+            return false;
+        }
+        LOG_INFO("Listening on unix:{}", path);
+        return true;
+    }
+
+    bool HttpServer::setUpListener(int fd)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kListenKey;
+        if (listen(fd, SOMAXCONN) < 0 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            LOG_ERROR("Failed to listen: {}", std::strerror(errno));
+            close(fd);
+            return false;
+        }
+        m_listenFd = fd;
+        return true;
+    }
+
+    void HttpServer::run()
+    {
+        if (m_listenFd < 0)
+        {
+            LOG_ERROR("Server has no listening socket");
+            return;
+        }
+
+        int workers = std::max(1, m_config.getInt("server.workers", 2));
+        for (int i = 0; i < workers; i++)
+        {
+            m_workers.emplace_back(&HttpServer::workerLoop, this);
+        }
+        LOG_INFO("Server running with {} workers", workers);
+
+        epoll_event events[kMaxEvents];
+        while (!m_stopping.load(std::memory_order_acquire))
+        {
+            int count = epoll_wait(m_epollFd, events, kMaxEvents, -1);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                LOG_ERROR("epoll_wait failed: {}", std::strerror(errno));
+                break;
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                uint64_t key = events[i].data.u64;
+                if (key == kListenKey)
+                {
+                    acceptConnections();
+                    continue;
+                }
+                if (key == kWakeKey)
+                {
+                    uint64_t value;
+                    while (read(m_wakeFd, &value, sizeof(value)) > 0)
+                    {
+                    }
+                    deliverEvents();
+                    continue;
+                }
+
+                auto it = m_connections.find(key);
+                if (it == m_connections.end())
+                {
+                    continue; // Closed earlier in this batch
+                }
+                Connection &connection = *it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    closeConnection(key);
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+                {
+                    readFrom(connection);
+                }
+                updateInterest(connection);
+            }
+        }
+
+        LOG_INFO("Server stopping");
+
+        // Turns in progress stop at their next token
+        {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            m_workersStopping = true;
+            m_jobs.clear();
+        }
+        for (auto &[id, connection] : m_connections)
+        {
+            if (connection->cancelled)
+            {
+                connection->cancelled->store(true);
+            }
+        }
+        m_jobsCv.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+
+        std::vector<uint64_t> ids;
+        for (const auto &[id, connection] : m_connections)
+        {
+            ids.push_back(id);
+        }
+        for (uint64_t id : ids)
+        {
+            closeConnection(id);
+        }
+    }
+
+    void HttpServer::stop()
+    {
+        m_stopping.store(true, std::memory_order_release);
+        wake();
+    }
+
+    void HttpServer::wake()
+    {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeFd, &one, sizeof(one));
+        (void)written; // Fails only when the counter is already nonzero
+    }
+
+    void HttpServer::workerLoop()
+    {
+        utils::Tracer::setThreadName("http-worker");
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_jobsMutex);
+                m_jobsCv.wait(lock, [this]()
+                              { return m_workersStopping || !m_jobs.empty(); });
+                if (m_workersStopping)
+                {
+                    return;
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            bool stream = job.stream;
+            auto onToken = [&](const std::string &piece)
+            {
+                if (stream && !piece.empty())
+                {
+                    post({job.connectionId, Event::Kind::Token, piece});
+                }
+                return !job.cancelled->load(std::memory_order_relaxed);
+            };
+
+            try
+            {
+                std::string response = m_controller.processUserInput(job.session, job.input, onToken);
+                post({job.connectionId, Event::Kind::Done, std::move(response)});
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Chat turn failed: {}", e.what());
+                post({job.connectionId, Event::Kind::Failed, e.what()});
+            }
+        }
+    }
+
+    void HttpServer::post(Event event)
+    {
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(m_outboxMutex);
+            first = m_outbox.empty();
+            m_outbox.push_back(std::move(event));
+        }
+        // The loop takes the whole outbox per wakeup
+        if (first)
+        {
+            wake();
+        }
+    }
+
+    void HttpServer::acceptConnections()
+    {
+        while (true)
+        {
+            int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    LOG_WARN("accept failed: {}", std::strerror(errno));
+                }
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+
+            if (m_connections.size() >= kMaxConnections)
+            {
+                LOG_WARN("Too many connections, refusing one");
+                close(fd);
+                continue;
+            }
+
+            // Tokens go out as soon as they are made; fails harmlessly on Unix sockets
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+            auto connection = std::make_unique<Connection>();
+            connection->id = m_nextConnectionId++;
+            connection->fd = fd;
+
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.u64 = connection->id;
+            if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+            {
+                LOG_WARN("Failed to watch connection: {}", std::strerror(errno));
+                close(fd);
+                continue;
+            }
+            m_connections.emplace(connection->id, std::move(connection));
+        }
+    }
+
+    void HttpServer::readFrom(Connection &connection)
+    {
+        char buffer[16 * 1024];
+        while (true)
+        {
+            ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received > 0)
+            {
+                connection.in.append(buffer, static_cast<std::size_t>(received));
+                if (connection.in.size() > kMaxHeaderBytes + kMaxBodyBytes)
+                {
+                    connection.failed = true; // Piling up requests behind a turn
+                    return;
+                }
+                continue;
+            }
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+
+            // Closed or broken; a turn in flight is abandoned
+            connection.failed = true;
+            return;
+        }
+
+        handleRequests(connection);
+    }
+
+    void HttpServer::handleRequests(Connection &connection)
+    {
+        while (!connection.busy && !connection.closeAfterWrite && !connection.failed)
+        {
+            std::size_t headerEnd = connection.in.find("\r\n\r\n");
+            if (headerEnd == std::string::npos)
+            {
+                if (connection.in.size() > kMaxHeaderBytes)
+                {
+                    connection.keepAlive = false;
+                    sendResponse(connection, 431, toJson({{"error", "request headers too large"}}));
+                }
+                return;
+            }
+            if (headerEnd > kMaxHeaderBytes)
+            {
+                connection.keepAlive = false;
+                sendResponse(connection, 431, toJson({{"error", "request headers too large"}}));
+                return;
+            }
+
+            std::string head = connection.in.substr(0, headerEnd);
+            std::size_t lineEnd = head.find("\r\n");
+            std::string requestLine = head.substr(0, lineEnd);
+
+            std::size_t methodEnd = requestLine.find(' ');
+            std::size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : requestLine.find(' ', methodEnd + 1);
+            if (targetEnd == std::string::npos)
+            {
+                connection.keepAlive = false;
+                sendResponse(connection, 400, toJson({{"error", "malformed request line"}}));
+                return;
+            }
+            std::string method = requestLine.substr(0, methodEnd);
+            std::string target = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+            std::string version = requestLine.substr(targetEnd + 1);
+            if (version.rfind("HTTP/1.", 0) != 0)
+            {
+                connection.keepAlive = false;
+                sendResponse(connection, 400, toJson({{"error", "unsupported HTTP version"}}));
+                return;
+            }
+
+            connection.keepAlive = version != "HTTP/1.0";
+            std::size_t contentLength = 0;
+            bool chunked = false;
+            bool badLength = false;
+            std::size_t pos = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+            while (pos < head.size())
+            {
+                std::size_t next = head.find("\r\n", pos);
+                if (next == std::string::npos)
+                {
+                    next = head.size();
+                }
+                std::string line = head.substr(pos, next - pos);
+                pos = next + 2;
+
+                std::size_t colon = line.find(':');
+                if (colon == std::string::npos)
+                {
+                    continue;
+                }
+                std::string name = lowercase(trim(line.substr(0, colon)));
+                std::string value = trim(line.substr(colon + 1));
+                if (name == "content-length")
+                {
+                    try
+                    {
+                        std::size_t used = 0;
+                        contentLength = std::stoull(value, &used);
+                        badLength = used != value.size();
+                    }
+                    catch (const std::exception &)
+                    {
+                        badLength = true;
+                    }
+                }
+                else if (name == "transfer-encoding")
+                {
+                    chunked = true;
+                }
+                else if (name == "connection")
+                {
+                    std::string option = lowercase(value);
+                    if (option == "close")
+                    {
+                        connection.keepAlive = false;
+                    }
+                    else if (option == "keep-alive")
+                    {
+                        connection.keepAlive = true;
+                    }
+                }
+            }
+
+            if (badLength || chunked || contentLength > kMaxBodyBytes)
+            {
+                // The body can't be skipped safely, so the connection ends here
+                connection.keepAlive = false;
+                if (chunked)
+                {
+                    sendResponse(connection, 501, toJson({{"error", "chunked request bodies are not supported"}}));
+                }
+                else if (badLength)
+                {
+                    sendResponse(connection, 400, toJson({{"error", "invalid Content-Length"}}));
+                }
+                else
+                {
+                    sendResponse(connection, 413, toJson({{"error", "request body too large"}}));
+                }
+                return;
+            }
+
+            std::size_t bodyStart = headerEnd + 4;
+            if (connection.in.size() - bodyStart < contentLength)
+            {
+                return; // Wait for the rest of the body
+            }
+            std::string body = connection.in.substr(bodyStart, contentLength);
+            connection.in.erase(0, bodyStart + contentLength);
+
+            std::size_t query = target.find('?');
+            if (query != std::string::npos)
+            {
+                target.resize(query);
+            }
+            handleRequest(connection, method, target, body);
+        }
+    }
+
+    void HttpServer::handleRequest(Connection &connection, const std::string &method, const std::string &target,
+                                   const std::string &body)
+    {
+        TRACE_SCOPE("http.request");
+        LOG_DEBUG("{} {}", method, target);
+
+        if (target == "/v1/health")
+        {
+            if (method != "GET")
+            {
+                sendResponse(connection, 405, toJson({{"error", "use GET"}}));
+                return;
+            }
+            sendResponse(connection, 200,
+                         toJson({{"status", "ok"}, {"model_loaded", m_controller.isLlamaModelInitialized()}}));
+            return;
+        }
+
+        if (target == "/v1/chat")
+        {
+            if (method != "POST")
+            {
+                sendResponse(connection, 405, toJson({{"error", "use POST"}}));
+                return;
+            }
+            handleChat(connection, body);
+            return;
+        }
+
+        sendResponse(connection, 404, toJson({{"error", "not found"}}));
+    }
+
+    void HttpServer::handleChat(Connection &connection, const std::string &body)
+    {
+        json request = json::parse(body, nullptr, false);
+        if (request.is_discarded() || !request.is_object())
+        {
+            sendResponse(connection, 400, toJson({{"error", "body must be a JSON object"}}));
+            return;
+        }
+
+        auto input = request.find("input");
+        if (input == request.end() || !input->is_string())
+        {
+            sendResponse(connection, 400, toJson({{"error", "expected an \"input\" string"}}));
+            return;
+        }
+
+        std::string session;
+        auto sessionField = request.find("session");
+        if (sessionField != request.end())
+        {
+            if (!sessionField->is_string() || !AppController::isValidSessionId(sessionField->get<std::string>()))
+            {
+                sendResponse(connection, 400,
+                             toJson({{"error", "\"session\" must be up to 64 letters, digits, '-' or '_'"}}));
+                return;
+            }
+            session = sessionField->get<std::string>();
+        }
+
+        bool stream = false;
+        auto streamField = request.find("stream");
+        if (streamField != request.end())
+        {
+            if (!streamField->is_boolean())
+            {
+                sendResponse(connection, 400, toJson({{"error", "\"stream\" must be true or false"}}));
+                return;
+            }
+            stream = streamField->get<bool>();
+        }
+
+        Job job{connection.id, session, input->get<std::string>(), stream, std::make_shared<std::atomic<bool>>(false)};
+        {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            if (m_jobs.size() >= kMaxQueuedJobs)
+            {
+                sendResponse(connection, 503, toJson({{"error", "too many requests queued"}}));
+                return;
+            }
+            m_jobs.push_back(job);
+        }
+        m_jobsCv.notify_one();
+
+        connection.busy = true;
+        connection.streaming = stream;
+        connection.session = session;
+        connection.cancelled = job.cancelled;
+        if (stream)
+        {
+            // The stream's end is marked by closing the connection
+            connection.keepAlive = false;
+            queueOutput(connection, "HTTP/1.1 200 OK\r\n"
+                                    "Content-Type: text/event-stream\r\n"
+                                    "Cache-Control: no-cache\r\n"
+                                    "Connection: close\r\n\r\n");
+        }
+    }
+
+    void HttpServer::deliverEvents()
+    {
+        std::vector<Event> events;
+        {
+            std::lock_guard<std::mutex> lock(m_outboxMutex);
+            events.swap(m_outbox);
+        }
+
+        std::vector<uint64_t> touched;
+        for (Event &event : events)
+        {
+            auto it = m_connections.find(event.connectionId);
+            if (it == m_connections.end())
+            {
+                continue; // The client went away
+            }
+            Connection &connection = *it->second;
+            touched.push_back(connection.id);
+
+            if (event.kind == Event::Kind::Token)
+            {
+                queueOutput(connection, sseEvent(nullptr, {{"token", event.text}}));
+                continue;
+            }
+
+            connection.busy = false;
+            connection.cancelled.reset();
+            bool failed = event.kind == Event::Kind::Failed;
+            // Reminders that fell due since the session's last reply ride along with this one
+            std::vector<std::string> reminders;
+            if (!failed)
+            {
+                reminders = m_controller.takeReminders(connection.session);
+            }
+            if (connection.streaming)
+            {
+                connection.closeAfterWrite = true;
+                if (failed)
+                {
+                    queueOutput(connection, sseEvent("error", {{"error", event.text}}));
+                }
+                else
+                {
+                    for (const auto &reminder : reminders)
+                    {
+                        queueOutput(connection, sseEvent("reminder", {{"reminder", reminder}}));
+                    }
+                    queueOutput(connection,
+                                sseEvent("done", {{"session", connection.session}, {"response", event.text}}));
+                }
+            }
+            else if (failed)
+            {
+                sendResponse(connection, 500, toJson({{"error", event.text}}));
+            }
+            else
+            {
+                json reply = {{"session", connection.session}, {"response", event.text}};
+                if (!reminders.empty())
+                {
+                    reply["reminders"] = reminders;
+                }
+                sendResponse(connection, 200, toJson(reply));
+            }
+            connection.streaming = false;
+
+            // Requests that arrived during the turn
+            handleRequests(connection);
+        }
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        for (uint64_t id : touched)
+        {
+            updateInterest(*m_connections.at(id));
+        }
+    }
+
+    void HttpServer::sendResponse(Connection &connection, int status, const std::string &body)
+    {
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reasonPhrase(status) + "\r\n" +
+                               "Content-Type: application/json\r\n" +
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                               (connection.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n") +
+                               "\r\n" + body;
+        queueOutput(connection, response);
+        if (!connection.keepAlive)
+        {
+            connection.closeAfterWrite = true;
+        }
+    }
+
+    void HttpServer::queueOutput(Connection &connection, const std::string &data)
+    {
+        if (connection.failed)
+        {
+            return;
+        }
+        // A client that stops reading would otherwise have its whole reply buffered
+        // here; drop it, which also cancels its turn
+        if (connection.out.size() + data.size() > kMaxOutputBytes)
+        {
+            LOG_WARN("Closing a connection with {} bytes it has not read", connection.out.size());
+            connection.failed = true;
+            connection.out.clear();
+            return;
+        }
+        connection.out += data;
+    }
+
+    void HttpServer::flush(Connection &connection)
+    {
+        std::size_t sent = 0;
+        while (sent < connection.out.size())
+        {
+            ssize_t n = send(connection.fd, connection.out.data() + sent, connection.out.size() - sent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                sent += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            connection.failed = true;
+            break;
+        }
+        connection.out.erase(0, sent);
+    }
+
+    // Write what can be written, then close the connection or adjust what
+    // epoll watches for. Every path that touches a connection ends here.
+    void HttpServer::updateInterest(Connection &connection)
+    {
+        if (!connection.failed)
+        {
+            flush(connection);
+        }
+        if (connection.failed || (connection.closeAfterWrite && connection.out.empty()))
+        {
+            closeConnection(connection.id);
+            return;
+        }
+
+        bool wantWrite = !connection.out.empty();
+        if (wantWrite != connection.watchingWrite)
+        {
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            event.data.u64 = connection.id;
+            epoll_ctl(m_epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.watchingWrite = wantWrite;
+        }
+    }
+
+    void HttpServer::closeConnection(uint64_t connectionId)
+    {
+        auto it = m_connections.find(connectionId);
+        if (it == m_connections.end())
+        {
+            return;
+        }
+        Connection &connection = *it->second;
+        if (connection.cancelled)
+        {
+            connection.cancelled->store(true, std::memory_order_relaxed);
+        }
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        close(connection.fd);
+        m_connections.erase(it);
+    }
+
+} // namespace tarius::app
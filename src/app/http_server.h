@@ -0,0 +1,126 @@
+#pragma once
+
+#include "app_controller.h"
+#include "../utils/config.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tarius::app
+{
+    /**
+     * @brief Local HTTP/1.1 front end for the controller, on 127.0.0.1 or a Unix socket.
+     *
+     * One thread runs an epoll loop over non-blocking sockets: it accepts,
+     * parses requests and writes replies. Chat turns are queued to a small
+     * pool of workers (server.workers), which hand tokens and replies back
+     * through an outbox and an eventfd wakeup, so connections cost no
+     * threads of their own.
+     *
+     *   GET  /v1/health
+     *   POST /v1/chat  {"session": "alice", "input": "...", "stream": true}
+     *
+     * A streamed chat answers with Server-Sent Events: one {"token": ...}
+     * event per piece of text, then a "done" event with the whole response,
+     * and the connection closes. Otherwise the reply is one JSON object and
+     * the connection is kept alive. Reminders that fell due in the session
+     * since its last reply are sent with the next one, as "reminder" events
+     * or a "reminders" array. A client that disconnects, or leaves more
+     * than a megabyte of reply unread, cancels its turn.
+     */
+    class HttpServer
+    {
+    public:
+        HttpServer(AppController &controller, utils::Config &config);
+        ~HttpServer();
+
+        HttpServer(const HttpServer &) = delete;
+        HttpServer &operator=(const HttpServer &) = delete;
+
+        // Listen on 127.0.0.1:port, or on a Unix socket at path. Call one
+        // of these once, before run().
+        bool listenTcp(int port);
+        bool listenUnix(const std::string &path);
+
+        // Serve until stop(); waits for in-flight turns to wind down
+        void run();
+
+        // Safe to call from a signal handler
+        void stop();
+
+    private:
+        struct Connection;
+
+        struct Job
+        {
+            uint64_t connectionId;
+            std::string session;
+            std::string input;
+            bool stream;
+            std::shared_ptr<std::atomic<bool>> cancelled;
+        };
+
+        // Sent from a worker to the event loop
+        struct Event
+        {
+            enum class Kind
+            {
+                Token,
+                Done,
+                Failed
+            };
+
+            uint64_t connectionId;
+            Kind kind;
+            std::string text;
+        };
+
+        AppController &m_controller;
+        utils::Config &m_config;
+
+        int m_epollFd;
+        int m_listenFd;
+        int m_wakeFd; // eventfd; wakes the loop for the outbox and stop()
+        std::string m_unixPath;
+        std::atomic<bool> m_stopping;
+
+        std::unordered_map<uint64_t, std::unique_ptr<Connection>> m_connections;
+        uint64_t m_nextConnectionId;
+
+        std::deque<Job> m_jobs;
+        std::mutex m_jobsMutex;
+        std::condition_variable m_jobsCv;
+        bool m_workersStopping;
+        std::vector<std::thread> m_workers;
+
+        std::vector<Event> m_outbox;
+        std::mutex m_outboxMutex;
+
+        bool setUpListener(int fd);
+        void workerLoop();
+        void post(Event event);
+        void wake();
+
+        void acceptConnections();
+        void readFrom(Connection &connection);
+        void handleRequests(Connection &connection);
+        void handleRequest(Connection &connection, const std::string &method, const std::string &target,
+                           const std::string &body);
+        void handleChat(Connection &connection, const std::string &body);
+        void deliverEvents();
+
+        void sendResponse(Connection &connection, int status, const std::string &body);
+        void queueOutput(Connection &connection, const std::string &data);
+        void flush(Connection &connection);
+        void updateInterest(Connection &connection);
+        void closeConnection(uint64_t connectionId);
+    };
+
+} // namespace tarius::app
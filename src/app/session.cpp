@@ -0,0 +1,116 @@
+#include "session.h"
+#include "../utils/logger.h"
+
+namespace tarius::app
+{
+    namespace
+    {
+        constexpr std::size_t kMaxHeldReminders = 100;
+    } // namespace
+
+    Session::Session(const std::string &id, const std::string &dataRoot, utils::Config &config,
+                     std::shared_ptr<models::SummarizationWorker> summarizationWorker)
+        : m_id(id),
+          m_dataRoot(dataRoot),
+          m_twin(std::make_unique<ai_twin::AITwin>(config, dataRoot, std::move(summarizationWorker))),
+          m_secretary(std::make_unique<ai_secretary::AISecretary>(dataRoot))
+    {
+        // Summary requests read this session's conversation history
+        m_secretary->setMemoryManager(m_twin->getMemoryManager());
+    }
+
+    Session::~Session() = default;
+
+    std::string Session::processInput(const std::string &input, const models::LlamaModel::TokenCallback &onToken)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Check if this is a secretary task (scheduling, reminders, etc.)
+        auto intent = m_secretary->classify(input);
+        if (intent.intent != ai_secretary::IntentClassifier::Intent::None)
+        {
+            std::string response = m_secretary->handleTask(input, intent);
+            if (onToken)
+            {
+                onToken(response);
+            }
+            return response;
+        }
+
+        // Otherwise, treat as a conversation with the AI twin
+        return m_twin->generateResponse(input, onToken);
+    }
+
+    std::vector<std::string> Session::processInputs(const std::vector<std::string> &inputs)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Secretary tasks are handled in order; the rest go to the twin together
+        std::vector<std::string> responses(inputs.size());
+        std::vector<std::string> chats;
+        std::vector<std::size_t> chatIndices;
+        for (std::size_t i = 0; i < inputs.size(); i++)
+        {
+            auto intent = m_secretary->classify(inputs[i]);
+            if (intent.intent != ai_secretary::IntentClassifier::Intent::None)
+            {
+                responses[i] = m_secretary->handleTask(inputs[i], intent);
+            }
+            else
+            {
+                chats.push_back(inputs[i]);
+                chatIndices.push_back(i);
+            }
+        }
+
+        if (!chats.empty())
+        {
+            std::vector<std::string> replies = m_twin->generateResponses(chats);
+            for (std::size_t i = 0; i < chatIndices.size(); i++)
+            {
+                responses[chatIndices[i]] = std::move(replies[i]);
+            }
+        }
+
+        return responses;
+    }
+
+    bool Session::loadModel(const std::string &modelPath)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_twin->initializeLlamaModel(modelPath);
+    }
+
+    void Session::useModel(std::shared_ptr<models::LlamaModel> model)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_twin->useModel(std::move(model));
+    }
+
+    void Session::setReminderHandler(ai_secretary::ReminderScheduler::Handler handler)
+    {
+        m_secretary->setReminderHandler(std::move(handler));
+    }
+
+    void Session::holdReminders()
+    {
+        m_secretary->setReminderHandler([this](const std::string &reminder)
+                                        {
+            std::lock_guard<std::mutex> lock(m_remindersMutex);
+            if (m_heldReminders.size() >= kMaxHeldReminders)
+            {
+                LOG_WARN("Dropping undelivered reminder for session '{}': {}", m_id, m_heldReminders.front());
+                m_heldReminders.pop_front();
+            }
+            m_heldReminders.push_back(reminder); });
+    }
+
+    std::vector<std::string> Session::takeReminders()
+    {
+        std::lock_guard<std::mutex> lock(m_remindersMutex);
+        std::vector<std::string> reminders(m_heldReminders.begin(), m_heldReminders.end());
+        m_heldReminders.clear();
+        return reminders;
+    }
+
+} // namespace tarius::app
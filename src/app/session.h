@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../ai_twin/ai_twin.h"
+#include "../ai_secretary/ai_secretary.h"
+#include "../utils/config.h"
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tarius::app
+{
+    /**
+     * @brief One person's conversation with Tarius.
+     *
+     * A session keeps its conversation memory, calendar and task list under
+     * its own data root, and its own KV-cache sequence on the model, so the
+     * people served by one process never see each other's history. Sessions
+     * share the loaded model and the background summarization worker. Turns
+     * within a session run one at a time.
+     */
+    class Session
+    {
+    public:
+        Session(const std::string &id, const std::string &dataRoot, utils::Config &config,
+                std::shared_ptr<models::SummarizationWorker> summarizationWorker);
+        ~Session();
+
+        const std::string &id() const { return m_id; }
+        const std::string &dataRoot() const { return m_dataRoot; }
+
+        // A secretary task or a chat turn; onToken, if set, streams the reply
+        std::string processInput(const std::string &input,
+                                 const models::LlamaModel::TokenCallback &onToken = nullptr);
+
+        // Independent inputs at once; chat turns share the model's decode
+        // steps and are not added to the conversation history
+        std::vector<std::string> processInputs(const std::vector<std::string> &inputs);
+
+        // Load a model owned by this session, or share one loaded by another
+        bool loadModel(const std::string &modelPath);
+        void useModel(std::shared_ptr<models::LlamaModel> model);
+
+        // Called from the scheduler thread as each event starts or task falls due
+        void setReminderHandler(ai_secretary::ReminderScheduler::Handler handler);
+
+        // Keep reminders for takeReminders() instead, for clients that only
+        // hear from Tarius in reply to a request. The oldest are dropped past
+        // a limit.
+        void holdReminders();
+        std::vector<std::string> takeReminders();
+
+        const ai_twin::AITwin &twin() const { return *m_twin; }
+
+    private:
+        std::string m_id;
+        std::string m_dataRoot;
+        std::deque<std::string> m_heldReminders; // Outlives the scheduler that fills it
+        std::mutex m_remindersMutex;
+        std::unique_ptr<ai_twin::AITwin> m_twin;
+        std::unique_ptr<ai_secretary::AISecretary> m_secretary; // Reads the twin's memory, so declared after it
+        std::mutex m_mutex;                                     // Held for a turn
+    };
+
+} // namespace tarius::app
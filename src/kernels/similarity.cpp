@@ -0,0 +1,608 @@
+#include "similarity.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TARIUS_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define TARIUS_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace tarius::kernels
+{
+    namespace
+    {
+        struct KernelTable
+        {
+            Isa isa;
+            float (*dotF32)(const float *, const float *, std::size_t);
+            float (*dotF16)(const fp16_t *, const fp16_t *, std::size_t);
+            int32_t (*dotI8)(const int8_t *, const int8_t *, std::size_t);
+        };
+
+        // ---- Scalar ----
+
+        float dotF32Scalar(const float *a, const float *b, std::size_t n)
+        {
+            float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                s0 += a[i] * b[i];
+                s1 += a[i + 1] * b[i + 1];
+                s2 += a[i + 2] * b[i + 2];
+                s3 += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; i++)
+            {
+                s0 += a[i] * b[i];
+            }
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        float dotF16Scalar(const fp16_t *a, const fp16_t *b, std::size_t n)
+        {
+            float sum = 0.0f;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                sum += halfToFloat(a[i]) * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        int32_t dotI8Scalar(const int8_t *a, const int8_t *b, std::size_t n)
+        {
+            int32_t sum = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return sum;
+        }
+
+        const KernelTable kScalarTable = {Isa::Scalar, dotF32Scalar, dotF16Scalar, dotI8Scalar};
+
+#ifdef TARIUS_KERNELS_X86
+        // ---- AVX2 (with FMA and F16C) ----
+
+#define TARIUS_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+
+        TARIUS_TARGET_AVX2 inline float hsumAvx2(__m256 v)
+        {
+            __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            __m128 shuf = _mm_movehdup_ps(lo);
+            __m128 sums = _mm_add_ps(lo, shuf);
+            shuf = _mm_movehl_ps(shuf, sums);
+            return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+        }
+
+        TARIUS_TARGET_AVX2 inline int32_t hsumAvx2(__m256i v)
+        {
+            __m128i lo = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+            lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtsi128_si32(lo);
+        }
+
+        TARIUS_TARGET_AVX2 float dotF32Avx2(const float *a, const float *b, std::size_t n)
+        {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+                s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+            }
+            for (; i + 8 <= n; i += 8)
+            {
+                s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+            }
+            float sum = hsumAvx2(_mm256_add_ps(s0, s1));
+            for (; i < n; i++)
+            {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        TARIUS_TARGET_AVX2 float dotF16Avx2(const fp16_t *a, const fp16_t *b, std::size_t n)
+        {
+            __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m256 a0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+                __m256 b0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+                __m256 a1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i + 8)));
+                __m256 b1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i + 8)));
+                s0 = _mm256_fmadd_ps(a0, b0, s0);
+                s1 = _mm256_fmadd_ps(a1, b1, s1);
+            }
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 a0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+                __m256 b0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+                s0 = _mm256_fmadd_ps(a0, b0, s0);
+            }
+            float sum = hsumAvx2(_mm256_add_ps(s0, s1));
+            for (; i < n; i++)
+            {
+                sum += halfToFloat(a[i]) * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        TARIUS_TARGET_AVX2 int32_t dotI8Avx2(const int8_t *a, const int8_t *b, std::size_t n)
+        {
+            __m256i acc = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                // Sign-extend to 16 bits, then multiply pairs and add into 32-bit lanes
+                __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+                __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+            }
+            int32_t sum = hsumAvx2(acc);
+            for (; i < n; i++)
+            {
+                sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return sum;
+        }
+
+        const KernelTable kAvx2Table = {Isa::Avx2, dotF32Avx2, dotF16Avx2, dotI8Avx2};
+
+        // ---- AVX-512 (F + BW) ----
+
+#define TARIUS_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+        TARIUS_TARGET_AVX512 float dotF32Avx512(const float *a, const float *b, std::size_t n)
+        {
+            __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+                s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), s1);
+            }
+            for (; i + 16 <= n; i += 16)
+            {
+                s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+            }
+            if (i < n)
+            {
+                __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+                s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), s1);
+            }
+            return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+        }
+
+        TARIUS_TARGET_AVX512 float dotF16Avx512(const fp16_t *a, const fp16_t *b, std::size_t n)
+        {
+            __m512 s0 = _mm512_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                __m512 va = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+                __m512 vb = _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+                s0 = _mm512_fmadd_ps(va, vb, s0);
+            }
+            float sum = _mm512_reduce_add_ps(s0);
+            for (; i < n; i++)
+            {
+                sum += halfToFloat(a[i]) * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        TARIUS_TARGET_AVX512 int32_t dotI8Avx512(const int8_t *a, const int8_t *b, std::size_t n)
+        {
+            __m512i acc = _mm512_setzero_si512();
+            std::size_t i = 0;
+            for (; i + 32 <= n; i += 32)
+            {
+                __m512i va = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+                __m512i vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+                acc = _mm512_add_epi32(acc, _mm512_madd_epi16(va, vb));
+            }
+            int32_t sum = _mm512_reduce_add_epi32(acc);
+            for (; i < n; i++)
+            {
+                sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return sum;
+        }
+
+        const KernelTable kAvx512Table = {Isa::Avx512, dotF32Avx512, dotF16Avx512, dotI8Avx512};
+#endif // TARIUS_KERNELS_X86
+
+#ifdef TARIUS_KERNELS_NEON
+        // ---- NEON (AArch64) ----
+
+        float dotF32Neon(const float *a, const float *b, std::size_t n)
+        {
+            float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                s0 = vfmaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+                s1 = vfmaq_f32(s1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+            }
+            for (; i + 4 <= n; i += 4)
+            {
+                s0 = vfmaq_f32(s0, vld1q_f32(a + i), vld1q_f32(b + i));
+            }
+            float sum = vaddvq_f32(vaddq_f32(s0, s1));
+            for (; i < n; i++)
+            {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        float dotF16Neon(const fp16_t *a, const fp16_t *b, std::size_t n)
+        {
+            float32x4_t s0 = vdupq_n_f32(0.0f);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                float32x4_t va = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(a + i)));
+                float32x4_t vb = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(b + i)));
+                s0 = vfmaq_f32(s0, va, vb);
+            }
+            float sum = vaddvq_f32(s0);
+            for (; i < n; i++)
+            {
+                sum += halfToFloat(a[i]) * halfToFloat(b[i]);
+            }
+            return sum;
+        }
+
+        int32_t dotI8Neon(const int8_t *a, const int8_t *b, std::size_t n)
+        {
+            int32x4_t acc = vdupq_n_s32(0);
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16)
+            {
+                int8x16_t va = vld1q_s8(a + i);
+                int8x16_t vb = vld1q_s8(b + i);
+                acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+                acc = vpadalq_s16(acc, vmull_high_s8(va, vb));
+            }
+            int32_t sum = vaddvq_s32(acc);
+            for (; i < n; i++)
+            {
+                sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+            }
+            return sum;
+        }
+
+        const KernelTable kNeonTable = {Isa::Neon, dotF32Neon, dotF16Neon, dotI8Neon};
+#endif // TARIUS_KERNELS_NEON
+
+        const KernelTable *tableFor(Isa isa)
+        {
+            switch (isa)
+            {
+#ifdef TARIUS_KERNELS_X86
+            case Isa::Avx2:
+                return &kAvx2Table;
+            case Isa::Avx512:
+                return &kAvx512Table;
+#endif
+#ifdef TARIUS_KERNELS_NEON
+            case Isa::Neon:
+                return &kNeonTable;
+#endif
+            default:
+                return &kScalarTable;
+            }
+        }
+
+        const KernelTable *detectTable()
+        {
+            if (isaSupported(Isa::Avx512))
+            {
+                return tableFor(Isa::Avx512);
+            }
+            if (isaSupported(Isa::Avx2))
+            {
+                return tableFor(Isa::Avx2);
+            }
+            if (isaSupported(Isa::Neon))
+            {
+                return tableFor(Isa::Neon);
+            }
+            return &kScalarTable;
+        }
+
+        std::atomic<const KernelTable *> g_table{nullptr};
+
+        const KernelTable &table()
+        {
+            const KernelTable *current = g_table.load(std::memory_order_acquire);
+            if (!current)
+            {
+                // Benign race: every thread detects the same table
+                current = detectTable();
+                g_table.store(current, std::memory_order_release);
+            }
+            return *current;
+        }
+
+        float cosineFromDots(float ab, float aa, float bb)
+        {
+            float denom = std::sqrt(aa) * std::sqrt(bb);
+            return denom > 0.0f ? ab / denom : 0.0f;
+        }
+    } // namespace
+
+    bool isaSupported(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Scalar:
+            return true;
+#ifdef TARIUS_KERNELS_X86
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+        case Isa::Avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#ifdef TARIUS_KERNELS_NEON
+        case Isa::Neon:
+            return true; // Mandatory on AArch64
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Isa activeIsa()
+    {
+        return table().isa;
+    }
+
+    const char *isaName(Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Avx2:
+            return "avx2";
+        case Isa::Avx512:
+            return "avx512";
+        case Isa::Neon:
+            return "neon";
+        default:
+            return "scalar";
+        }
+    }
+
+    bool setIsa(Isa isa)
+    {
+        if (!isaSupported(isa))
+        {
+            return false;
+        }
+        g_table.store(tableFor(isa), std::memory_order_release);
+        return true;
+    }
+
+    float dotF32(const float *a, const float *b, std::size_t n)
+    {
+        return table().dotF32(a, b, n);
+    }
+
+    float dotF16(const fp16_t *a, const fp16_t *b, std::size_t n)
+    {
+        return table().dotF16(a, b, n);
+    }
+
+    int32_t dotI8(const int8_t *a, const int8_t *b, std::size_t n)
+    {
+        return table().dotI8(a, b, n);
+    }
+
+    float cosineF32(const float *a, const float *b, std::size_t n)
+    {
+        const KernelTable &t = table();
+        return cosineFromDots(t.dotF32(a, b, n), t.dotF32(a, a, n), t.dotF32(b, b, n));
+    }
+
+    float cosineF16(const fp16_t *a, const fp16_t *b, std::size_t n)
+    {
+        const KernelTable &t = table();
+        return cosineFromDots(t.dotF16(a, b, n), t.dotF16(a, a, n), t.dotF16(b, b, n));
+    }
+
+    float cosineI8(const int8_t *a, const int8_t *b, std::size_t n)
+    {
+        const KernelTable &t = table();
+        return cosineFromDots(static_cast<float>(t.dotI8(a, b, n)), static_cast<float>(t.dotI8(a, a, n)),
+                              static_cast<float>(t.dotI8(b, b, n)));
+    }
+
+    void dotBatchF32(const float *query, const float *rows, std::size_t count, std::size_t dim, float *out)
+    {
+        auto dot = table().dotF32;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            out[i] = dot(query, rows + i * dim, dim);
+        }
+    }
+
+    void dotBatchF16(const fp16_t *query, const fp16_t *rows, std::size_t count, std::size_t dim, float *out)
+    {
+        auto dot = table().dotF16;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            out[i] = dot(query, rows + i * dim, dim);
+        }
+    }
+
+    void dotBatchI8(const int8_t *query, float queryScale, const int8_t *rows, const float *rowScales,
+                    std::size_t count, std::size_t dim, float *out)
+    {
+        auto dot = table().dotI8;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            out[i] = static_cast<float>(dot(query, rows + i * dim, dim)) * queryScale * rowScales[i];
+        }
+    }
+
+    float halfToFloat(fp16_t value)
+    {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+        uint32_t bits;
+
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // Subnormal half becomes a normal float
+                exponent = 127 - 15 + 1;
+                while (!(mantissa & 0x400))
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+            }
+        }
+        else if (exponent == 0x1F)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    fp16_t floatToHalf(float value)
+    {
+        uint32_t x;
+        std::memcpy(&x, &value, sizeof(x));
+        uint32_t sign = (x >> 16) & 0x8000;
+        x &= 0x7FFFFFFF;
+
+        if (x >= 0x7F800000)
+        {
+            return static_cast<fp16_t>(sign | (x > 0x7F800000 ? 0x7E00 : 0x7C00)); // NaN or infinity
+        }
+        if (x >= 0x477FF000)
+        {
+            return static_cast<fp16_t>(sign | 0x7C00); // Rounds past the largest half
+        }
+        if (x < 0x38800000)
+        {
+            // Result is a half subnormal (or zero)
+            if (x < 0x33000000)
+            {
+                return static_cast<fp16_t>(sign);
+            }
+            uint32_t exponent = x >> 23;
+            uint32_t mantissa = (x & 0x7FFFFF) | 0x800000;
+            uint32_t shift = 126 - exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1)))
+            {
+                half++;
+            }
+            return static_cast<fp16_t>(sign | half);
+        }
+
+        // Normal: rebias the exponent and round the mantissa to nearest even
+        uint32_t half = (x - 0x38000000) >> 13;
+        uint32_t remainder = x & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        {
+            half++;
+        }
+        return static_cast<fp16_t>(sign | half);
+    }
+
+    void floatToHalf(const float *in, fp16_t *out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = floatToHalf(in[i]);
+        }
+    }
+
+    float quantizeI8(const float *in, int8_t *out, std::size_t n)
+    {
+        float maxAbs = 0.0f;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            maxAbs = std::max(maxAbs, std::fabs(in[i]));
+        }
+
+        if (maxAbs == 0.0f)
+        {
+            std::fill(out, out + n, 0);
+            return 0.0f;
+        }
+
+        float inv = 127.0f / maxAbs;
+        for (std::size_t i = 0; i < n; i++)
+        {
+            out[i] = static_cast<int8_t>(std::lround(in[i] * inv));
+        }
+        return maxAbs / 127.0f;
+    }
+
+    std::vector<ScoredId> topK(const float *scores, std::size_t count, std::size_t k)
+    {
+        k = std::min(k, count);
+        std::vector<ScoredId> heap;
+        if (k == 0)
+        {
+            return heap;
+        }
+        heap.reserve(k);
+
+        // Min-heap on "better", so the root is the weakest of the current top k
+        auto better = [](const ScoredId &a, const ScoredId &b)
+        { return a.score != b.score ? a.score > b.score : a.id < b.id; };
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            ScoredId candidate{static_cast<uint32_t>(i), scores[i]};
+            if (heap.size() < k)
+            {
+                heap.push_back(candidate);
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+            else if (better(candidate, heap.front()))
+            {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.back() = candidate;
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), better);
+        return heap;
+    }
+
+} // namespace tarius::kernels
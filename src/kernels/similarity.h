@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tarius::kernels
+{
+    /**
+     * @brief Vector similarity kernels for memory retrieval.
+     *
+     * Each kernel has a scalar implementation plus AVX2, AVX-512 and NEON
+     * variants. The fastest variant the CPU supports is picked once at first
+     * use; setIsa() can force another one (used by the benchmark).
+     *
+     * fp16 vectors are stored as raw IEEE 754 binary16 bit patterns. int8
+     * vectors are symmetric-quantized and carry a float scale per vector.
+     */
+
+    using fp16_t = uint16_t;
+
+    enum class Isa
+    {
+        Scalar,
+        Avx2,
+        Avx512,
+        Neon
+    };
+
+    Isa activeIsa();
+    const char *isaName(Isa isa);
+    bool isaSupported(Isa isa);
+
+    // Switch implementations, returns false if the CPU lacks the ISA
+    bool setIsa(Isa isa);
+
+    // Dot products
+    float dotF32(const float *a, const float *b, std::size_t n);
+    float dotF16(const fp16_t *a, const fp16_t *b, std::size_t n);
+    int32_t dotI8(const int8_t *a, const int8_t *b, std::size_t n);
+
+    // Cosine similarity, 0 if either vector is all zeros
+    float cosineF32(const float *a, const float *b, std::size_t n);
+    float cosineF16(const fp16_t *a, const fp16_t *b, std::size_t n);
+    float cosineI8(const int8_t *a, const int8_t *b, std::size_t n);
+
+    // Score a query against `count` contiguous rows of `dim` elements
+    void dotBatchF32(const float *query, const float *rows, std::size_t count, std::size_t dim, float *out);
+    void dotBatchF16(const fp16_t *query, const fp16_t *rows, std::size_t count, std::size_t dim, float *out);
+    void dotBatchI8(const int8_t *query, float queryScale, const int8_t *rows, const float *rowScales,
+                    std::size_t count, std::size_t dim, float *out);
+
+    // Conversions
+    fp16_t floatToHalf(float value);
+    float halfToFloat(fp16_t value);
+    void floatToHalf(const float *in, fp16_t *out, std::size_t n);
+
+    // Symmetric int8 quantization, returns the scale to multiply back by
+    float quantizeI8(const float *in, int8_t *out, std::size_t n);
+
+    struct ScoredId
+    {
+        uint32_t id;
+        float score;
+    };
+
+    // The k highest scores, best first. Ties keep the lower id first.
+    std::vector<ScoredId> topK(const float *scores, std::size_t count, std::size_t k);
+
+} // namespace tarius::kernels
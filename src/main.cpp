@@ -1,25 +1,250 @@
 #include "app/cli_interface.h"
+#include "app/batch_runner.h"
+#include "app/http_server.h"
 #include "utils/logger.h"
 #include "utils/config.h"
+#include "utils/tracer.h"
+#include <algorithm>
+#include <csignal>
 #include <iostream>
+#include <string>
+
+namespace
+{
+    // Console verbosity follows log.console_level ("info", "warn", ...)
+    void applyLogSettings(const tarius::utils::Config &config)
+    {
+        std::string name = config.getString("log.console_level", "info");
+        auto level = spdlog::level::from_str(name);
+        if (level == spdlog::level::off && name != "off")
+        {
+            LOG_WARN("Unknown log level {}, keeping the current one", name);
+            return;
+        }
+        tarius::utils::Logger::setConsoleLevel(level);
+
+        // "block" waits for room when the log queue is full, "drop" discards
+        std::string overflow = config.getString("log.overflow", "block");
+        if (overflow == "drop")
+        {
+            tarius::utils::Logger::setOverflowPolicy(tarius::utils::Logger::OverflowPolicy::Drop);
+        }
+        else
+        {
+            if (overflow != "block")
+            {
+                LOG_WARN("Unknown log overflow policy {}, blocking instead", overflow);
+            }
+            tarius::utils::Logger::setOverflowPolicy(tarius::utils::Logger::OverflowPolicy::Block);
+        }
+    }
+
+    struct Options
+    {
+        std::string batchInput;  // Run headless over this JSONL file
+        std::string batchOutput;
+        std::string dataDirectory; // Batch data root; a temporary one when empty
+        int parallel = 0; // Overrides model.parallel when set
+        bool serve = false;
+        int port = 0;       // Overrides server.port when set
+        std::string socket; // Overrides server.socket when set
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " [--batch input.jsonl --out output.jsonl [--parallel N] [--data-dir DIR]]"
+                  << std::endl
+                  << "       " << program << " --serve [--port N | --socket PATH] [--parallel N]" << std::endl;
+    }
+
+    bool parsePositive(const char *text, int &value)
+    {
+        try
+        {
+            value = std::stoi(text);
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        return value > 0;
+    }
+
+    tarius::app::HttpServer *g_server = nullptr;
+
+    void handleStopSignal(int)
+    {
+        if (g_server)
+        {
+            g_server->stop();
+        }
+    }
+
+    int runServer(tarius::utils::Config &config, const Options &options)
+    {
+        // Turns of different sessions run side by side on the workers; with
+        // fewer resident sequences they push each other's cache to disk
+        int workers = std::max(1, config.getInt("server.workers", 2));
+        if (options.parallel == 0 && config.getInt("model.parallel", 1) < workers)
+        {
+            LOG_INFO("Raising model.parallel to {} to match server.workers", workers);
+            config.setInt("model.parallel", workers);
+        }
+
+        tarius::app::AppController controller(config);
+        if (!controller.initializeLlamaModel(config.getString("model.path")))
+        {
+            LOG_WARN("Failed to load the model; serving simple responses");
+        }
+
+        tarius::app::HttpServer server(controller, config);
+        std::string socketPath = options.socket.empty() ? config.getString("server.socket") : options.socket;
+        int port = options.port > 0 ? options.port : config.getInt("server.port", 8765);
+        bool listening = socketPath.empty() ? server.listenTcp(port) : server.listenUnix(socketPath);
+        if (!listening)
+        {
+            std::cerr << "Failed to start the server. Please check the logs for details." << std::endl;
+            return 1;
+        }
+
+        std::cout << "Tarius is serving on "
+                  << (socketPath.empty() ? "http://127.0.0.1:" + std::to_string(port) : "unix:" + socketPath)
+                  << "; press Ctrl+C to stop." << std::endl;
+
+        g_server = &server;
+        std::signal(SIGINT, handleStopSignal);
+        std::signal(SIGTERM, handleStopSignal);
+        server.run();
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        g_server = nullptr;
+        return 0;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--batch" && hasValue)
+            {
+                options.batchInput = argv[++i];
+            }
+            else if (arg == "--out" && hasValue)
+            {
+                options.batchOutput = argv[++i];
+            }
+            else if (arg == "--data-dir" && hasValue)
+            {
+                options.dataDirectory = argv[++i];
+            }
+            else if (arg == "--parallel" && hasValue)
+            {
+                if (!parsePositive(argv[++i], options.parallel))
+                {
+                    return false;
+                }
+            }
+            else if (arg == "--serve")
+            {
+                options.serve = true;
+            }
+            else if (arg == "--port" && hasValue)
+            {
+                if (!parsePositive(argv[++i], options.port) || options.port > 65535)
+                {
+                    return false;
+                }
+            }
+            else if (arg == "--socket" && hasValue)
+            {
+                options.socket = argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        // --port and --socket only go with --serve, which doesn't go with --batch
+        if (!options.serve && (options.port > 0 || !options.socket.empty()))
+        {
+            return false;
+        }
+        if (options.serve && (!options.batchInput.empty() || (options.port > 0 && !options.socket.empty())))
+        {
+            return false;
+        }
+
+        // --data-dir only goes with --batch
+        if (options.batchInput.empty() && !options.dataDirectory.empty())
+        {
+            return false;
+        }
+
+        // Both or neither
+        return options.batchInput.empty() == options.batchOutput.empty();
+    }
+} // namespace
 
 int main(int argc, char *argv[])
 {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
     // Initialize logger
     tarius::utils::Logger::init();
+    tarius::utils::Tracer::setThreadName("main");
     LOG_INFO("Starting Tarius AI...");
 
-    // Load configuration
-    tarius::utils::Config config;
-    if (!config.load())
+    int status = 0;
     {
-        LOG_ERROR("Failed to load configuration. Using defaults.");
-    }
+        // Load configuration
+        tarius::utils::Config config;
+        if (!config.load())
+        {
+            LOG_ERROR("Failed to load configuration. Using defaults.");
+        }
 
-    // Create and run CLI interface
-    tarius::app::CLIInterface cli;
-    cli.run();
+        // Pick up edits to the config file without a restart
+        applyLogSettings(config);
+        config.subscribe("log.", applyLogSettings);
+        config.watch();
+
+        if (options.parallel > 0)
+        {
+            config.setInt("model.parallel", options.parallel);
+        }
+
+        if (options.serve)
+        {
+            status = runServer(config, options);
+        }
+        else if (!options.batchInput.empty())
+        {
+            tarius::app::BatchRunner runner(config, options.dataDirectory);
+            if (!runner.run(options.batchInput, options.batchOutput))
+            {
+                std::cerr << "Batch run failed. Please check the logs for details." << std::endl;
+                status = 1;
+            }
+        }
+        else
+        {
+            // Create and run CLI interface
+            tarius::app::CLIInterface cli(config);
+            cli.run();
+        }
+
+        LOG_INFO("Tarius AI shutting down.");
+    }
 
-    LOG_INFO("Tarius AI shutting down.");
-    return 0;
-}
\ No newline at end of file
+    // Everything above has been torn down; write out what is still queued
+    tarius::utils::Logger::shutdown();
+    return status;
+}
@@ -0,0 +1,657 @@
+#include "conversation_store.h"
+#include "../utils/file_lock.h"
+#include "../utils/logger.h"
+#include "../utils/lz4.h"
+#include "../utils/time_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace tarius::models
+{
+    namespace
+    {
+        constexpr char kMagic[4] = {'T', 'S', 'E', 'G'};
+        constexpr uint8_t kCodecNone = 0;
+        constexpr uint8_t kCodecLz4 = 1;
+
+        template <typename T>
+        void writeValue(std::ofstream &out, const T &value)
+        {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool readValue(std::ifstream &in, T &value)
+        {
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+        }
+
+        void writeString(std::ofstream &out, const std::string &value)
+        {
+            writeValue(out, static_cast<uint32_t>(value.size()));
+            out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        bool readString(std::ifstream &in, std::string &value)
+        {
+            uint32_t length;
+            if (!readValue(in, length))
+            {
+                return false;
+            }
+            value.resize(length);
+            return static_cast<bool>(in.read(value.data(), length));
+        }
+
+        void appendString(std::string &out, const std::string &value)
+        {
+            uint32_t length = static_cast<uint32_t>(value.size());
+            out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+            out.append(value);
+        }
+
+        bool takeString(const std::string &in, std::size_t &pos, std::string &value)
+        {
+            uint32_t length;
+            if (in.size() - pos < sizeof(length))
+            {
+                return false;
+            }
+            std::memcpy(&length, in.data() + pos, sizeof(length));
+            pos += sizeof(length);
+            if (in.size() - pos < length)
+            {
+                return false;
+            }
+            value.assign(in, pos, length);
+            pos += length;
+            return true;
+        }
+
+        std::string daysAgo(int days)
+        {
+            return utils::TimeUtils::formatIsoDate(utils::TimeUtils::dayOf(std::chrono::system_clock::now()) - days);
+        }
+
+        void mergeEntry(std::map<std::string, ConversationStore::Entry> &entries, ConversationStore::Entry entry)
+        {
+            auto [it, inserted] = entries.try_emplace(entry.id, entry);
+            if (!inserted)
+            {
+                it->second.messageCount = std::max(it->second.messageCount, entry.messageCount);
+                it->second.lastMessage = std::max(it->second.lastMessage, entry.lastMessage);
+            }
+        }
+    } // namespace
+
+    ConversationStore::ConversationStore(const std::string &directory, Options options)
+        : m_directory(directory), m_options(options)
+    {
+        // Today's log is always hot
+        m_options.compactAfterDays = std::max(1, m_options.compactAfterDays);
+
+        fs::create_directories(m_directory);
+
+        utils::FileLock fileLock(utils::FileLock::forDirectory(m_directory), utils::FileLock::Mode::Exclusive);
+        migrateLegacyFiles();
+    }
+
+    std::string ConversationStore::dayFromId(const std::string &id)
+    {
+        if (id.size() < 13 || id.compare(0, 5, "conv_") != 0 ||
+            !std::all_of(id.begin() + 5, id.begin() + 13, [](unsigned char c)
+                         { return std::isdigit(c); }))
+        {
+            return "";
+        }
+        return id.substr(5, 4) + "-" + id.substr(9, 2) + "-" + id.substr(11, 2);
+    }
+
+    std::string ConversationStore::dayOf(const std::string &id, std::chrono::system_clock::time_point fallback)
+    {
+        std::string day = dayFromId(id);
+        return day.empty() ? utils::TimeUtils::formatIsoDate(fallback) : day;
+    }
+
+    std::string ConversationStore::dayLogPath(const std::string &day) const
+    {
+        return m_directory + "/" + day + ".log";
+    }
+
+    std::string ConversationStore::monthSegmentPath(const std::string &month) const
+    {
+        return m_directory + "/" + month + ".seg";
+    }
+
+    ConversationStore::Entry ConversationStore::entryOf(const Conversation &conversation, const std::string &day)
+    {
+        return {conversation.id, day, conversation.messages.size(),
+                conversation.messages.empty() ? conversation.startTime : conversation.messages.back().timestamp};
+    }
+
+    bool ConversationStore::save(const Conversation &conversation)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        utils::FileLock fileLock(utils::FileLock::forDirectory(m_directory), utils::FileLock::Mode::Exclusive);
+
+        std::size_t &written = m_written[conversation.id];
+        if (conversation.messages.size() < written)
+        {
+            written = 0; // Rewritten from scratch; records are keyed by index
+        }
+        if (written == conversation.messages.size() && written > 0)
+        {
+            return true;
+        }
+
+        if (!appendRecords(conversation, written))
+        {
+            return false;
+        }
+        written = conversation.messages.size();
+        return true;
+    }
+
+    bool ConversationStore::appendRecords(const Conversation &conversation, std::size_t fromMessage)
+    {
+        std::string path = dayLogPath(dayOf(conversation.id, conversation.startTime));
+
+        // A crash can leave a torn last line; start on a fresh one
+        bool needsNewline = false;
+        {
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (in.is_open() && in.tellg() > 0)
+            {
+                char last;
+                in.seekg(-1, std::ios::end);
+                needsNewline = in.get(last) && last != '\n';
+            }
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        if (!out.is_open())
+        {
+            LOG_ERROR("Failed to open conversation log for writing: {}", path);
+            return false;
+        }
+        if (needsNewline)
+        {
+            out << '\n';
+        }
+
+        std::string idJson = json(conversation.id).dump();
+        if (fromMessage == 0)
+        {
+            Conversation header;
+            header.id = conversation.id;
+            header.startTime = conversation.startTime;
+            json start = json::parse(header.toJson());
+            start.erase("messages");
+            out << start.dump() << '\n';
+        }
+
+        for (std::size_t i = fromMessage; i < conversation.messages.size(); i++)
+        {
+            out << "{\"id\":" << idJson << ",\"index\":" << i << ",\"message\":" << conversation.messages[i].toJson() << "}\n";
+        }
+
+        out.flush();
+        return static_cast<bool>(out);
+    }
+
+    bool ConversationStore::readDayLog(const std::string &day, std::unordered_map<std::string, Conversation> &conversations,
+                                       const std::string &id) const
+    {
+        std::ifstream in(dayLogPath(day));
+        if (!in.is_open())
+        {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+
+            try
+            {
+                json record = json::parse(line);
+                std::string recordId = record.at("id").get<std::string>();
+                if (!id.empty() && recordId != id)
+                {
+                    continue;
+                }
+
+                Conversation &conversation = conversations[recordId];
+                conversation.id = recordId;
+
+                if (record.contains("startTime"))
+                {
+                    json header = {{"id", recordId}, {"startTime", record["startTime"]}, {"messages", json::array()}};
+                    conversation.startTime = Conversation::fromJson(header.dump()).startTime;
+                }
+                else
+                {
+                    std::size_t index = record.at("index").get<std::size_t>();
+                    if (index >= conversation.messages.size())
+                    {
+                        conversation.messages.resize(index + 1);
+                    }
+                    conversation.messages[index] = Message::fromJson(record.at("message").dump());
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG_WARN("Skipping unreadable record in conversation log {}: {}", day, e.what());
+            }
+        }
+        return true;
+    }
+
+    bool ConversationStore::readMonthHeader(const std::string &month, MonthHeader &header) const
+    {
+        std::ifstream in(monthSegmentPath(month), std::ios::binary);
+        if (!in.is_open())
+        {
+            return false;
+        }
+
+        char magic[sizeof(kMagic)];
+        uint32_t count;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !readValue(in, header.codec) || !readValue(in, header.rawSize) || !readValue(in, header.payloadSize) ||
+            !readValue(in, count))
+        {
+            LOG_ERROR("Conversation segment is corrupt: {}", monthSegmentPath(month));
+            return false;
+        }
+
+        header.entries.clear();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entry entry;
+            uint32_t messageCount;
+            int64_t lastMessage;
+            if (!readString(in, entry.id) || !readString(in, entry.day) || !readValue(in, messageCount) ||
+                !readValue(in, lastMessage))
+            {
+                LOG_ERROR("Conversation segment header is truncated: {}", monthSegmentPath(month));
+                return false;
+            }
+            entry.messageCount = messageCount;
+            entry.lastMessage = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(lastMessage));
+            header.entries.push_back(std::move(entry));
+        }
+        return true;
+    }
+
+    bool ConversationStore::readMonth(const std::string &month, std::unordered_map<std::string, std::string> &conversations) const
+    {
+        MonthHeader header;
+        if (!readMonthHeader(month, header))
+        {
+            return false;
+        }
+
+        // The payload follows the header
+        std::ifstream in(monthSegmentPath(month), std::ios::binary | std::ios::ate);
+        std::string payload(header.payloadSize, '\0');
+        in.seekg(-static_cast<std::streamoff>(header.payloadSize), std::ios::end);
+        if (!in.read(payload.data(), header.payloadSize))
+        {
+            LOG_ERROR("Conversation segment payload is truncated: {}", monthSegmentPath(month));
+            return false;
+        }
+
+        std::string raw;
+        if (header.codec == kCodecLz4)
+        {
+            if (!utils::Lz4::decompress(payload, header.rawSize, raw))
+            {
+                LOG_ERROR("Failed to decompress conversation segment: {}", monthSegmentPath(month));
+                return false;
+            }
+        }
+        else
+        {
+            raw = std::move(payload);
+        }
+
+        std::size_t pos = 0;
+        std::string id, text;
+        while (pos < raw.size())
+        {
+            if (!takeString(raw, pos, id) || !takeString(raw, pos, text))
+            {
+                LOG_ERROR("Conversation segment payload is corrupt: {}", monthSegmentPath(month));
+                return false;
+            }
+            conversations[id] = std::move(text);
+        }
+        return true;
+    }
+
+    bool ConversationStore::writeMonth(const std::string &month, const std::vector<Conversation> &conversations) const
+    {
+        std::string path = monthSegmentPath(month);
+        if (conversations.empty())
+        {
+            fs::remove(path);
+            return true;
+        }
+
+        std::string raw;
+        for (const auto &conversation : conversations)
+        {
+            appendString(raw, conversation.id);
+            appendString(raw, conversation.toJson());
+        }
+
+        uint8_t codec = kCodecNone;
+        std::string payload;
+        if (m_options.compressColdSegments)
+        {
+            payload = utils::Lz4::compress(raw);
+            codec = kCodecLz4;
+        }
+        if (codec == kCodecNone || payload.size() >= raw.size())
+        {
+            payload = raw;
+            codec = kCodecNone;
+        }
+
+        // Write beside the old segment and swap it in, so a crash leaves one or the other
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open())
+            {
+                LOG_ERROR("Failed to open conversation segment for writing: {}", tmpPath);
+                return false;
+            }
+
+            out.write(kMagic, sizeof(kMagic));
+            writeValue(out, codec);
+            writeValue(out, static_cast<uint32_t>(raw.size()));
+            writeValue(out, static_cast<uint32_t>(payload.size()));
+            writeValue(out, static_cast<uint32_t>(conversations.size()));
+            for (const auto &conversation : conversations)
+            {
+                Entry entry = entryOf(conversation, dayOf(conversation.id, conversation.startTime));
+                writeString(out, entry.id);
+                writeString(out, entry.day);
+                writeValue(out, static_cast<uint32_t>(entry.messageCount));
+                writeValue(out, static_cast<int64_t>(std::chrono::system_clock::to_time_t(entry.lastMessage)));
+            }
+            out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+
+            if (!out)
+            {
+                LOG_ERROR("Failed to write conversation segment: {}", tmpPath);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(tmpPath, path, ec);
+        if (ec)
+        {
+            LOG_ERROR("Failed to replace conversation segment {}: {}", path, ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    bool ConversationStore::load(const std::string &id, Conversation &conversation)
+    {
+        std::string day = dayFromId(id);
+        if (day.empty())
+        {
+            // Ids without a date have to be looked up
+            for (const auto &entry : list())
+            {
+                if (entry.id == id)
+                {
+                    day = entry.day;
+                    break;
+                }
+            }
+            if (day.empty())
+            {
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        utils::FileLock fileLock(utils::FileLock::forDirectory(m_directory), utils::FileLock::Mode::Shared);
+
+        std::unordered_map<std::string, Conversation> found;
+        std::string month = day.substr(0, 7);
+        std::error_code ec;
+        auto segmentTime = fs::last_write_time(monthSegmentPath(month), ec);
+        if (!ec)
+        {
+            // Another process may have rewritten the segment since it was cached
+            if (m_cachedMonth != month || m_cachedMonthTime != segmentTime)
+            {
+                m_cachedConversations.clear();
+                m_cachedMonth = readMonth(month, m_cachedConversations) ? month : "";
+                m_cachedMonthTime = segmentTime;
+            }
+
+            auto it = m_cachedConversations.find(id);
+            if (it != m_cachedConversations.end())
+            {
+                found[id] = Conversation::fromJson(it->second);
+            }
+        }
+
+        // Messages added after compaction sit in the day log again
+        readDayLog(day, found, id);
+
+        auto it = found.find(id);
+        if (it == found.end())
+        {
+            return false;
+        }
+        conversation = std::move(it->second);
+        return true;
+    }
+
+    std::vector<ConversationStore::Entry> ConversationStore::list(const std::string &fromDay, const std::string &toDay)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        utils::FileLock fileLock(utils::FileLock::forDirectory(m_directory), utils::FileLock::Mode::Shared);
+
+        auto inRange = [&](const std::string &day)
+        {
+            return (fromDay.empty() || day >= fromDay) && (toDay.empty() || day <= toDay);
+        };
+
+        std::map<std::string, Entry> entries;
+        for (const auto &file : fs::directory_iterator(m_directory))
+        {
+            if (!file.is_regular_file())
+            {
+                continue;
+            }
+
+            std::string name = file.path().stem().string();
+            std::string extension = file.path().extension().string();
+            if (extension == ".log" && inRange(name))
+            {
+                std::unordered_map<std::string, Conversation> conversations;
+                readDayLog(name, conversations);
+                for (const auto &[id, conversation] : conversations)
+                {
+                    mergeEntry(entries, entryOf(conversation, name));
+                }
+            }
+            else if (extension == ".seg" && (fromDay.empty() || name >= fromDay.substr(0, 7)) &&
+                     (toDay.empty() || name <= toDay.substr(0, 7)))
+            {
+                MonthHeader header;
+                if (!readMonthHeader(name, header))
+                {
+                    continue;
+                }
+                for (auto &entry : header.entries)
+                {
+                    if (inRange(entry.day))
+                    {
+                        mergeEntry(entries, std::move(entry));
+                    }
+                }
+            }
+        }
+
+        std::vector<Entry> result;
+        result.reserve(entries.size());
+        for (auto &[id, entry] : entries)
+        {
+            result.push_back(std::move(entry));
+        }
+        return result;
+    }
+
+    void ConversationStore::compact(const std::function<bool(const std::string &id)> &hasSummary)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        utils::FileLock fileLock(utils::FileLock::forDirectory(m_directory), utils::FileLock::Mode::Exclusive);
+
+        std::string compactBefore = daysAgo(m_options.compactAfterDays);
+        std::string retainFrom = m_options.rawRetentionDays > 0 ? daysAgo(m_options.rawRetentionDays) : "";
+
+        auto expired = [&](const std::string &id, const std::string &day)
+        {
+            return !retainFrom.empty() && day < retainFrom && hasSummary(id);
+        };
+
+        // Cold day logs by month, and months holding raw text past retention
+        std::map<std::string, std::vector<std::string>> coldDays;
+        std::set<std::string> months;
+        for (const auto &file : fs::directory_iterator(m_directory))
+        {
+            std::string name = file.path().stem().string();
+            std::string extension = file.path().extension().string();
+            if (extension == ".log" && name < compactBefore)
+            {
+                coldDays[name.substr(0, 7)].push_back(name);
+                months.insert(name.substr(0, 7));
+            }
+            else if (extension == ".seg" && !retainFrom.empty() && name <= retainFrom.substr(0, 7))
+            {
+                MonthHeader header;
+                if (readMonthHeader(name, header) &&
+                    std::any_of(header.entries.begin(), header.entries.end(), [&](const Entry &entry)
+                                { return expired(entry.id, entry.day); }))
+                {
+                    months.insert(name);
+                }
+            }
+        }
+
+        std::size_t merged = 0, dropped = 0;
+        for (const auto &month : months)
+        {
+            std::unordered_map<std::string, Conversation> conversations;
+            std::unordered_map<std::string, std::string> stored;
+            if (fs::exists(monthSegmentPath(month)) && !readMonth(month, stored))
+            {
+                continue; // Never overwrite a segment that could not be read
+            }
+            for (const auto &[id, text] : stored)
+            {
+                conversations[id] = Conversation::fromJson(text);
+            }
+            for (const auto &day : coldDays[month])
+            {
+                readDayLog(day, conversations);
+            }
+
+            std::vector<Conversation> kept;
+            for (auto &[id, conversation] : conversations)
+            {
+                if (expired(id, dayOf(id, conversation.startTime)))
+                {
+                    dropped++;
+                    continue;
+                }
+                kept.push_back(std::move(conversation));
+            }
+            std::sort(kept.begin(), kept.end(), [](const Conversation &a, const Conversation &b)
+                      { return a.id < b.id; });
+
+            if (!writeMonth(month, kept))
+            {
+                continue;
+            }
+            if (m_cachedMonth == month)
+            {
+                m_cachedMonth.clear();
+                m_cachedConversations.clear();
+            }
+
+            for (const auto &day : coldDays[month])
+            {
+                fs::remove(dayLogPath(day));
+                merged++;
+            }
+        }
+
+        if (merged > 0 || dropped > 0)
+        {
+            LOG_INFO("Compacted {} day logs into month segments, dropped raw text of {} summarized conversations",
+                     merged, dropped);
+        }
+    }
+
+    void ConversationStore::migrateLegacyFiles()
+    {
+        // Earlier versions kept one JSON file per conversation
+        std::size_t migrated = 0;
+        for (const auto &file : fs::directory_iterator(m_directory))
+        {
+            if (!file.is_regular_file() || file.path().extension() != ".json")
+            {
+                continue;
+            }
+
+            std::ifstream in(file.path());
+            std::string jsonStr((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            in.close();
+
+            try
+            {
+                Conversation conversation = Conversation::fromJson(jsonStr);
+                if (appendRecords(conversation, 0))
+                {
+                    fs::remove(file.path());
+                    migrated++;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Failed to migrate conversation file {}: {}", file.path().string(), e.what());
+            }
+        }
+
+        if (migrated > 0)
+        {
+            LOG_INFO("Migrated {} conversation files into day logs", migrated);
+        }
+    }
+
+} // namespace tarius::models
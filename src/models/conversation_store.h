@@ -0,0 +1,114 @@
+#pragma once
+
+#include "memory_manager.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Date-partitioned storage for conversations.
+     *
+     * Recent days live in one append-only log per day (YYYY-MM-DD.log) with a
+     * record per message, so saving after every message only writes that
+     * message. Days older than compactAfterDays are merged into one segment
+     * per month (YYYY-MM.seg): a small header listing the conversations it
+     * holds, followed by the conversations themselves, LZ4 compressed.
+     * Listing a month reads only its header.
+     *
+     * Past rawRetentionDays, conversations that have a summary are dropped
+     * from the month segments during compaction and only their summaries
+     * remain.
+     *
+     * Conversations are placed by the day in their id, so a conversation that
+     * runs past midnight stays in the segment of the day it started.
+     *
+     * The directory may be shared by several processes: writes and compaction
+     * hold an exclusive lock on its lock file, reads a shared one.
+     */
+    class ConversationStore
+    {
+    public:
+        struct Options
+        {
+            int compactAfterDays = 7;
+            int rawRetentionDays = 365; // 0 keeps raw conversations forever
+            bool compressColdSegments = true;
+        };
+
+        struct Entry
+        {
+            std::string id;
+            std::string day; // YYYY-MM-DD
+            std::size_t messageCount;
+            std::chrono::system_clock::time_point lastMessage;
+        };
+
+        ConversationStore(const std::string &directory, Options options);
+
+        // Append the messages not yet written for this conversation
+        bool save(const Conversation &conversation);
+        bool load(const std::string &id, Conversation &conversation);
+
+        // Conversations whose day lies in [fromDay, toDay], sorted by id.
+        // Empty bounds are open.
+        std::vector<Entry> list(const std::string &fromDay = "", const std::string &toDay = "");
+
+        /**
+         * @brief Merge cold day logs into month segments and apply retention.
+         *
+         * @param hasSummary Whether a conversation can be reduced to its summary
+         */
+        void compact(const std::function<bool(const std::string &id)> &hasSummary);
+
+        // The day a conversation is filed under: the date in its id, or the
+        // local date of fallback for ids that carry none
+        static std::string dayOf(const std::string &id, std::chrono::system_clock::time_point fallback);
+
+    private:
+        struct MonthHeader
+        {
+            uint8_t codec;
+            uint32_t rawSize;
+            uint32_t payloadSize;
+            std::vector<Entry> entries;
+        };
+
+        std::string m_directory;
+        Options m_options;
+        mutable std::mutex m_mutex;
+
+        // Messages already written per conversation, so saves only append
+        std::unordered_map<std::string, std::size_t> m_written;
+
+        // The last month segment decompressed, conversations by id
+        std::string m_cachedMonth;
+        std::filesystem::file_time_type m_cachedMonthTime;
+        std::unordered_map<std::string, std::string> m_cachedConversations;
+
+        // YYYY-MM-DD from ids of the form conv_YYYYMMDD_..., empty otherwise
+        static std::string dayFromId(const std::string &id);
+
+        std::string dayLogPath(const std::string &day) const;
+        std::string monthSegmentPath(const std::string &month) const;
+
+        bool appendRecords(const Conversation &conversation, std::size_t fromMessage);
+        void migrateLegacyFiles();
+
+        // Apply a day log's records to the conversations in it; id filters when non-empty
+        bool readDayLog(const std::string &day, std::unordered_map<std::string, Conversation> &conversations,
+                        const std::string &id = "") const;
+
+        bool readMonthHeader(const std::string &month, MonthHeader &header) const;
+        bool readMonth(const std::string &month, std::unordered_map<std::string, std::string> &conversations) const;
+        bool writeMonth(const std::string &month, const std::vector<Conversation> &conversations) const;
+
+        static Entry entryOf(const Conversation &conversation, const std::string &day);
+    };
+
+} // namespace tarius::models
@@ -0,0 +1,218 @@
+#include "hnsw_index.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_set>
+
+namespace tarius::models
+{
+
+    HnswIndex::HnswIndex(const VectorArena &arena)
+        : HnswIndex(arena, Params{})
+    {
+    }
+
+    HnswIndex::HnswIndex(const VectorArena &arena, const Params &params)
+        : m_arena(arena),
+          m_params(params),
+          m_levelMult(1.0 / std::log(static_cast<double>(std::max(params.m, 2)))),
+          m_rng(0x7a71u),
+          m_entryPoint(0),
+          m_maxLevel(-1)
+    {
+    }
+
+    HnswIndex::Query HnswIndex::makeQuery(const float *vector) const
+    {
+        Query query;
+        query.vector = vector;
+        query.quantized.resize(m_arena.dimension());
+        query.scale = VectorArena::quantize(vector, m_arena.dimension(), query.quantized.data());
+        return query;
+    }
+
+    float HnswIndex::similarity(const Query &query, uint32_t id) const
+    {
+        return m_arena.dotQuantized(query.quantized.data(), query.scale, id);
+    }
+
+    int HnswIndex::randomLevel()
+    {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        double r = std::max(dist(m_rng), 1e-12);
+        return static_cast<int>(-std::log(r) * m_levelMult);
+    }
+
+    uint32_t HnswIndex::greedyDescend(const Query &query, uint32_t entry, int fromLevel, int toLevel) const
+    {
+        uint32_t current = entry;
+        float best = similarity(query, current);
+
+        for (int level = fromLevel; level > toLevel; level--)
+        {
+            bool improved = true;
+            while (improved)
+            {
+                improved = false;
+                for (uint32_t neighbour : m_links[current][level])
+                {
+                    float s = similarity(query, neighbour);
+                    if (s > best)
+                    {
+                        best = s;
+                        current = neighbour;
+                        improved = true;
+                    }
+                }
+            }
+        }
+
+        return current;
+    }
+
+    std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const Query &query, uint32_t entry, std::size_t ef, int level) const
+    {
+        // Max-heap of candidates still to expand, min-heap of the best ef found
+        std::priority_queue<Candidate> frontier;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> found;
+        std::unordered_set<uint32_t> visited{entry};
+
+        float s = similarity(query, entry);
+        frontier.emplace(s, entry);
+        found.emplace(s, entry);
+
+        while (!frontier.empty())
+        {
+            Candidate current = frontier.top();
+            if (found.size() >= ef && current.first < found.top().first)
+            {
+                break; // Nothing left that can improve the result set
+            }
+            frontier.pop();
+
+            for (uint32_t neighbour : m_links[current.second][level])
+            {
+                if (!visited.insert(neighbour).second)
+                {
+                    continue;
+                }
+
+                float ns = similarity(query, neighbour);
+                if (found.size() < ef || ns > found.top().first)
+                {
+                    frontier.emplace(ns, neighbour);
+                    found.emplace(ns, neighbour);
+                    if (found.size() > ef)
+                    {
+                        found.pop();
+                    }
+                }
+            }
+        }
+
+        std::vector<Candidate> result;
+        result.reserve(found.size());
+        while (!found.empty())
+        {
+            result.push_back(found.top());
+            found.pop();
+        }
+        std::reverse(result.begin(), result.end()); // Best first
+        return result;
+    }
+
+    void HnswIndex::shrinkLinks(uint32_t id, int level, std::size_t maxLinks)
+    {
+        auto &links = m_links[id][level];
+        if (links.size() <= maxLinks)
+        {
+            return;
+        }
+
+        // Keep the closest neighbours of this node
+        const float *base = m_arena.row(id);
+        std::vector<Candidate> scored;
+        scored.reserve(links.size());
+        for (uint32_t neighbour : links)
+        {
+            scored.emplace_back(m_arena.dot(base, neighbour), neighbour);
+        }
+        std::partial_sort(scored.begin(), scored.begin() + maxLinks, scored.end(), std::greater<Candidate>());
+
+        links.clear();
+        for (std::size_t i = 0; i < maxLinks; i++)
+        {
+            links.push_back(scored[i].second);
+        }
+    }
+
+    void HnswIndex::insert(uint32_t id)
+    {
+        int level = randomLevel();
+        m_levels.push_back(level);
+        m_links.emplace_back(level + 1);
+
+        if (m_maxLevel < 0)
+        {
+            m_entryPoint = id;
+            m_maxLevel = level;
+            return;
+        }
+
+        Query query = makeQuery(m_arena.row(id));
+        uint32_t entry = greedyDescend(query, m_entryPoint, m_maxLevel, level);
+
+        for (int l = std::min(level, m_maxLevel); l >= 0; l--)
+        {
+            std::vector<Candidate> candidates = searchLayer(query, entry, m_params.efConstruction, l);
+            std::size_t maxLinks = static_cast<std::size_t>(l == 0 ? m_params.m * 2 : m_params.m);
+
+            std::size_t count = std::min(candidates.size(), static_cast<std::size_t>(m_params.m));
+            for (std::size_t i = 0; i < count; i++)
+            {
+                uint32_t neighbour = candidates[i].second;
+                m_links[id][l].push_back(neighbour);
+                m_links[neighbour][l].push_back(id);
+                shrinkLinks(neighbour, l, maxLinks);
+            }
+
+            entry = candidates.front().second;
+        }
+
+        if (level > m_maxLevel)
+        {
+            m_maxLevel = level;
+            m_entryPoint = id;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, float>> HnswIndex::search(const float *query, std::size_t k) const
+    {
+        std::vector<std::pair<uint32_t, float>> results;
+        if (m_maxLevel < 0 || k == 0)
+        {
+            return results;
+        }
+
+        Query q = makeQuery(query);
+        uint32_t entry = greedyDescend(q, m_entryPoint, m_maxLevel, 0);
+        std::size_t ef = std::max(k, static_cast<std::size_t>(m_params.efSearch));
+        std::vector<Candidate> candidates = searchLayer(q, entry, ef, 0);
+
+        // Re-rank the approximate candidates with the exact float rows
+        for (auto &candidate : candidates)
+        {
+            candidate.first = m_arena.dot(query, candidate.second);
+        }
+        std::size_t count = std::min(k, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), std::greater<Candidate>());
+
+        results.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            results.emplace_back(candidates[i].second, candidates[i].first);
+        }
+        return results;
+    }
+
+} // namespace tarius::models
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vector_arena.h"
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Hierarchical navigable small world graph over a VectorArena.
+     *
+     * Vectors are expected to be L2-normalised so that a dot product is the
+     * cosine similarity. Graph traversal scores with the arena's int8 rows;
+     * the final candidates are re-ranked with the float rows.
+     */
+    class HnswIndex
+    {
+    public:
+        struct Params
+        {
+            int m = 16;               // Links per node on upper layers
+            int efConstruction = 100; // Candidate list size while inserting
+            int efSearch = 64;        // Minimum candidate list size while searching
+        };
+
+        explicit HnswIndex(const VectorArena &arena);
+        HnswIndex(const VectorArena &arena, const Params &params);
+
+        // Link an arena row into the graph. Rows must be inserted in id order.
+        void insert(uint32_t id);
+
+        // Top-k (id, similarity) pairs for the query, best first
+        std::vector<std::pair<uint32_t, float>> search(const float *query, std::size_t k) const;
+
+        std::size_t size() const { return m_levels.size(); }
+
+    private:
+        using Candidate = std::pair<float, uint32_t>; // (similarity, id)
+
+        struct Query
+        {
+            const float *vector;
+            std::vector<int8_t> quantized;
+            float scale;
+        };
+
+        const VectorArena &m_arena;
+        Params m_params;
+        double m_levelMult;
+        std::mt19937 m_rng;
+
+        std::vector<int> m_levels;
+        // m_links[id][level] holds the neighbour ids of a node on that level
+        std::vector<std::vector<std::vector<uint32_t>>> m_links;
+        uint32_t m_entryPoint;
+        int m_maxLevel;
+
+        Query makeQuery(const float *vector) const;
+        float similarity(const Query &query, uint32_t id) const;
+        uint32_t greedyDescend(const Query &query, uint32_t entry, int fromLevel, int toLevel) const;
+        std::vector<Candidate> searchLayer(const Query &query, uint32_t entry, std::size_t ef, int level) const;
+        void shrinkLinks(uint32_t id, int level, std::size_t maxLinks);
+        int randomLevel();
+    };
+
+} // namespace tarius::models
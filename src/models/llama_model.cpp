@@ -1,5 +1,6 @@
 #include "llama_model.h"
 #include "../utils/logger.h"
+#include "../utils/tracer.h"
 
 // Include llama.cpp headers
 #include "../../external/llama.cpp/include/llama.h"
@@ -8,9 +9,144 @@
 #include <sstream>
 #include <thread>
 #include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
 
 namespace tarius::models
 {
+    namespace
+    {
+        // Greedy at temperature 0, otherwise top-k, then top-p, then a
+        // random draw at the given temperature
+        llama_sampler *createSampler(const LlamaModel::ModelConfig &config)
+        {
+            llama_sampler *sampler = llama_sampler_chain_init(llama_sampler_chain_default_params());
+            if (config.temperature <= 0.0f)
+            {
+                llama_sampler_chain_add(sampler, llama_sampler_init_greedy());
+                return sampler;
+            }
+            llama_sampler_chain_add(sampler, llama_sampler_init_top_k(config.top_k));
+            llama_sampler_chain_add(sampler, llama_sampler_init_top_p(config.top_p, 1));
+            llama_sampler_chain_add(sampler, llama_sampler_init_temp(config.temperature));
+            llama_sampler_chain_add(sampler, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
+            return sampler;
+        }
+
+        // Wrap a prompt in the ChatML-style markers the model is prompted with
+        std::string formatPrompt(const std::string &prompt, const std::string &systemPrompt)
+        {
+            if (!systemPrompt.empty())
+            {
+                return "<|system|>\n" + systemPrompt + "\n</|system|>\n<|user|>\n" + prompt + "\n</|user|>\n<|assistant|>\n";
+            }
+            return "<|user|>\n" + prompt + "\n</|user|>\n<|assistant|>\n";
+        }
+
+        const std::vector<std::string> kStopSequences = {
+            // ChatML format markers
+            "<|system|>", "</|system|>", "<|user|>", "</|user|>", "<|assistant|>", "</|assistant|>",
+            // User/assistant markers
+            "User:", "Wee Hung:", "Tarius:", "You:", "Human:",
+            // Common model regeneration patterns
+            "System:", "Assistant:", "AI:", "Model:",
+            // Other harmful leaks
+            "system prompt", "System Prompt", "SYSTEM PROMPT"};
+
+        // Only this much of the end of a response is searched for stop
+        // sequences; more than the longest one
+        constexpr std::size_t kStopWindow = 20;
+
+        // How much of a response can be shown: all but an ending that could
+        // still grow into a stop sequence or is an incomplete UTF-8 character
+        std::size_t streamableLength(const std::string &text)
+        {
+            std::size_t length = text.size();
+            for (std::size_t keep = std::min(length, kStopWindow); keep > 0; keep--)
+            {
+                const char *tail = text.data() + length - keep;
+                bool prefix = std::any_of(kStopSequences.begin(), kStopSequences.end(), [&](const std::string &stop)
+                                          { return stop.size() > keep && stop.compare(0, keep, tail, keep) == 0; });
+                if (prefix)
+                {
+                    length -= keep;
+                    break;
+                }
+            }
+
+            // Back up to the start of a multi-byte character that isn't complete
+            for (std::size_t back = 1; back <= 3 && back <= length; back++)
+            {
+                unsigned char c = static_cast<unsigned char>(text[length - back]);
+                if ((c & 0xC0) == 0x80)
+                {
+                    continue; // Continuation byte
+                }
+                std::size_t needed = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+                if (needed > back)
+                {
+                    length -= back;
+                }
+                break;
+            }
+            return length;
+        }
+
+        bool tokenize(const llama_vocab *vocab, const std::string &text, std::vector<llama_token> &tokens)
+        {
+            int n_tokens = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, true, true);
+            if (n_tokens <= 0)
+            {
+                return false;
+            }
+            tokens.resize(n_tokens);
+            return llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), tokens.size(), true, true) >= 0;
+        }
+
+        void addToBatch(llama_batch &batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits)
+        {
+            int i = batch.n_tokens++;
+            batch.token[i] = token;
+            batch.pos[i] = pos;
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = seq;
+            batch.logits[i] = logits;
+        }
+
+        // Frees a llama_batch on every way out of a scope
+        struct ScopedBatch
+        {
+            llama_batch batch;
+
+            explicit ScopedBatch(int32_t capacity) : batch(llama_batch_init(capacity, 0, 1)) {}
+            ~ScopedBatch() { llama_batch_free(batch); }
+
+            ScopedBatch(const ScopedBatch &) = delete;
+            ScopedBatch &operator=(const ScopedBatch &) = delete;
+        };
+
+        // Spilled sequence files start with this, then a tag naming the model
+        // they were made with, the cached tokens and llama.cpp's sequence state
+        constexpr char kSpillMagic[4] = {'T', 'K', 'V', '1'};
+
+        template <typename T>
+        void writeValue(std::ofstream &out, const T &value)
+        {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        template <typename T>
+        bool readValue(std::ifstream &in, T &value)
+        {
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+        }
+    } // namespace
+
     // Private implementation struct to hide llama.cpp details
     struct LlamaModel::PrivateImplementation
     {
@@ -18,9 +154,197 @@ namespace tarius::models
         llama_context *ctx = nullptr;
         const llama_vocab *vocab = nullptr;
         llama_sampler *sampler = nullptr;
+        llama_context *embedCtx = nullptr; // Created lazily by embed()
+
+        // What each sequence of ctx holds, for generate() with a CachedSequence
+        struct SequenceSlot
+        {
+            bool inUse = false;
+            std::string key;
+            std::string spillPath;
+            std::vector<llama_token> tokens; // In the KV cache from position 0
+            uint64_t lastUsed = 0;
+        };
+        std::vector<SequenceSlot> slots; // One per parallel sequence, then the scratch one
+        uint64_t useClock = 0;
+        std::string spillTag; // Spilled state only loads into the model and context size it came from
+
+        // Sequence to generate on for the key, restoring or evicting as needed.
+        // Calls without a key, such as summaries, get the scratch sequence and
+        // never push a conversation out.
+        llama_seq_id acquire(const CachedSequence &sequence)
+        {
+            useClock++;
+            const std::size_t scratch = slots.size() - 1;
+            if (sequence.key.empty())
+            {
+                slots[scratch].inUse = true;
+                slots[scratch].lastUsed = useClock;
+                return static_cast<llama_seq_id>(scratch);
+            }
+
+            llama_seq_id chosen = -1;
+            for (std::size_t i = 0; i < scratch; i++)
+            {
+                if (slots[i].inUse && slots[i].key == sequence.key)
+                {
+                    slots[i].lastUsed = useClock;
+                    return static_cast<llama_seq_id>(i);
+                }
+                bool older = chosen < 0 || (slots[chosen].inUse && (!slots[i].inUse || slots[i].lastUsed < slots[chosen].lastUsed));
+                if (older)
+                {
+                    chosen = static_cast<llama_seq_id>(i);
+                }
+            }
+
+            evict(chosen);
+            SequenceSlot &slot = slots[chosen];
+            slot.inUse = true;
+            slot.key = sequence.key;
+            slot.spillPath = sequence.spillPath;
+            slot.lastUsed = useClock;
+            if (!slot.spillPath.empty() && fs::exists(slot.spillPath))
+            {
+                restore(chosen);
+            }
+            return chosen;
+        }
+
+        // Write a sequence out if it has somewhere to go, then free it
+        void evict(llama_seq_id seq)
+        {
+            SequenceSlot &slot = slots[seq];
+            if (slot.inUse && !slot.spillPath.empty() && !slot.tokens.empty())
+            {
+                spill(seq);
+            }
+            llama_memory_seq_rm(llama_get_memory(ctx), seq, -1, -1);
+            slot = SequenceSlot{};
+        }
+
+        void evictAll()
+        {
+            for (std::size_t i = 0; i < slots.size(); i++)
+            {
+                evict(static_cast<llama_seq_id>(i));
+            }
+        }
+
+        void spill(llama_seq_id seq)
+        {
+            TRACE_SCOPE("llama.spill");
+            SequenceSlot &slot = slots[seq];
+            std::vector<uint8_t> state(llama_state_seq_get_size(ctx, seq));
+            if (state.empty() || llama_state_seq_get_data(ctx, state.data(), state.size(), seq) != state.size())
+            {
+                LOG_WARN("Failed to read the KV cache of {}", slot.key);
+                return;
+            }
+
+            std::error_code ec;
+            fs::path path(slot.spillPath);
+            if (path.has_parent_path())
+            {
+                fs::create_directories(path.parent_path(), ec);
+            }
+
+            // Written aside and renamed, so a crash never leaves half a file
+            std::string tmpPath = slot.spillPath + ".tmp";
+            {
+                std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+                out.write(kSpillMagic, sizeof(kSpillMagic));
+                writeValue(out, static_cast<uint32_t>(spillTag.size()));
+                out.write(spillTag.data(), static_cast<std::streamsize>(spillTag.size()));
+                writeValue(out, static_cast<uint64_t>(slot.tokens.size()));
+                out.write(reinterpret_cast<const char *>(slot.tokens.data()),
+                          static_cast<std::streamsize>(slot.tokens.size() * sizeof(llama_token)));
+                writeValue(out, static_cast<uint64_t>(state.size()));
+                out.write(reinterpret_cast<const char *>(state.data()), static_cast<std::streamsize>(state.size()));
+                if (!out)
+                {
+                    LOG_WARN("Failed to write the KV cache of {} to {}", slot.key, tmpPath);
+                    fs::remove(tmpPath, ec);
+                    return;
+                }
+            }
+            fs::rename(tmpPath, slot.spillPath, ec);
+            if (ec)
+            {
+                LOG_WARN("Failed to write the KV cache of {} to {}: {}", slot.key, slot.spillPath, ec.message());
+                return;
+            }
+            LOG_INFO("Saved {} cached tokens of {} to {}", slot.tokens.size(), slot.key, slot.spillPath);
+        }
+
+        // Load a spilled sequence; the file is used up either way
+        void restore(llama_seq_id seq)
+        {
+            TRACE_SCOPE("llama.restore");
+            SequenceSlot &slot = slots[seq];
+            bool restored = false;
+            {
+                std::ifstream in(slot.spillPath, std::ios::binary);
+                char magic[sizeof(kSpillMagic)];
+                uint32_t tagSize = 0;
+                uint64_t tokenCount = 0;
+                uint64_t stateSize = 0;
+                std::string tag;
+                std::vector<llama_token> tokens;
+                std::vector<uint8_t> state;
+
+                bool ok = in.read(magic, sizeof(magic)) && std::memcmp(magic, kSpillMagic, sizeof(magic)) == 0 &&
+                          readValue(in, tagSize) && tagSize <= 4096;
+                if (ok)
+                {
+                    tag.resize(tagSize);
+                    ok = in.read(tag.data(), tagSize) && tag == spillTag && readValue(in, tokenCount) &&
+                         tokenCount <= (1u << 24);
+                }
+                if (ok)
+                {
+                    tokens.resize(tokenCount);
+                    ok = in.read(reinterpret_cast<char *>(tokens.data()),
+                                 static_cast<std::streamsize>(tokenCount * sizeof(llama_token))) &&
+                         readValue(in, stateSize) && stateSize <= (1ull << 34);
+                }
+                if (ok)
+                {
+                    state.resize(stateSize);
+                    ok = in.read(reinterpret_cast<char *>(state.data()), static_cast<std::streamsize>(stateSize)) &&
+                         llama_state_seq_set_data(ctx, state.data(), state.size(), seq) != 0;
+                }
+
+                if (ok)
+                {
+                    slot.tokens = std::move(tokens);
+                    restored = true;
+                }
+                else
+                {
+                    llama_memory_seq_rm(llama_get_memory(ctx), seq, -1, -1);
+                }
+            }
+
+            std::error_code ec;
+            fs::remove(slot.spillPath, ec);
+            if (restored)
+            {
+                LOG_INFO("Restored {} cached tokens of {} from {}", slot.tokens.size(), slot.key, slot.spillPath);
+            }
+            else
+            {
+                LOG_WARN("Discarded unusable KV cache file {}", slot.spillPath);
+            }
+        }
 
         ~PrivateImplementation()
         {
+            if (embedCtx)
+            {
+                llama_free(embedCtx);
+                embedCtx = nullptr;
+            }
             if (sampler)
             {
                 llama_sampler_free(sampler);
@@ -45,7 +369,8 @@ namespace tarius::models
      * @param config The model configuration containing model path, context size, etc.
      */
     LlamaModel::LlamaModel(const ModelConfig &config)
-        : m_config(config), m_initialized(false), m_impl(std::make_unique<PrivateImplementation>())
+        : m_config(config), m_initialized(false), m_parallel(1), m_responses(0), m_promptTokens(0),
+          m_generatedTokens(0), m_impl(std::make_unique<PrivateImplementation>())
     {
     }
 
@@ -59,7 +384,7 @@ namespace tarius::models
      * @brief Initializes the LLaMA model and its context.
      *
      * Loads the model from the specified path, creates a context with the configured
-     * parameters, and sets up a greedy sampler for text generation.
+     * parameters, and sets up the configured sampler for text generation.
      *
      * @return true if initialization was successful, false otherwise.
      */
@@ -93,9 +418,13 @@ namespace tarius::models
         // Get the vocabulary
         m_impl->vocab = llama_model_get_vocab(m_impl->model);
 
-        // Context parameters
+        // Context parameters; each parallel sequence gets a full context, and
+        // so does the scratch sequence behind them
+        m_parallel = std::max(1, m_config.parallel);
         llama_context_params ctx_params = llama_context_default_params();
-        ctx_params.n_ctx = m_config.context_size;
+        ctx_params.n_ctx = m_config.context_size * (m_parallel + 1);
+        ctx_params.n_batch = m_config.context_size;
+        ctx_params.n_seq_max = m_parallel + 1;
         ctx_params.n_threads = m_config.threads;
         ctx_params.n_threads_batch = m_config.threads;
 
@@ -109,15 +438,11 @@ namespace tarius::models
             return false;
         }
 
-        // Initialize the sampler with default chain
-        auto sparams = llama_sampler_chain_default_params();
-        m_impl->sampler = llama_sampler_chain_init(sparams);
+        // Initialize the sampler chain
+        m_impl->sampler = createSampler(m_config);
 
-        // Add a greedy sampler (simplest option)
-        llama_sampler_chain_add(m_impl->sampler, llama_sampler_init_greedy());
-        // llama_sampler_chain_add(m_impl->sampler, llama_sampler_init_top_k(40));
-        // llama_sampler_chain_add(m_impl->sampler, llama_sampler_init_top_p(0.9, 0.05));
-        // llama_sampler_chain_add(m_impl->sampler, llama_sampler_init_temperature(0.7));
+        m_impl->slots.assign(m_parallel + 1, {});
+        m_impl->spillTag = m_config.model_path + "|" + std::to_string(m_config.context_size);
 
         LOG_INFO("Model initialized successfully");
         m_initialized = true;
@@ -229,6 +554,65 @@ namespace tarius::models
      */
     std::string LlamaModel::generate(const std::string &prompt)
     {
+        return generate(prompt, m_config.system_prompt);
+    }
+
+    /**
+     * @brief Generates text under the given system prompt.
+     *
+     * Every prompt is self-contained: the sampler is reset, and what the
+     * previous call left in the KV cache is only reused where it matches
+     * the new prompt token for token. This also lets the background
+     * summarizer share the context with interactive generation.
+     *
+     * @param prompt The input text to generate a response for.
+     * @param systemPrompt The system prompt, or empty for none.
+     * @return The generated text response.
+     */
+    std::string LlamaModel::generate(const std::string &prompt, const std::string &systemPrompt)
+    {
+        return generate(prompt, systemPrompt, nullptr);
+    }
+
+    /**
+     * @brief Generates text under the given system prompt, streaming it as it comes.
+     *
+     * Runs on a scratch sequence, so cached conversations are left alone
+     * unless it has to take one's place.
+     *
+     * @param prompt The input text to generate a response for.
+     * @param systemPrompt The system prompt, or empty for none.
+     * @param onToken Called with each new piece; returning false stops generation.
+     * @return The generated text response.
+     */
+    std::string LlamaModel::generate(const std::string &prompt, const std::string &systemPrompt,
+                                     const TokenCallback &onToken)
+    {
+        return generate(prompt, systemPrompt, onToken, CachedSequence{});
+    }
+
+    /**
+     * @brief Generates text on a conversation's cached sequence, streaming it as it comes.
+     *
+     * The prompt's longest prefix already in the sequence's KV cache is
+     * kept and only the rest is decoded; the response stays in the cache
+     * for the next turn.
+     *
+     * The listener gets the response in order, in pieces. The end of the
+     * text is held back while it could still turn into a stop sequence or
+     * is a partial UTF-8 character, so nothing passed on is taken back.
+     *
+     * @param prompt The input text to generate a response for.
+     * @param systemPrompt The system prompt, or empty for none.
+     * @param onToken Called with each new piece; returning false stops generation.
+     * @param sequence The conversation whose cache to use.
+     * @return The generated text response.
+     */
+    std::string LlamaModel::generate(const std::string &prompt, const std::string &systemPrompt,
+                                     const TokenCallback &onToken, const CachedSequence &sequence)
+    {
+        // Started before the lock, so waiting on the summarizer shows up
+        TRACE_SCOPE("llama.generate");
         std::lock_guard<std::mutex> lock(m_mutex);
 
         if (!m_initialized)
@@ -238,18 +622,10 @@ namespace tarius::models
         }
 
         // Prepare the full prompt using ChatML format
-        std::string full_prompt;
-        if (!m_config.system_prompt.empty())
-        {
-            full_prompt = "<|system|>\n" + m_config.system_prompt + "\n</|system|>\n<|user|>\n" + prompt + "\n</|user|>\n<|assistant|>\n";
-        }
-        else
-        {
-            full_prompt = "<|user|>\n" + prompt + "\n</|user|>\n<|assistant|>\n";
-        }
+        std::string full_prompt = formatPrompt(prompt, systemPrompt);
 
         // log out the full prompt with '====' before and after
-        LOG_INFO("\n\nFull prompt with History\n====\n{}\n====\n\n", full_prompt);
+        LOG_DEBUG("\n\nFull prompt with History\n====\n{}\n====\n\n", full_prompt);
 
         // Check context length before tokenizing
         int estimated_tokens = full_prompt.length() / 4; // rough estimate
@@ -260,55 +636,86 @@ namespace tarius::models
 
         // Tokenize the prompt
         std::vector<llama_token> tokens;
-
-        // Get the count of tokens
-        int n_tokens = -llama_tokenize(m_impl->vocab, full_prompt.c_str(), full_prompt.length(), nullptr, 0, true, true);
-        if (n_tokens <= 0)
         {
-            LOG_ERROR("Failed to count tokens");
-            return "Error: Failed to tokenize prompt";
+            TRACE_SCOPE("llama.tokenize");
+            if (!tokenize(m_impl->vocab, full_prompt, tokens))
+            {
+                LOG_ERROR("Failed to tokenize prompt");
+                return "Error: Failed to tokenize prompt";
+            }
+            LOG_INFO("Tokenized prompt length: {} tokens (context size: {})", tokens.size(), m_config.context_size);
         }
+        m_responses.fetch_add(1, std::memory_order_relaxed);
+        m_promptTokens.fetch_add(tokens.size(), std::memory_order_relaxed);
 
-        LOG_INFO("Tokenized prompt length: {} tokens (context size: {})", n_tokens, m_config.context_size);
+        llama_seq_id seq = m_impl->acquire(sequence);
+        std::vector<llama_token> &cached = m_impl->slots[seq].tokens;
+        llama_memory_t memory = llama_get_memory(m_impl->ctx);
 
-        // Resize the vector and tokenize
-        tokens.resize(n_tokens);
-        if (llama_tokenize(m_impl->vocab, full_prompt.c_str(), full_prompt.length(), tokens.data(), tokens.size(), true, true) < 0)
+        // Keep what the cache shares with this prompt; the last prompt token
+        // is always decoded, as its logits pick the first response token
+        std::size_t reuse = std::mismatch(cached.begin(), cached.end(), tokens.begin(), tokens.end()).first - cached.begin();
+        reuse = std::min(reuse, tokens.size() - 1);
+        if (!llama_memory_seq_rm(memory, seq, static_cast<llama_pos>(reuse), -1))
         {
-            LOG_ERROR("Failed to tokenize prompt");
-            return "Error: Failed to tokenize prompt";
+            llama_memory_seq_rm(memory, seq, -1, -1);
+            reuse = 0;
         }
+        cached.resize(reuse);
+        LOG_DEBUG("Reusing {} of {} prompt tokens from the KV cache", reuse, tokens.size());
 
-        // Prepare a batch for the prompt
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
+        llama_sampler_reset(m_impl->sampler);
+        ScopedBatch scoped(m_config.context_size);
+        llama_batch &batch = scoped.batch;
 
-        // Evaluate the prompt
-        if (llama_decode(m_impl->ctx, batch))
+        // Evaluate the rest of the prompt, a batch at a time
         {
-            LOG_ERROR("Failed to decode prompt");
-            return "Error: Failed to decode prompt";
+            TRACE_SCOPE("llama.prompt_decode");
+            for (std::size_t start = reuse; start < tokens.size(); start += m_config.context_size)
+            {
+                std::size_t end = std::min(tokens.size(), start + m_config.context_size);
+                batch.n_tokens = 0;
+                for (std::size_t i = start; i < end; i++)
+                {
+                    addToBatch(batch, tokens[i], static_cast<llama_pos>(i), seq, i + 1 == tokens.size());
+                }
+                if (llama_decode(m_impl->ctx, batch))
+                {
+                    LOG_ERROR("Failed to decode prompt");
+                    llama_memory_seq_rm(memory, seq, -1, -1);
+                    cached.clear();
+                    return "Error: Failed to decode prompt";
+                }
+                cached.insert(cached.end(), tokens.begin() + start, tokens.begin() + end);
+            }
         }
 
         // Generate the response
-        std::stringstream ss;
+        std::string response;
         std::string buffer; // Buffer to check for stop sequences
+        std::size_t streamed = 0;
         llama_token new_token_id;
         int n_predict = 0;
 
-        const std::vector<std::string> stop_sequences = {
-            // ChatML format markers
-            "<|system|>", "</|system|>", "<|user|>", "</|user|>", "<|assistant|>", "</|assistant|>",
-            // User/assistant markers
-            "User:", "Wee Hung:", "Tarius:", "You:", "Human:",
-            // Common model regeneration patterns
-            "System:", "Assistant:", "AI:", "Model:",
-            // Other harmful leaks
-            "system prompt", "System Prompt", "SYSTEM PROMPT"};
+        // Hand the listener whatever is new up to `end`; false once it wants no more
+        auto stream = [&](std::size_t end)
+        {
+            if (!onToken || end <= streamed)
+            {
+                return true;
+            }
+            bool more = onToken(response.substr(streamed, end - streamed));
+            streamed = end;
+            return more;
+        };
 
         while (n_predict < m_config.n_predict)
         {
             // Sample the next token
-            new_token_id = llama_sampler_sample(m_impl->sampler, m_impl->ctx, -1);
+            {
+                TRACE_SCOPE("llama.sample");
+                new_token_id = llama_sampler_sample(m_impl->sampler, m_impl->ctx, -1);
+            }
 
             // Check for end of generation
             if (llama_vocab_is_eog(m_impl->vocab, new_token_id))
@@ -326,49 +733,348 @@ namespace tarius::models
             }
 
             // Append to result and buffer
-            ss.write(buf, n);
+            m_generatedTokens.fetch_add(1, std::memory_order_relaxed);
+            response.append(buf, n);
             buffer += std::string(buf, n);
 
             // Check if any stop sequence is found
             bool should_stop = false;
-            for (const auto &stop_seq : stop_sequences)
             {
-                if (buffer.find(stop_seq) != std::string::npos)
+                TRACE_SCOPE("llama.stop_match");
+                for (const auto &stop_seq : kStopSequences)
                 {
-                    should_stop = true;
-                    // Trim the stop sequence from the output
-                    std::string result = ss.str();
-                    size_t pos = result.find(stop_seq);
-                    if (pos != std::string::npos)
+                    if (buffer.find(stop_seq) != std::string::npos)
                     {
-                        result = result.substr(0, pos);
+                        should_stop = true;
+                        // Trim the stop sequence from the output
+                        size_t pos = response.find(stop_seq);
+                        if (pos != std::string::npos)
+                        {
+                            response.resize(pos);
+                        }
+                        break;
                     }
-                    return result;
+                }
+
+                // Keep buffer size manageable (only need to check last N characters)
+                if (buffer.length() > kStopWindow)
+                {
+                    buffer = buffer.substr(buffer.length() - kStopWindow);
                 }
             }
             if (should_stop)
                 break;
 
-            // Keep buffer size manageable (only need to check last N characters)
-            if (buffer.length() > 20)
-            { // 20 is more than longest stop sequence
-                buffer = buffer.substr(buffer.length() - 20);
+            if (!stream(streamableLength(response)))
+            {
+                LOG_INFO("Generation cancelled after {} tokens", n_predict + 1);
+                break;
             }
 
             // Prepare next batch with the new token
-            batch = llama_batch_get_one(&new_token_id, 1);
+            batch.n_tokens = 0;
+            addToBatch(batch, new_token_id, static_cast<llama_pos>(cached.size()), seq, true);
 
             // Decode the token
-            if (llama_decode(m_impl->ctx, batch))
             {
-                LOG_ERROR("Failed to decode token");
-                break;
+                TRACE_SCOPE("llama.decode");
+                if (llama_decode(m_impl->ctx, batch))
+                {
+                    LOG_ERROR("Failed to decode token");
+                    break;
+                }
             }
+            cached.push_back(new_token_id);
 
             n_predict++;
         }
 
-        return ss.str();
+        stream(response.size());
+        return response;
+    }
+
+    /**
+     * @brief Generates responses to many prompts under the configured system prompt.
+     *
+     * @param prompts The prompts to generate responses for.
+     * @return One response per prompt, in order.
+     */
+    std::vector<std::string> LlamaModel::generateBatch(const std::vector<std::string> &prompts)
+    {
+        return generateBatch(prompts, m_config.system_prompt);
+    }
+
+    /**
+     * @brief Generates responses to many prompts with continuous batching.
+     *
+     * Each of up to m_parallel sequences holds one prompt. Every step decodes
+     * one llama_batch holding the last sampled token of each running sequence
+     * plus the whole of any prompts just admitted, then samples each running
+     * sequence from its own logits. A sequence that finishes gives up its
+     * KV cells and takes the next prompt on the following step, so the batch
+     * stays full until the queue runs out.
+     *
+     * @param prompts The prompts to generate responses for.
+     * @param systemPrompt The system prompt, or empty for none.
+     * @return One response per prompt, in order.
+     */
+    std::vector<std::string> LlamaModel::generateBatch(const std::vector<std::string> &prompts,
+                                                       const std::string &systemPrompt)
+    {
+        TRACE_SCOPE("llama.generate_batch");
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<std::string> results(prompts.size());
+        if (!m_initialized)
+        {
+            LOG_ERROR("Model not initialized");
+            std::fill(results.begin(), results.end(), "Error: Model not initialized");
+            return results;
+        }
+        if (prompts.empty())
+        {
+            return results;
+        }
+
+        struct Sequence
+        {
+            bool active = false;
+            std::size_t prompt = 0;   // Index into prompts
+            llama_pos pos = 0;        // Next position in this sequence
+            int32_t logitIndex = 0;   // Batch index of the token to sample from
+            llama_token last = 0;     // Sampled last step, decoded this step
+            int predicted = 0;
+            std::string text;
+            std::string tail; // End of text, searched for stop sequences
+            llama_sampler *sampler = nullptr;
+        };
+
+        // One decode holds at most a context's worth of tokens, and every
+        // sequence gets its own context
+        const int capacity = m_config.context_size;
+        std::vector<Sequence> sequences(std::min<std::size_t>(m_parallel, prompts.size()));
+        for (auto &sequence : sequences)
+        {
+            sequence.sampler = createSampler(m_config);
+        }
+
+        // Every sequence is needed; cached conversations go to disk first
+        m_impl->evictAll();
+        llama_memory_t memory = llama_get_memory(m_impl->ctx);
+        llama_memory_clear(memory, true);
+        llama_batch batch = llama_batch_init(capacity, 0, 1);
+
+        auto finish = [&](llama_seq_id id, std::string result)
+        {
+            Sequence &sequence = sequences[id];
+            results[sequence.prompt] = std::move(result);
+            sequence.active = false;
+            llama_memory_seq_rm(memory, id, -1, -1);
+            m_responses.fetch_add(1, std::memory_order_relaxed);
+        };
+
+        std::size_t next = 0;
+        std::vector<llama_token> pending; // Tokens of prompts[next] once tokenized
+        while (true)
+        {
+            batch.n_tokens = 0;
+
+            // Running sequences feed back the token they sampled last step
+            for (llama_seq_id id = 0; id < static_cast<llama_seq_id>(sequences.size()); id++)
+            {
+                Sequence &sequence = sequences[id];
+                if (sequence.active)
+                {
+                    sequence.logitIndex = batch.n_tokens;
+                    addToBatch(batch, sequence.last, sequence.pos++, id, true);
+                }
+            }
+
+            // Idle sequences take the next prompts while the batch has room
+            for (llama_seq_id id = 0; id < static_cast<llama_seq_id>(sequences.size()); id++)
+            {
+                Sequence &sequence = sequences[id];
+                if (sequence.active)
+                {
+                    continue;
+                }
+
+                // Tokenize the next prompt, failing any that can't be used
+                while (pending.empty() && next < prompts.size())
+                {
+                    TRACE_SCOPE("llama.tokenize");
+                    if (!tokenize(m_impl->vocab, formatPrompt(prompts[next], systemPrompt), pending) ||
+                        static_cast<int>(pending.size()) >= capacity)
+                    {
+                        LOG_ERROR("Failed to tokenize prompt {} of the batch, or it does not fit the context", next);
+                        results[next++] = "Error: Failed to tokenize prompt";
+                        pending.clear();
+                    }
+                }
+                if (pending.empty() || batch.n_tokens + static_cast<int>(pending.size()) > capacity)
+                {
+                    break; // Nothing left, or admitted on a later step
+                }
+
+                sequence.active = true;
+                sequence.prompt = next++;
+                sequence.pos = 0;
+                sequence.predicted = 0;
+                sequence.text.clear();
+                sequence.tail.clear();
+                llama_sampler_reset(sequence.sampler);
+                for (std::size_t i = 0; i < pending.size(); i++)
+                {
+                    addToBatch(batch, pending[i], sequence.pos++, id, i + 1 == pending.size());
+                }
+                sequence.logitIndex = batch.n_tokens - 1;
+                m_promptTokens.fetch_add(pending.size(), std::memory_order_relaxed);
+                pending.clear();
+            }
+
+            if (batch.n_tokens == 0)
+            {
+                break;
+            }
+
+            bool decoded;
+            {
+                TRACE_SCOPE("llama.decode");
+                decoded = llama_decode(m_impl->ctx, batch) == 0;
+            }
+            if (!decoded)
+            {
+                LOG_ERROR("Failed to decode batch of {} tokens", batch.n_tokens);
+                for (llama_seq_id id = 0; id < static_cast<llama_seq_id>(sequences.size()); id++)
+                {
+                    if (sequences[id].active)
+                    {
+                        finish(id, "Error: Failed to decode prompt");
+                    }
+                }
+                for (; next < prompts.size(); next++)
+                {
+                    results[next] = "Error: Failed to decode prompt";
+                }
+                break;
+            }
+
+            for (llama_seq_id id = 0; id < static_cast<llama_seq_id>(sequences.size()); id++)
+            {
+                Sequence &sequence = sequences[id];
+                if (!sequence.active)
+                {
+                    continue;
+                }
+
+                llama_token token;
+                {
+                    TRACE_SCOPE("llama.sample");
+                    token = llama_sampler_sample(sequence.sampler, m_impl->ctx, sequence.logitIndex);
+                }
+                if (llama_vocab_is_eog(m_impl->vocab, token))
+                {
+                    finish(id, std::move(sequence.text));
+                    continue;
+                }
+
+                char buf[128];
+                int n = llama_token_to_piece(m_impl->vocab, token, buf, sizeof(buf), 0, true);
+                if (n < 0)
+                {
+                    LOG_ERROR("Failed to convert token to piece");
+                    finish(id, std::move(sequence.text));
+                    continue;
+                }
+                m_generatedTokens.fetch_add(1, std::memory_order_relaxed);
+                sequence.text.append(buf, n);
+                sequence.tail.append(buf, n);
+
+                // Same stop rules as generate()
+                std::size_t stop = std::string::npos;
+                {
+                    TRACE_SCOPE("llama.stop_match");
+                    for (const auto &stop_seq : kStopSequences)
+                    {
+                        if (sequence.tail.find(stop_seq) != std::string::npos)
+                        {
+                            stop = sequence.text.find(stop_seq);
+                            break;
+                        }
+                    }
+                    if (sequence.tail.length() > kStopWindow)
+                    {
+                        sequence.tail.erase(0, sequence.tail.length() - kStopWindow);
+                    }
+                }
+                if (stop != std::string::npos)
+                {
+                    finish(id, sequence.text.substr(0, stop));
+                    continue;
+                }
+
+                if (++sequence.predicted >= m_config.n_predict || sequence.pos >= capacity)
+                {
+                    finish(id, std::move(sequence.text));
+                    continue;
+                }
+                sequence.last = token;
+            }
+        }
+
+        llama_batch_free(batch);
+        for (auto &sequence : sequences)
+        {
+            llama_sampler_free(sequence.sampler);
+        }
+        return results;
+    }
+
+    /**
+     * @brief Applies new settings to a loaded model.
+     *
+     * Thread counts, the token limit and sampling take effect from the next
+     * call; waits for one in progress. The model path and context size only
+     * apply when the model is next loaded.
+     *
+     * @param config The new configuration.
+     */
+    void LlamaModel::updateSettings(const ModelConfig &config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        bool samplingChanged = config.temperature != m_config.temperature || config.top_k != m_config.top_k ||
+                               config.top_p != m_config.top_p;
+        if (config.model_path != m_config.model_path || config.context_size != m_config.context_size ||
+            config.parallel != m_config.parallel)
+        {
+            LOG_INFO("Model path, context size and parallel sequence changes apply when the model is next loaded");
+        }
+
+        m_config.threads = config.threads;
+        m_config.n_predict = config.n_predict;
+        m_config.temperature = config.temperature;
+        m_config.top_k = config.top_k;
+        m_config.top_p = config.top_p;
+        m_config.system_prompt = config.system_prompt;
+
+        if (!m_initialized)
+        {
+            return;
+        }
+
+        llama_set_n_threads(m_impl->ctx, m_config.threads, m_config.threads);
+        if (m_impl->embedCtx)
+        {
+            llama_set_n_threads(m_impl->embedCtx, m_config.threads, m_config.threads);
+        }
+        if (samplingChanged)
+        {
+            llama_sampler_free(m_impl->sampler);
+            m_impl->sampler = createSampler(m_config);
+        }
+        LOG_INFO("Model settings updated: {} threads, {} tokens, temperature {}", m_config.threads,
+                 m_config.n_predict, m_config.temperature);
     }
 
     /**
@@ -395,4 +1101,141 @@ namespace tarius::models
         std::string prompt = "Summarise the following conversation: " + conversation;
         return generate(prompt);
     }
-} // namespace tarius::models
\ No newline at end of file
+
+    /**
+     * @brief Embeds text using a dedicated embeddings-mode context.
+     *
+     * The context is created on first use with mean pooling so that decoder-only
+     * GGUF models produce one vector per input. Input longer than the context
+     * is truncated. The result is L2-normalised so that a dot product between
+     * two embeddings is their cosine similarity.
+     *
+     * @param text The text to embed.
+     * @return The embedding, or an empty vector on failure.
+     */
+    std::vector<float> LlamaModel::embed(const std::string &text)
+    {
+        TRACE_SCOPE("llama.embed");
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_initialized || text.empty())
+        {
+            return {};
+        }
+
+        if (!m_impl->embedCtx)
+        {
+            llama_context_params ctx_params = llama_context_default_params();
+            ctx_params.n_ctx = m_config.context_size;
+            ctx_params.n_batch = m_config.context_size;
+            ctx_params.n_ubatch = m_config.context_size;
+            ctx_params.n_threads = m_config.threads;
+            ctx_params.n_threads_batch = m_config.threads;
+            ctx_params.embeddings = true;
+            ctx_params.pooling_type = LLAMA_POOLING_TYPE_MEAN;
+
+            m_impl->embedCtx = llama_init_from_model(m_impl->model, ctx_params);
+            if (!m_impl->embedCtx)
+            {
+                LOG_ERROR("Failed to create embedding context");
+                return {};
+            }
+        }
+
+        int n_tokens = -llama_tokenize(m_impl->vocab, text.c_str(), text.length(), nullptr, 0, true, true);
+        if (n_tokens <= 0)
+        {
+            LOG_ERROR("Failed to count tokens for embedding");
+            return {};
+        }
+
+        std::vector<llama_token> tokens(n_tokens);
+        if (llama_tokenize(m_impl->vocab, text.c_str(), text.length(), tokens.data(), tokens.size(), true, true) < 0)
+        {
+            LOG_ERROR("Failed to tokenize text for embedding");
+            return {};
+        }
+        if (static_cast<int>(tokens.size()) > m_config.context_size)
+        {
+            tokens.resize(m_config.context_size);
+        }
+
+        // Every call embeds an independent sequence
+        llama_memory_clear(llama_get_memory(m_impl->embedCtx), true);
+
+        llama_batch batch = llama_batch_init(tokens.size(), 0, 1);
+        for (size_t i = 0; i < tokens.size(); i++)
+        {
+            batch.token[i] = tokens[i];
+            batch.pos[i] = static_cast<llama_pos>(i);
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = 0;
+            batch.logits[i] = true;
+        }
+        batch.n_tokens = static_cast<int32_t>(tokens.size());
+
+        std::vector<float> embedding;
+        if (llama_decode(m_impl->embedCtx, batch))
+        {
+            LOG_ERROR("Failed to decode text for embedding");
+        }
+        else if (const float *pooled = llama_get_embeddings_seq(m_impl->embedCtx, 0))
+        {
+            int n_embd = llama_model_n_embd(m_impl->model);
+            embedding.assign(pooled, pooled + n_embd);
+
+            double norm = 0.0;
+            for (float v : embedding)
+            {
+                norm += static_cast<double>(v) * v;
+            }
+            if (norm > 0.0)
+            {
+                float inv = static_cast<float>(1.0 / std::sqrt(norm));
+                for (float &v : embedding)
+                {
+                    v *= inv;
+                }
+            }
+        }
+        else
+        {
+            LOG_ERROR("Embedding context returned no pooled embedding");
+        }
+
+        llama_batch_free(batch);
+        return embedding;
+    }
+
+    /**
+     * @brief Returns the responses and tokens processed since the model was created.
+     */
+    GenerationStats LlamaModel::getStats() const
+    {
+        GenerationStats stats;
+        stats.responses = m_responses.load(std::memory_order_relaxed);
+        stats.promptTokens = m_promptTokens.load(std::memory_order_relaxed);
+        stats.generatedTokens = m_generatedTokens.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * @brief Counts the tokens in a piece of text.
+     *
+     * Used to fit retrieved memories into a prompt token budget.
+     *
+     * @param text The text to tokenize.
+     * @return The token count, or -1 if the model is not initialized.
+     */
+    int LlamaModel::countTokens(const std::string &text)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_initialized)
+        {
+            return -1;
+        }
+
+        return -llama_tokenize(m_impl->vocab, text.c_str(), text.length(), nullptr, 0, false, true);
+    }
+} // namespace tarius::models
@@ -4,9 +4,20 @@
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 
 namespace tarius::models
 {
+    // Running totals of the model's work since it was loaded
+    struct GenerationStats
+    {
+        uint64_t responses = 0;
+        uint64_t promptTokens = 0;
+        uint64_t generatedTokens = 0;
+    };
+
     /**
      * @brief A wrapper class for the llama.cpp library.
      *
@@ -21,9 +32,10 @@ namespace tarius::models
         {
             std::string model_path;         // Path to the model file
             int context_size = 2048;        // Context size for the model
+            int parallel = 1;               // Sequences generateBatch decodes together, each with context_size
             int threads = 4;                // Number of threads to use
             int n_predict = 256;            // Maximum number of tokens to predict
-            float temperature = 0.8f;       // Sampling temperature
+            float temperature = 0.0f;       // Sampling temperature; 0 always picks the likeliest token
             int top_k = 40;                 // Top-k sampling parameter
             float top_p = 0.9f;             // Top-p sampling parameter
             std::string system_prompt = ""; // System prompt to use
@@ -56,6 +68,85 @@ namespace tarius::models
          */
         std::string generate(const std::string &prompt);
 
+        /**
+         * @brief Generate a response under a specific system prompt.
+         *
+         * @param prompt The prompt to generate a response for
+         * @param systemPrompt The system prompt to use instead of the configured one
+         * @return The generated response
+         */
+        std::string generate(const std::string &prompt, const std::string &systemPrompt);
+
+        // Receives a response as it is generated; returning false stops it early
+        using TokenCallback = std::function<bool(const std::string &piece)>;
+
+        /**
+         * @brief Generate a response, passing it on piece by piece as it is produced.
+         *
+         * @param prompt The prompt to generate a response for
+         * @param systemPrompt The system prompt, or empty for none
+         * @param onToken Gets each new piece of the response; may be empty
+         * @return The whole generated response
+         */
+        std::string generate(const std::string &prompt, const std::string &systemPrompt, const TokenCallback &onToken);
+
+        /**
+         * @brief A conversation whose KV cache is kept from one call to the next.
+         *
+         * The context holds ModelConfig::parallel sequences for keyed calls,
+         * plus one scratch sequence that calls with an empty key share. Calls
+         * with the same key use the same sequence and only decode the part of
+         * the prompt that differs from what it already holds. When a key needs
+         * a sequence and none is free, the least recently used one is written
+         * to its spillPath and read back when its key returns.
+         */
+        struct CachedSequence
+        {
+            std::string key;
+            std::string spillPath; // Empty to drop the cache when evicted
+        };
+
+        /**
+         * @brief Generate a response on a conversation's cached sequence.
+         *
+         * @param prompt The prompt to generate a response for
+         * @param systemPrompt The system prompt, or empty for none
+         * @param onToken Gets each new piece of the response; may be empty
+         * @param sequence The conversation whose cache to use and extend
+         * @return The whole generated response
+         */
+        std::string generate(const std::string &prompt, const std::string &systemPrompt, const TokenCallback &onToken,
+                             const CachedSequence &sequence);
+
+        /**
+         * @brief Generate responses to many prompts under the configured system prompt.
+         *
+         * @param prompts The prompts to generate responses for
+         * @return One response per prompt, in the same order
+         */
+        std::vector<std::string> generateBatch(const std::vector<std::string> &prompts);
+
+        /**
+         * @brief Generate responses to many prompts, decoding several at once.
+         *
+         * Up to ModelConfig::parallel prompts share each decode step as
+         * separate sequences; when one finishes, the next prompt takes its
+         * place. Each prompt is handled as generate() would handle it.
+         *
+         * @param prompts The prompts to generate responses for
+         * @param systemPrompt The system prompt, or empty for none
+         * @return One response per prompt, in the same order
+         */
+        std::vector<std::string> generateBatch(const std::vector<std::string> &prompts, const std::string &systemPrompt);
+
+        /**
+         * @brief Apply new thread, token limit and sampling settings.
+         *
+         * @param config The new configuration; its path and context size
+         *               are kept for the next load
+         */
+        void updateSettings(const ModelConfig &config);
+
         /**
          * @brief Check if the model has been initialized.
          *
@@ -71,9 +162,38 @@ namespace tarius::models
          */
         std::string summariseConversation(const std::string &conversation);
 
+        /**
+         * @brief Compute a sentence embedding for the given text.
+         *
+         * Uses a separate context in embeddings mode with mean pooling, so
+         * the generation context and its KV cache are left untouched.
+         *
+         * @param text The text to embed
+         * @return The L2-normalised embedding, or an empty vector on failure
+         */
+        std::vector<float> embed(const std::string &text);
+
+        /**
+         * @brief Count the tokens the model's vocabulary produces for the text.
+         *
+         * @param text The text to tokenize
+         * @return The number of tokens, or -1 if the model is not initialized
+         */
+        int countTokens(const std::string &text);
+
+        /**
+         * @brief Get the number of responses and tokens processed so far.
+         */
+        GenerationStats getStats() const;
+
     private:
         ModelConfig m_config;
         bool m_initialized;
+        int m_parallel; // Parallel sequences; the context has one more for scratch work
+
+        std::atomic<uint64_t> m_responses;
+        std::atomic<uint64_t> m_promptTokens;
+        std::atomic<uint64_t> m_generatedTokens;
 
         // Forward declarations for llama.cpp types to avoid including the headers
         struct PrivateImplementation;
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace tarius::models
+{
+    struct CacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        std::size_t capacityBytes = 0;
+    };
+
+    /**
+     * @brief Thread-safe LRU cache bounded by the approximate bytes it holds.
+     *
+     * Values are stored behind shared_ptr<const Value>, so a value handed out
+     * stays valid after it is evicted or replaced. The size of each value is
+     * measured once on insertion by the sizeOf function; values larger than
+     * the whole capacity are not cached.
+     */
+    template <typename Key, typename Value>
+    class LruCache
+    {
+    public:
+        using SizeOf = std::function<std::size_t(const Value &)>;
+
+        LruCache(std::size_t capacityBytes, SizeOf sizeOf)
+            : m_capacityBytes(capacityBytes), m_sizeOf(std::move(sizeOf))
+        {
+        }
+
+        // The cached value, or nullptr; a hit makes the entry most recently used
+        std::shared_ptr<const Value> get(const Key &key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_lookup.find(key);
+            if (it == m_lookup.end())
+            {
+                m_stats.misses++;
+                return nullptr;
+            }
+
+            m_stats.hits++;
+            m_order.splice(m_order.begin(), m_order, it->second);
+            return it->second->value;
+        }
+
+        void put(const Key &key, Value value)
+        {
+            std::size_t bytes = m_sizeOf(value);
+            auto shared = std::make_shared<const Value>(std::move(value));
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            eraseLocked(key);
+            if (bytes > m_capacityBytes)
+            {
+                return;
+            }
+
+            m_order.push_front({key, std::move(shared), bytes});
+            m_lookup[key] = m_order.begin();
+            m_stats.bytes += bytes;
+
+            while (m_stats.bytes > m_capacityBytes)
+            {
+                m_stats.evictions++;
+                Key victim = m_order.back().key;
+                eraseLocked(victim);
+            }
+        }
+
+        void erase(const Key &key)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            eraseLocked(key);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_order.clear();
+            m_lookup.clear();
+            m_stats.bytes = 0;
+        }
+
+        CacheStats stats() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            CacheStats stats = m_stats;
+            stats.entries = m_lookup.size();
+            stats.capacityBytes = m_capacityBytes;
+            return stats;
+        }
+
+    private:
+        struct Node
+        {
+            Key key;
+            std::shared_ptr<const Value> value;
+            std::size_t bytes;
+        };
+
+        std::size_t m_capacityBytes;
+        SizeOf m_sizeOf;
+
+        mutable std::mutex m_mutex;
+        std::list<Node> m_order; // Most recently used first
+        std::unordered_map<Key, typename std::list<Node>::iterator> m_lookup;
+        CacheStats m_stats;
+
+        void eraseLocked(const Key &key)
+        {
+            auto it = m_lookup.find(key);
+            if (it == m_lookup.end())
+            {
+                return;
+            }
+            m_stats.bytes -= it->second->bytes;
+            m_order.erase(it->second);
+            m_lookup.erase(it);
+        }
+    };
+
+} // namespace tarius::models
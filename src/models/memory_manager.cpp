@@ -1,12 +1,22 @@
 #include "memory_manager.h"
+#include "conversation_store.h"
+#include "recent_message_buffer.h"
+#include "search_index.h"
+#include "semantic_memory.h"
+#include "summarization_worker.h"
+#include "summary_rollup.h"
 #include "../utils/logger.h"
+#include "../utils/tracer.h"
 #include "../utils/json_handler.h"
+#include "../utils/config.h"
+#include "../utils/file_lock.h"
+#include "../utils/id_generator.h"
+#include "../utils/time_utils.h"
 #include <filesystem>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
-#include "llama_model.h"
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
@@ -14,8 +24,6 @@ using json = nlohmann::json;
 namespace tarius::models
 {
 
-    LlamaModel m_llamaModel{LlamaModel::ModelConfig({.system_prompt = "You are Tarius, an AI that summarizes conversations. Create concise, accurate summaries that capture the key points, topics, and outcomes of conversations. Focus on extracting the most important information while maintaining clarity and objectivity."})};
-
     // Message serialization
     std::string Message::toJson() const
     {
@@ -24,10 +32,7 @@ namespace tarius::models
         j["content"] = content;
 
         // Convert timestamp to ISO string
-        auto time_t = std::chrono::system_clock::to_time_t(timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-        j["timestamp"] = ss.str();
+        j["timestamp"] = utils::TimeUtils::formatIsoDateTime(timestamp);
 
         return j.dump();
     }
@@ -40,10 +45,7 @@ namespace tarius::models
         msg.content = j["content"];
 
         // Parse timestamp
-        std::tm tm = {};
-        std::stringstream ss(j["timestamp"].get<std::string>());
-        ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-        msg.timestamp = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        utils::TimeUtils::parseIsoDateTime(j["timestamp"].get<std::string>(), msg.timestamp);
 
         return msg;
     }
@@ -55,10 +57,7 @@ namespace tarius::models
         j["id"] = id;
 
         // Convert start time to ISO string
-        time_t startTimeT = std::chrono::system_clock::to_time_t(startTime);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&startTimeT), "%Y-%m-%dT%H:%M:%S");
-        j["startTime"] = ss.str();
+        j["startTime"] = utils::TimeUtils::formatIsoDateTime(startTime);
 
         // Serialize messages
         json messagesJson = json::array();
@@ -78,10 +77,7 @@ namespace tarius::models
         conv.id = j["id"];
 
         // Parse start time
-        std::tm tm = {};
-        std::stringstream ss(j["startTime"].get<std::string>());
-        ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-        conv.startTime = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        utils::TimeUtils::parseIsoDateTime(j["startTime"].get<std::string>(), conv.startTime);
 
         // Parse messages
         for (const auto &msgJson : j["messages"])
@@ -91,10 +87,7 @@ namespace tarius::models
             msg.content = msgJson["content"];
 
             // Parse timestamp
-            std::tm msgTm = {};
-            std::stringstream msgSs(msgJson["timestamp"].get<std::string>());
-            msgSs >> std::get_time(&msgTm, "%Y-%m-%dT%H:%M:%S");
-            msg.timestamp = std::chrono::system_clock::from_time_t(std::mktime(&msgTm));
+            utils::TimeUtils::parseIsoDateTime(msgJson["timestamp"].get<std::string>(), msg.timestamp);
 
             conv.messages.push_back(msg);
         }
@@ -110,10 +103,10 @@ namespace tarius::models
         j["content"] = content;
 
         // Convert timestamp to ISO string
-        auto time_t = std::chrono::system_clock::to_time_t(timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-        j["timestamp"] = ss.str();
+        j["timestamp"] = utils::TimeUtils::formatIsoDateTime(timestamp);
+
+        j["chunkSummaries"] = chunkSummaries;
+        j["messageCount"] = messageCount;
 
         return j.dump(4); // Pretty print with 4 spaces
     }
@@ -126,20 +119,84 @@ namespace tarius::models
         summary.content = j["content"];
 
         // Parse timestamp
-        std::tm tm = {};
-        std::stringstream ss(j["timestamp"].get<std::string>());
-        ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
-        summary.timestamp = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+        utils::TimeUtils::parseIsoDateTime(j["timestamp"].get<std::string>(), summary.timestamp);
+
+        // Summaries written before incremental summarization have no chunks
+        summary.chunkSummaries = j.value("chunkSummaries", std::vector<std::string>{});
+        summary.messageCount = j.value("messageCount", std::size_t{0});
 
         return summary;
     }
 
+    // Upper bound on how far back getRecentMessages can reach
+    constexpr std::size_t kRecentMessageCapacity = 64;
+
+    // Approximate memory held by parsed conversations and summaries
+    constexpr std::size_t kConversationCacheBytes = 8 * 1024 * 1024;
+    constexpr std::size_t kSummaryCacheBytes = 1024 * 1024;
+
+    namespace
+    {
+        std::size_t conversationBytes(const Conversation &conversation)
+        {
+            std::size_t bytes = sizeof(Conversation) + conversation.id.capacity() +
+                                conversation.messages.capacity() * sizeof(Message);
+            for (const auto &message : conversation.messages)
+            {
+                bytes += message.speaker.capacity() + message.content.capacity();
+            }
+            return bytes;
+        }
+
+        std::size_t summaryBytes(const Summary &summary)
+        {
+            std::size_t bytes = sizeof(Summary) + summary.conversationId.capacity() + summary.content.capacity() +
+                                summary.chunkSummaries.capacity() * sizeof(std::string);
+            for (const auto &chunk : summary.chunkSummaries)
+            {
+                bytes += chunk.capacity();
+            }
+            return bytes;
+        }
+    } // namespace
+
     // MemoryManager implementation
-    MemoryManager::MemoryManager()
+    MemoryManager::MemoryManager(const utils::Config &config, const std::string &dataDirectory,
+                                 std::shared_ptr<SummarizationWorker> summarizationWorker)
+        : m_dataDirectory(dataDirectory),
+          m_recentMessages(std::make_unique<RecentMessageBuffer>(kRecentMessageCapacity)),
+          m_recentBackfilled(false),
+          m_summarizationWorker(std::move(summarizationWorker)),
+          m_summarizationClient(0),
+          m_conversationCache(kConversationCacheBytes, conversationBytes),
+          m_summaryCache(kSummaryCacheBytes, [](const CachedSummary &cached)
+                         { return summaryBytes(cached.summary); })
     {
         // Create necessary directories if they don't exist
-        fs::create_directories("data/conversations");
-        fs::create_directories("data/summaries");
+        fs::create_directories(m_dataDirectory + "/summaries");
+
+        ConversationStore::Options storeOptions;
+        storeOptions.compactAfterDays = config.getInt("memory.compact_after_days", storeOptions.compactAfterDays);
+        storeOptions.rawRetentionDays = config.getInt("memory.raw_retention_days", storeOptions.rawRetentionDays);
+        storeOptions.compressColdSegments = config.getBool("memory.compress_cold_segments", storeOptions.compressColdSegments);
+        m_store = std::make_unique<ConversationStore>(m_dataDirectory + "/conversations", storeOptions);
+        m_store->compact([this](const std::string &id)
+                         { return fs::exists(getSummaryPath(id)); });
+
+        m_searchIndex = std::make_unique<SearchIndex>(m_dataDirectory + "/index");
+        if (m_searchIndex->documentCount() == 0)
+        {
+            rebuildSearchIndex();
+        }
+
+        m_semanticMemory = std::make_unique<SemanticMemory>(m_dataDirectory + "/semantic");
+
+        m_rollup = std::make_unique<SummaryRollup>(m_dataDirectory + "/summaries/rollups", [this](const std::string &id, Summary &summary)
+                                                   { return loadSummary(id, summary); });
+        if (m_rollup->empty())
+        {
+            rebuildRollup();
+        }
 
         // Start a new conversation
         startNewConversation();
@@ -147,6 +204,12 @@ namespace tarius::models
 
     MemoryManager::~MemoryManager()
     {
+        // Stop background work before the indexes it writes to go away
+        if (m_summarizationClient)
+        {
+            m_summarizationWorker->detach(m_summarizationClient);
+        }
+
         // Save current conversation before shutting down
         saveCurrentConversation();
     }
@@ -159,6 +222,18 @@ namespace tarius::models
         msg.timestamp = std::chrono::system_clock::now();
 
         m_currentConversation.messages.push_back(msg);
+        m_recentMessages->push(msg);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int messageIndex = static_cast<int>(m_currentConversation.messages.size()) - 1;
+            m_searchIndex->addDocument(m_currentConversation.id, messageIndex, content);
+
+            if (m_embedder)
+            {
+                m_semanticMemory->add({m_currentConversation.id, messageIndex, content}, embed(content));
+            }
+        }
 
         // Auto-save after each message
         saveCurrentConversation();
@@ -176,8 +251,13 @@ namespace tarius::models
 
     void MemoryManager::startNewConversation()
     {
-        // Save the current conversation if it exists
+        // Save the current conversation if it exists, and hand it to the
+        // background summarizer now that it is finished
         saveCurrentConversation();
+        if (m_summarizationClient && !m_currentConversation.messages.empty())
+        {
+            m_summarizationWorker->enqueue(m_summarizationClient, m_currentConversation.id);
+        }
 
         // Create a new conversation
         m_currentConversation.id = generateConversationId();
@@ -189,84 +269,250 @@ namespace tarius::models
 
     std::vector<Message> MemoryManager::getRecentMessages(int count)
     {
-        std::vector<Message> recentMessages;
+        if (count <= 0)
+        {
+            return {};
+        }
 
-        // First, get messages from current conversation
-        auto currentMessages = m_currentConversation.messages;
+        // Reach into previous conversations the first time more context is
+        // needed than this session has produced
+        if (!m_recentBackfilled && m_recentMessages->size() < static_cast<std::size_t>(count))
+        {
+            backfillRecentMessages();
+        }
 
-        // If we need more messages than what's in the current conversation,
-        // we could load previous conversations here
+        return m_recentMessages->last(static_cast<std::size_t>(count));
+    }
 
-        // Return the most recent 'count' messages
-        int startIdx = std::max(0, static_cast<int>(currentMessages.size()) - count);
-        for (int i = startIdx; i < currentMessages.size(); i++)
+    void MemoryManager::backfillRecentMessages()
+    {
+        m_recentBackfilled = true;
+
+        // Conversation ids are timestamp based, so the store lists them in
+        // chronological order
+        std::vector<std::string> ids;
+        for (const auto &entry : m_store->list())
         {
-            recentMessages.push_back(currentMessages[i]);
+            if (entry.id != m_currentConversation.id)
+            {
+                ids.push_back(entry.id);
+            }
+        }
+        // Walk backwards until the free capacity is covered
+        std::size_t needed = m_recentMessages->capacity() - m_recentMessages->size();
+        std::vector<Message> older;
+        for (auto it = ids.rbegin(); it != ids.rend() && older.size() < needed; ++it)
+        {
+            Conversation conv;
+            if (!loadConversation(*it, conv))
+            {
+                continue;
+            }
+
+            // Prepend this (earlier) conversation in front of what was collected
+            std::size_t take = std::min(needed - older.size(), conv.messages.size());
+            older.insert(older.begin(), conv.messages.end() - take, conv.messages.end());
         }
 
-        return recentMessages;
+        m_recentMessages->prependOlder(older);
+        LOG_INFO("Backfilled {} recent messages from previous conversations", older.size());
     }
 
     std::vector<Conversation> MemoryManager::getConversations(const std::string &dateFrom, const std::string &dateTo)
     {
         std::vector<Conversation> conversations;
 
-        // Parse date strings to time_points
-        std::tm fromTm = {}, toTm = {};
-        std::stringstream fromSs(dateFrom), toSs(dateTo);
-        fromSs >> std::get_time(&fromTm, "%Y-%m-%d");
-        toSs >> std::get_time(&toTm, "%Y-%m-%d");
+        // Only the segments covering the range are read
+        for (const auto &entry : m_store->list(dateFrom, dateTo))
+        {
+            Conversation conv;
+            if (loadConversation(entry.id, conv))
+            {
+                conversations.push_back(std::move(conv));
+            }
+        }
 
-        auto fromTime = std::chrono::system_clock::from_time_t(std::mktime(&fromTm));
-        auto toTime = std::chrono::system_clock::from_time_t(std::mktime(&toTm));
+        return conversations;
+    }
 
-        // Iterate through conversation files
-        for (const auto &entry : fs::directory_iterator("data/conversations"))
+    std::vector<SearchResult> MemoryManager::search(const std::string &query, int k)
+    {
+        std::vector<SearchResult> results;
+        if (k <= 0)
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".json")
+            return results;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Hits from the same conversation share one load
+        std::unordered_map<std::string, Conversation> loaded;
+        for (const auto &hit : m_searchIndex->search(query, static_cast<std::size_t>(k)))
+        {
+            const Conversation *conv = nullptr;
+            if (hit.conversationId == m_currentConversation.id)
             {
-                Conversation conv;
-                if (loadConversation(entry.path().stem().string(), conv))
+                conv = &m_currentConversation;
+            }
+            else
+            {
+                auto it = loaded.find(hit.conversationId);
+                if (it == loaded.end())
                 {
-                    // Check if conversation is within date range
-                    if (conv.startTime >= fromTime && conv.startTime <= toTime)
+                    Conversation loadedConv;
+                    if (!loadConversation(hit.conversationId, loadedConv))
                     {
-                        conversations.push_back(conv);
+                        continue;
                     }
+                    it = loaded.emplace(hit.conversationId, std::move(loadedConv)).first;
                 }
+                conv = &it->second;
+            }
+
+            if (hit.messageIndex < 0 || hit.messageIndex >= static_cast<int>(conv->messages.size()))
+            {
+                continue; // Index is ahead of a conversation file that was never saved
             }
+
+            results.push_back({hit.conversationId, hit.messageIndex, conv->messages[hit.messageIndex], hit.score});
         }
 
-        return conversations;
+        return results;
+    }
+
+    void MemoryManager::setEmbedder(Embedder embedder)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_embedder = std::move(embedder);
+        m_lastEmbeddedText.clear();
+        m_lastEmbedding.clear();
+    }
+
+    const std::vector<float> &MemoryManager::embed(const std::string &text)
+    {
+        // The user's message is embedded when stored and again as the recall
+        // query for the same turn, so remember the last result
+        if (text != m_lastEmbeddedText || m_lastEmbedding.empty())
+        {
+            m_lastEmbedding = m_embedder(text);
+            m_lastEmbeddedText = text;
+        }
+        return m_lastEmbedding;
+    }
+
+    std::vector<MemoryRecall> MemoryManager::recall(const std::string &query, int k)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<MemoryRecall> results;
+        if (!m_embedder || k <= 0 || m_semanticMemory->size() == 0)
+        {
+            return results;
+        }
+
+        for (auto &match : m_semanticMemory->search(embed(query), static_cast<std::size_t>(k)))
+        {
+            results.push_back({match.entry.conversationId, std::move(match.entry.text),
+                               match.entry.messageIndex < 0, match.similarity});
+        }
+        return results;
+    }
+
+    void MemoryManager::rebuildSearchIndex()
+    {
+        std::vector<ConversationStore::Entry> entries = m_store->list();
+        if (entries.empty())
+        {
+            return;
+        }
+
+        // The store lists in chronological order, so doc ids follow time
+        for (const auto &entry : entries)
+        {
+            Conversation conv;
+            if (!loadConversation(entry.id, conv))
+            {
+                continue;
+            }
+            for (std::size_t i = 0; i < conv.messages.size(); i++)
+            {
+                m_searchIndex->addDocument(conv.id, static_cast<int>(i), conv.messages[i].content);
+            }
+        }
+
+        m_searchIndex->saveSnapshot();
+        LOG_INFO("Rebuilt search index from {} conversations", entries.size());
+    }
+
+    void MemoryManager::setSummarizer(Summarizer summarizer)
+    {
+        // Leave the worker first; it may be mid-call into the old model
+        if (m_summarizationClient)
+        {
+            m_summarizationWorker->detach(m_summarizationClient);
+            m_summarizationClient = 0;
+        }
+        m_summarizer = std::move(summarizer);
+
+        if (!m_summarizer)
+        {
+            return;
+        }
+        if (!m_summarizationWorker)
+        {
+            m_summarizationWorker = std::make_shared<SummarizationWorker>();
+        }
+
+        SummarizationWorker::Callbacks callbacks;
+        callbacks.summarize = m_summarizer;
+        callbacks.loadConversation = [this](const std::string &id, Conversation &conversation)
+        { return loadConversation(id, conversation); };
+        callbacks.loadSummary = [this](const std::string &id, Summary &summary)
+        { return loadSummary(id, summary); };
+        callbacks.saveSummary = [this](const Summary &summary)
+        { saveSummary(summary); };
+        m_summarizationClient = m_summarizationWorker->attach(std::move(callbacks));
+
+        // Catch up on anything finished while no model was loaded
+        summarizeOldConversations();
+    }
+
+    void MemoryManager::setInteractive(bool active)
+    {
+        if (m_summarizationWorker)
+        {
+            m_summarizationWorker->setInteractive(active);
+        }
     }
 
     void MemoryManager::summarizeConversation(const std::string &conversationId)
     {
-        Conversation conv;
-        if (!loadConversation(conversationId, conv))
+        if (!m_summarizer)
         {
-            LOG_ERROR("Failed to load conversation for summarization: {}", conversationId);
+            LOG_WARN("No summarizer available, cannot summarize conversation: {}", conversationId);
             return;
         }
 
-        // Prepare conversation content for LLaMA
-        std::stringstream conversationText;
-        for (const auto &msg : conv.messages)
+        Conversation conv;
+        if (!loadConversation(conversationId, conv))
         {
-            conversationText << msg.speaker << ": " << msg.content << "\n";
+            LOG_ERROR("Failed to load conversation for summarization: {}", conversationId);
+            return;
         }
 
-        // Create prompt for LLaMA
-        std::string prompt = "Please provide a concise summary of the following conversation, "
-                             "including main topics discussed and key points:\n\n" +
-                             conversationText.str();
+        Summary previous;
+        bool hasPrevious = loadSummary(conversationId, previous);
 
-        // Get summary from LLaMA
-        std::string aiSummary;
+        Summary summary;
         try
         {
-            // TODO: Replace with actual LLaMA API call
-            aiSummary = m_llamaModel.summariseConversation(prompt);
+            if (!SummarizationWorker::buildSummary(conv, hasPrevious ? &previous : nullptr, m_summarizer,
+                                                   []
+                                                   { return true; },
+                                                   summary))
+            {
+                return; // Already up to date
+            }
         }
         catch (const std::exception &e)
         {
@@ -274,39 +520,33 @@ namespace tarius::models
             return;
         }
 
-        // Create and save the summary
-        Summary summary;
-        summary.conversationId = conversationId;
-        summary.content = aiSummary;
-        summary.timestamp = std::chrono::system_clock::now();
-
         saveSummary(summary);
         LOG_INFO("Created AI-generated summary for conversation: {}", conversationId);
     }
 
     void MemoryManager::summarizeOldConversations(int minutesOld)
     {
-        auto now = std::chrono::system_clock::now();
-        auto cutoffTime = now - std::chrono::minutes(minutesOld);
+        if (!m_summarizationClient)
+        {
+            return;
+        }
 
-        for (const auto &entry : fs::directory_iterator("data/conversations"))
+        auto cutoffTime = std::chrono::system_clock::now() - std::chrono::minutes(minutesOld);
+
+        // Only store metadata and summaries are read here; the worker loads
+        // and summarizes the conversations on its own thread
+        for (const auto &entry : m_store->list())
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".json")
+            if (entry.id == m_currentConversation.id || entry.lastMessage >= cutoffTime)
             {
-                Conversation conv;
-                if (loadConversation(entry.path().stem().string(), conv))
-                {
-                    // Check if conversation is older than cutoff
-                    if (conv.startTime < cutoffTime)
-                    {
-                        // Check if summary already exists
-                        std::string summaryPath = getSummaryPath(conv.id);
-                        if (!fs::exists(summaryPath))
-                        {
-                            summarizeConversation(conv.id);
-                        }
-                    }
-                }
+                continue;
+            }
+
+            // Queue conversations with no summary, or one that misses later messages
+            Summary summary;
+            if (!loadSummary(entry.id, summary) || summary.messageCount < entry.messageCount)
+            {
+                m_summarizationWorker->enqueue(m_summarizationClient, entry.id);
             }
         }
     }
@@ -316,16 +556,18 @@ namespace tarius::models
         std::vector<Summary> summaries;
 
         // Parse date strings to time_points
-        std::tm fromTm = {}, toTm = {};
-        std::stringstream fromSs(dateFrom), toSs(dateTo);
-        fromSs >> std::get_time(&fromTm, "%Y-%m-%d");
-        toSs >> std::get_time(&toTm, "%Y-%m-%d");
+        int fromDay = 0, toDay = 0;
+        if (!utils::TimeUtils::parseIsoDate(dateFrom, fromDay) || !utils::TimeUtils::parseIsoDate(dateTo, toDay))
+        {
+            LOG_WARN("Invalid summary date range {} to {}", dateFrom, dateTo);
+            return summaries;
+        }
 
-        auto fromTime = std::chrono::system_clock::from_time_t(std::mktime(&fromTm));
-        auto toTime = std::chrono::system_clock::from_time_t(std::mktime(&toTm));
+        auto fromTime = utils::TimeUtils::startOfDay(fromDay);
+        auto toTime = utils::TimeUtils::startOfDay(toDay);
 
         // Iterate through summary files
-        for (const auto &entry : fs::directory_iterator("data/summaries"))
+        for (const auto &entry : fs::directory_iterator(m_dataDirectory + "/summaries"))
         {
             if (entry.is_regular_file() && entry.path().extension() == ".json")
             {
@@ -349,80 +591,238 @@ namespace tarius::models
         return summaries;
     }
 
-    std::string MemoryManager::generateConversationId()
+    MemoryStats MemoryManager::getStats() const
+    {
+        return {m_conversationCache.stats(), m_summaryCache.stats()};
+    }
+
+    std::string MemoryManager::summarizeRange(const std::string &dateFrom, const std::string &dateTo)
+    {
+        // The model calls run without the lock; only reading the rollup and
+        // storing what was rebuilt hold it
+        Summarizer summarizer;
+        std::vector<SummaryRollup::Period> periods;
+        try
+        {
+            SummaryRollup::Plan plan;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                summarizer = m_summarizer;
+                plan = m_rollup->plan(dateFrom, dateTo, static_cast<bool>(summarizer));
+            }
+            SummaryRollup::build(plan, summarizer);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                periods = m_rollup->finish(plan);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Failed to build rollup summaries: {}", e.what());
+            return "";
+        }
+
+        if (periods.empty())
+        {
+            return "";
+        }
+        if (periods.size() == 1)
+        {
+            return periods.front().content;
+        }
+
+        std::string combined;
+        for (const auto &period : periods)
+        {
+            std::string label = period.from == period.to ? period.from : period.from + " to " + period.to;
+            combined += label + ": " + period.content + "\n";
+        }
+
+        if (!summarizer)
+        {
+            return combined;
+        }
+
+        // At most a few dozen periods, so one call covers them
+        try
+        {
+            return summarizer("Combine these summaries of consecutive periods into one concise summary. "
+                              "Keep names, decisions, dates and open questions:\n\n" +
+                              combined);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Failed to merge rollup summaries: {}", e.what());
+            return combined;
+        }
+    }
+
+    void MemoryManager::rebuildRollup()
     {
-        // Generate a timestamp-based ID
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << "conv_" << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S");
-        return ss.str();
+        // Only file names are read; node contents are built on first query
+        const std::string suffix = "_summary";
+        std::size_t count = 0;
+        for (const auto &entry : fs::directory_iterator(m_dataDirectory + "/summaries"))
+        {
+            std::string stem = entry.path().stem().string();
+            if (!entry.is_regular_file() || entry.path().extension() != ".json" || stem.size() <= suffix.size() ||
+                stem.compare(stem.size() - suffix.size(), suffix.size(), suffix) != 0)
+            {
+                continue;
+            }
+
+            std::string id = stem.substr(0, stem.size() - suffix.size());
+            // Ids that do not carry their date need the summary's timestamp
+            Summary summary;
+            summary.timestamp = std::chrono::system_clock::now();
+            if (id.compare(0, 5, "conv_") != 0)
+            {
+                loadSummary(id, summary);
+            }
+            m_rollup->addConversation(id, ConversationStore::dayOf(id, summary.timestamp));
+            count++;
+        }
+
+        if (count > 0)
+        {
+            LOG_INFO("Registered {} conversation summaries in the rollup", count);
+        }
     }
 
-    std::string MemoryManager::getConversationPath(const std::string &id)
+    std::string MemoryManager::generateConversationId()
     {
-        return "data/conversations/" + id + ".json";
+        // Unique across processes sharing the data directory, and still
+        // starting with the local date the store partitions by
+        return utils::IdGenerator::next("conv");
     }
 
     std::string MemoryManager::getSummaryPath(const std::string &id)
     {
-        return "data/summaries/" + id + "_summary.json";
+        return m_dataDirectory + "/summaries/" + id + "_summary.json";
     }
 
     bool MemoryManager::loadConversation(const std::string &id, Conversation &conversation)
     {
-        std::string path = getConversationPath(id);
-        std::ifstream file(path);
-        if (!file.is_open())
+        if (auto cached = m_conversationCache.get(id))
         {
-            LOG_ERROR("Failed to open conversation file: {}", path);
-            return false;
+            conversation = *cached;
+            return true;
         }
 
-        std::string jsonStr((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        file.close();
-
         try
         {
-            conversation = Conversation::fromJson(jsonStr);
-            return true;
+            if (m_store->load(id, conversation))
+            {
+                m_conversationCache.put(id, conversation);
+                return true;
+            }
+            LOG_ERROR("Conversation not found: {}", id);
         }
         catch (const std::exception &e)
         {
             LOG_ERROR("Failed to parse conversation JSON: {}", e.what());
-            return false;
         }
+        return false;
     }
 
     bool MemoryManager::saveConversation(const Conversation &conversation)
     {
-        std::string path = getConversationPath(conversation.id);
-        std::ofstream file(path);
+        TRACE_SCOPE("memory.save");
+        m_conversationCache.erase(conversation.id);
+        if (!m_store->save(conversation))
+        {
+            LOG_ERROR("Failed to save conversation: {}", conversation.id);
+            return false;
+        }
+
+        LOG_DEBUG("Saved conversation: {}", conversation.id);
+        return true;
+    }
+
+    bool MemoryManager::loadSummary(const std::string &id, Summary &summary)
+    {
+        std::string path = getSummaryPath(id);
+        std::error_code ec;
+        auto fileTime = fs::last_write_time(path, ec);
+        if (ec)
+        {
+            m_summaryCache.erase(id);
+            return false;
+        }
+
+        // Another process may have rewritten the summary since it was cached
+        auto cached = m_summaryCache.get(id);
+        if (cached && cached->fileTime == fileTime)
+        {
+            summary = cached->summary;
+            return true;
+        }
+
+        std::ifstream file(path);
         if (!file.is_open())
         {
-            LOG_ERROR("Failed to open conversation file for writing: {}", path);
             return false;
         }
 
-        file << conversation.toJson();
+        std::string jsonStr((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
         file.close();
 
-        LOG_INFO("Saved conversation: {}", conversation.id);
-        return true;
+        try
+        {
+            summary = Summary::fromJson(jsonStr);
+            m_summaryCache.put(id, {summary, fileTime});
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Failed to parse summary JSON: {}", e.what());
+            return false;
+        }
     }
 
     bool MemoryManager::saveSummary(const Summary &summary)
     {
         std::string path = getSummaryPath(summary.conversationId);
-        std::ofstream file(path);
-        if (!file.is_open())
         {
-            LOG_ERROR("Failed to open summary file for writing: {}", path);
-            return false;
+            // Written aside and renamed into place, so readers never see a
+            // partial summary even while another process is writing
+            utils::FileLock fileLock(utils::FileLock::forDirectory(m_dataDirectory + "/summaries"), utils::FileLock::Mode::Exclusive);
+            std::string tmpPath = path + ".tmp";
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file.is_open())
+            {
+                LOG_ERROR("Failed to open summary file for writing: {}", tmpPath);
+                return false;
+            }
+            file << summary.toJson();
+            file.close();
+
+            std::error_code ec;
+            fs::rename(tmpPath, path, ec);
+            if (ec)
+            {
+                LOG_ERROR("Failed to replace summary file {}: {}", path, ec.message());
+                m_summaryCache.erase(summary.conversationId);
+                return false;
+            }
+
+            auto fileTime = fs::last_write_time(path, ec);
+            if (ec)
+            {
+                m_summaryCache.erase(summary.conversationId);
+            }
+            else
+            {
+                m_summaryCache.put(summary.conversationId, {summary, fileTime});
+            }
         }
 
-        file << summary.toJson();
-        file.close();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_embedder)
+        {
+            m_semanticMemory->add({summary.conversationId, -1, summary.content}, embed(summary.content));
+        }
+        m_rollup->addConversation(summary.conversationId, ConversationStore::dayOf(summary.conversationId, summary.timestamp));
 
         LOG_INFO("Saved summary for conversation: {}", summary.conversationId);
         return true;
@@ -1,11 +1,28 @@
 #pragma once
 
+#include "lru_cache.h"
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <functional>
+#include <mutex>
+
+namespace tarius::utils
+{
+    class Config;
+}
 
 namespace tarius::models
 {
+    class ConversationStore;
+    class RecentMessageBuffer;
+    class SearchIndex;
+    class SemanticMemory;
+    class SummarizationWorker;
+    class SummaryRollup;
 
     struct Message
     {
@@ -35,15 +52,47 @@ namespace tarius::models
         std::string content;
         std::chrono::system_clock::time_point timestamp;
 
+        // Partial summaries the content was merged from, and how many messages
+        // they cover, so a grown conversation only needs its tail summarized
+        std::vector<std::string> chunkSummaries;
+        std::size_t messageCount = 0;
+
         // For serialization
         std::string toJson() const;
         static Summary fromJson(const std::string &json);
     };
 
+    struct SearchResult
+    {
+        std::string conversationId;
+        int messageIndex;
+        Message message;
+        double score;
+    };
+
+    struct MemoryRecall
+    {
+        std::string conversationId;
+        std::string text;
+        bool isSummary;
+        float similarity;
+    };
+
+    struct MemoryStats
+    {
+        CacheStats conversations;
+        CacheStats summaries;
+    };
+
     class MemoryManager
     {
     public:
-        MemoryManager();
+        // Storage settings are read once, from the memory.* keys. Everything
+        // is kept under dataDirectory.
+        // Background summaries run on summarizationWorker, which may be
+        // shared with other memory managers; one is made when none is given
+        explicit MemoryManager(const utils::Config &config, const std::string &dataDirectory = "data",
+                               std::shared_ptr<SummarizationWorker> summarizationWorker = nullptr);
         ~MemoryManager();
 
         // Conversation management
@@ -55,20 +104,85 @@ namespace tarius::models
         std::vector<Message> getRecentMessages(int count = 10);
         std::vector<Conversation> getConversations(const std::string &dateFrom, const std::string &dateTo);
 
-        // Summarization
+        // Full-text search over all past messages, best match first
+        std::vector<SearchResult> search(const std::string &query, int k = 5);
+
+        // Semantic recall of messages and summaries similar to the query.
+        // Empty until an embedder has been set.
+        using Embedder = std::function<std::vector<float>(const std::string &)>;
+        void setEmbedder(Embedder embedder);
+        std::vector<MemoryRecall> recall(const std::string &query, int k = 5);
+
+        // Summarization. Finished conversations are summarized in the
+        // background once a summarizer has been set.
+        using Summarizer = std::function<std::string(const std::string &prompt)>;
+        void setSummarizer(Summarizer summarizer);
+        void setInteractive(bool active); // Pauses background summarization
         void summarizeConversation(const std::string &conversationId);
         void summarizeOldConversations(int minutesOld = 1);
         std::vector<Summary> getSummaries(const std::string &dateFrom, const std::string &dateTo);
 
+        // One summary of everything discussed between two dates (YYYY-MM-DD,
+        // inclusive), assembled from precomputed day/week/month rollups.
+        // Empty if nothing was summarized in the range.
+        std::string summarizeRange(const std::string &dateFrom, const std::string &dateTo);
+
+        MemoryStats getStats() const;
+
     private:
+        std::string m_dataDirectory;
         Conversation m_currentConversation;
+
+        // Date-partitioned conversation segments
+        std::unique_ptr<ConversationStore> m_store;
+
+        // Recent messages across conversation boundaries, backfilled from
+        // previous conversations on first use
+        std::unique_ptr<RecentMessageBuffer> m_recentMessages;
+        bool m_recentBackfilled;
+        void backfillRecentMessages();
+
+        // Full-text index over every stored message
+        std::unique_ptr<SearchIndex> m_searchIndex;
+        void rebuildSearchIndex();
+
+        // Embedding store for semantic recall
+        std::unique_ptr<SemanticMemory> m_semanticMemory;
+        Embedder m_embedder;
+        std::string m_lastEmbeddedText;
+        std::vector<float> m_lastEmbedding;
+        const std::vector<float> &embed(const std::string &text);
+
+        // Background summarization
+        Summarizer m_summarizer;
+        std::shared_ptr<SummarizationWorker> m_summarizationWorker;
+        uint64_t m_summarizationClient; // 0 while no summarizer is set
+
+        // Day/week/month summaries over the conversation summaries
+        std::unique_ptr<SummaryRollup> m_rollup;
+        void rebuildRollup();
+
+        // Parsed conversations and summaries, so repeated loads skip the disk.
+        // Summaries remember their file time, since another process may
+        // rewrite them.
+        struct CachedSummary
+        {
+            Summary summary;
+            std::filesystem::file_time_type fileTime;
+        };
+        LruCache<std::string, Conversation> m_conversationCache;
+        LruCache<std::string, CachedSummary> m_summaryCache;
+
+        // Guards the indexes and embedding state shared with the summarization worker
+        std::mutex m_mutex;
+
         std::string generateConversationId();
-        std::string getConversationPath(const std::string &id);
         std::string getSummaryPath(const std::string &id);
 
         // Helper methods
         bool loadConversation(const std::string &id, Conversation &conversation);
         bool saveConversation(const Conversation &conversation);
+        bool loadSummary(const std::string &id, Summary &summary);
         bool saveSummary(const Summary &summary);
     };
 
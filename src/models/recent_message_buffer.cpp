@@ -0,0 +1,65 @@
+#include "recent_message_buffer.h"
+#include <algorithm>
+
+namespace tarius::models
+{
+
+    RecentMessageBuffer::RecentMessageBuffer(std::size_t capacity)
+        : m_slots(std::max<std::size_t>(capacity, 1)), m_head(0), m_size(0)
+    {
+    }
+
+    void RecentMessageBuffer::push(const Message &message)
+    {
+        std::size_t tail = (m_head + m_size) % m_slots.size();
+        m_slots[tail] = message;
+
+        if (m_size < m_slots.size())
+        {
+            m_size++;
+        }
+        else
+        {
+            // Buffer was full, the oldest slot was just overwritten
+            m_head = (m_head + 1) % m_slots.size();
+        }
+    }
+
+    void RecentMessageBuffer::prependOlder(const std::vector<Message> &older)
+    {
+        std::size_t room = m_slots.size() - m_size;
+        std::size_t take = std::min(room, older.size());
+
+        // Walk backwards from the newest of the older messages so that the
+        // ones closest to the current contents are the ones that survive
+        for (std::size_t i = 0; i < take; i++)
+        {
+            m_head = (m_head + m_slots.size() - 1) % m_slots.size();
+            m_slots[m_head] = older[older.size() - 1 - i];
+            m_size++;
+        }
+    }
+
+    std::vector<Message> RecentMessageBuffer::last(std::size_t count) const
+    {
+        std::size_t n = std::min(count, m_size);
+        std::vector<Message> result;
+        result.reserve(n);
+
+        std::size_t start = m_head + (m_size - n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            result.push_back(m_slots[(start + i) % m_slots.size()]);
+        }
+
+        return result;
+    }
+
+    void RecentMessageBuffer::clear()
+    {
+        std::fill(m_slots.begin(), m_slots.end(), Message{});
+        m_head = 0;
+        m_size = 0;
+    }
+
+} // namespace tarius::models
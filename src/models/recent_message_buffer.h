@@ -0,0 +1,42 @@
+#pragma once
+
+#include "memory_manager.h"
+#include <cstddef>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Fixed-capacity ring buffer of the most recent messages.
+     *
+     * Spans conversation boundaries so that prompt context survives a
+     * startNewConversation() or a restart. Retrieval copies exactly the
+     * requested number of messages, never the whole history.
+     */
+    class RecentMessageBuffer
+    {
+    public:
+        explicit RecentMessageBuffer(std::size_t capacity);
+
+        // Append a message, overwriting the oldest one when full
+        void push(const Message &message);
+
+        // Insert older messages behind the current contents (oldest first).
+        // Only as many as fit in the free capacity are kept, newest preferred.
+        void prependOlder(const std::vector<Message> &older);
+
+        // The last min(count, size()) messages in chronological order
+        std::vector<Message> last(std::size_t count) const;
+
+        std::size_t size() const { return m_size; }
+        std::size_t capacity() const { return m_slots.size(); }
+        bool full() const { return m_size == m_slots.size(); }
+        void clear();
+
+    private:
+        std::vector<Message> m_slots;
+        std::size_t m_head; // Index of the oldest message
+        std::size_t m_size;
+    };
+
+} // namespace tarius::models
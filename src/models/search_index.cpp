@@ -0,0 +1,500 @@
+#include "search_index.h"
+#include "../utils/file_lock.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace tarius::models
+{
+    namespace
+    {
+        // BM25 parameters
+        constexpr double kK1 = 1.2;
+        constexpr double kB = 0.75;
+
+        // Fold the journal into a snapshot after this many documents
+        constexpr std::size_t kJournalCompactThreshold = 1024;
+
+        constexpr char kSnapshotMagic[4] = {'T', 'I', 'D', 'X'};
+        constexpr uint32_t kSnapshotVersion = 1;
+
+        const std::unordered_set<std::string> &stopWords()
+        {
+            static const std::unordered_set<std::string> words = {
+                "a", "an", "and", "are", "as", "at", "be", "but", "by", "do", "for", "if", "in",
+                "is", "it", "me", "my", "of", "on", "or", "so", "that", "the", "this", "to", "was",
+                "we", "what", "with", "you", "your", "i"};
+            return words;
+        }
+
+        void putVarint(std::string &out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        // Returns false on truncated input
+        bool getVarint(const std::string &in, std::size_t &pos, uint64_t &value)
+        {
+            value = 0;
+            int shift = 0;
+            while (pos < in.size() && shift < 64)
+            {
+                uint8_t byte = static_cast<uint8_t>(in[pos++]);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    return true;
+                }
+                shift += 7;
+            }
+            return false;
+        }
+
+        void putString(std::string &out, const std::string &value)
+        {
+            putVarint(out, value.size());
+            out += value;
+        }
+
+        bool getString(const std::string &in, std::size_t &pos, std::string &value)
+        {
+            uint64_t length;
+            if (!getVarint(in, pos, length) || pos + length > in.size())
+            {
+                return false;
+            }
+            value.assign(in, pos, length);
+            pos += length;
+            return true;
+        }
+    } // namespace
+
+    SearchIndex::SearchIndex(const std::string &directory)
+        : m_snapshotPath(directory + "/index.bin"),
+          m_journalPath(directory + "/journal.log"),
+          m_lockPath(utils::FileLock::forDirectory(directory)),
+          m_journalEntries(0),
+          m_journalOffset(0),
+          m_totalLength(0)
+    {
+        fs::create_directories(directory);
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Shared);
+        std::error_code ec;
+        m_snapshotTime = fs::last_write_time(m_snapshotPath, ec);
+        loadSnapshot();
+        replayJournal();
+
+        LOG_INFO("Search index ready with {} documents and {} terms", m_docs.size(), m_postings.size());
+    }
+
+    SearchIndex::~SearchIndex()
+    {
+        if (m_journalEntries > 0)
+        {
+            saveSnapshot();
+        }
+    }
+
+    std::vector<std::string> SearchIndex::tokenize(const std::string &text)
+    {
+        std::vector<std::string> terms;
+        std::string current;
+
+        auto flush = [&]()
+        {
+            if (current.size() >= 2 && !stopWords().count(current))
+            {
+                terms.push_back(current);
+            }
+            current.clear();
+        };
+
+        for (unsigned char c : text)
+        {
+            // Bytes >= 0x80 are kept so UTF-8 words stay whole
+            if (std::isalnum(c) || c >= 0x80)
+            {
+                current.push_back(static_cast<char>(std::tolower(c)));
+            }
+            else
+            {
+                flush();
+            }
+        }
+        flush();
+
+        return terms;
+    }
+
+    void SearchIndex::addDocument(const std::string &conversationId, int messageIndex, const std::string &text)
+    {
+        std::vector<std::string> terms = tokenize(text);
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Exclusive);
+        catchUp();
+        indexTerms(conversationId, messageIndex, terms);
+        appendJournal(conversationId, messageIndex, terms);
+
+        if (m_journalEntries >= kJournalCompactThreshold)
+        {
+            writeSnapshot();
+        }
+    }
+
+    void SearchIndex::indexTerms(const std::string &conversationId, int messageIndex, const std::vector<std::string> &terms)
+    {
+        auto [convIt, inserted] = m_conversationLookup.emplace(conversationId, static_cast<uint32_t>(m_conversationIds.size()));
+        if (inserted)
+        {
+            m_conversationIds.push_back(conversationId);
+        }
+
+        uint32_t docId = static_cast<uint32_t>(m_docs.size());
+        m_docs.push_back({convIt->second, static_cast<uint32_t>(messageIndex), static_cast<uint32_t>(terms.size())});
+        m_totalLength += terms.size();
+
+        std::unordered_map<std::string, uint32_t> frequencies;
+        for (const auto &term : terms)
+        {
+            frequencies[term]++;
+        }
+
+        for (const auto &[term, tf] : frequencies)
+        {
+            PostingList &list = m_postings[term];
+
+            // Doc ids only grow, so the delta from the previous posting is
+            // always non-negative; the first posting stores docId + 1
+            uint32_t delta = list.docFreq == 0 ? docId + 1 : docId - list.lastDoc;
+            putVarint(list.bytes, delta);
+            putVarint(list.bytes, tf);
+            list.lastDoc = docId;
+            list.docFreq++;
+        }
+    }
+
+    std::vector<SearchIndex::Hit> SearchIndex::search(const std::string &query, std::size_t k) const
+    {
+        std::vector<Hit> hits;
+        if (m_docs.empty() || k == 0)
+        {
+            return hits;
+        }
+
+        std::vector<std::string> terms = tokenize(query);
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+        const double n = static_cast<double>(m_docs.size());
+        const double avgLength = std::max(1.0, static_cast<double>(m_totalLength) / n);
+
+        std::unordered_map<uint32_t, double> scores;
+        for (const auto &term : terms)
+        {
+            auto it = m_postings.find(term);
+            if (it == m_postings.end())
+            {
+                continue;
+            }
+
+            const PostingList &list = it->second;
+            double idf = std::log(1.0 + (n - list.docFreq + 0.5) / (list.docFreq + 0.5));
+
+            std::size_t pos = 0;
+            uint64_t docId = 0;
+            bool first = true;
+            while (pos < list.bytes.size())
+            {
+                uint64_t delta, tf;
+                if (!getVarint(list.bytes, pos, delta) || !getVarint(list.bytes, pos, tf))
+                {
+                    break;
+                }
+                docId = first ? delta - 1 : docId + delta;
+                first = false;
+
+                double length = m_docs[docId].length;
+                double denom = tf + kK1 * (1.0 - kB + kB * length / avgLength);
+                scores[static_cast<uint32_t>(docId)] += idf * (tf * (kK1 + 1.0)) / denom;
+            }
+        }
+
+        std::vector<std::pair<double, uint32_t>> ranked;
+        ranked.reserve(scores.size());
+        for (const auto &[docId, score] : scores)
+        {
+            ranked.emplace_back(score, docId);
+        }
+
+        // Ties go to the more recent message
+        auto better = [](const auto &a, const auto &b)
+        { return a.first != b.first ? a.first > b.first : a.second > b.second; };
+        std::size_t count = std::min(k, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), better);
+
+        hits.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const DocInfo &doc = m_docs[ranked[i].second];
+            hits.push_back({m_conversationIds[doc.conversation], static_cast<int>(doc.messageIndex), ranked[i].first});
+        }
+
+        return hits;
+    }
+
+    bool SearchIndex::saveSnapshot()
+    {
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Exclusive);
+        catchUp();
+        return writeSnapshot();
+    }
+
+    void SearchIndex::catchUp()
+    {
+        std::error_code ec;
+        auto snapshotTime = fs::last_write_time(m_snapshotPath, ec);
+        auto journalSize = fs::file_size(m_journalPath, ec);
+        if (ec)
+        {
+            journalSize = 0;
+        }
+
+        // Another process folded the journal into a new snapshot; it includes
+        // everything this process had journaled, so start over from it
+        if (snapshotTime != m_snapshotTime || journalSize < m_journalOffset)
+        {
+            clear();
+            m_snapshotTime = snapshotTime;
+            loadSnapshot();
+        }
+
+        replayJournal();
+    }
+
+    void SearchIndex::clear()
+    {
+        m_conversationIds.clear();
+        m_conversationLookup.clear();
+        m_docs.clear();
+        m_postings.clear();
+        m_totalLength = 0;
+        m_journalEntries = 0;
+        m_journalOffset = 0;
+    }
+
+    bool SearchIndex::writeSnapshot()
+    {
+        std::string out(kSnapshotMagic, sizeof(kSnapshotMagic));
+        putVarint(out, kSnapshotVersion);
+
+        putVarint(out, m_conversationIds.size());
+        for (const auto &id : m_conversationIds)
+        {
+            putString(out, id);
+        }
+
+        putVarint(out, m_docs.size());
+        for (const auto &doc : m_docs)
+        {
+            putVarint(out, doc.conversation);
+            putVarint(out, doc.messageIndex);
+            putVarint(out, doc.length);
+        }
+
+        putVarint(out, m_postings.size());
+        for (const auto &[term, list] : m_postings)
+        {
+            putString(out, term);
+            putVarint(out, list.docFreq);
+            putVarint(out, list.lastDoc);
+            putString(out, list.bytes);
+        }
+
+        // Write to a temporary file first so a crash never leaves a torn snapshot
+        std::string tmpPath = m_snapshotPath + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                LOG_ERROR("Failed to open search index snapshot for writing: {}", tmpPath);
+                return false;
+            }
+            file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        }
+
+        std::error_code ec;
+        fs::rename(tmpPath, m_snapshotPath, ec);
+        if (ec)
+        {
+            LOG_ERROR("Failed to replace search index snapshot: {}", ec.message());
+            return false;
+        }
+
+        m_snapshotTime = fs::last_write_time(m_snapshotPath, ec);
+        std::ofstream(m_journalPath, std::ios::trunc);
+        m_journalEntries = 0;
+        m_journalOffset = 0;
+
+        LOG_INFO("Saved search index snapshot with {} documents", m_docs.size());
+        return true;
+    }
+
+    bool SearchIndex::loadSnapshot()
+    {
+        std::ifstream file(m_snapshotPath, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        std::string in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+
+        if (in.size() < sizeof(kSnapshotMagic) || in.compare(0, sizeof(kSnapshotMagic), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0)
+        {
+            LOG_ERROR("Search index snapshot is corrupt, ignoring: {}", m_snapshotPath);
+            return false;
+        }
+
+        std::size_t pos = sizeof(kSnapshotMagic);
+        uint64_t version, count;
+        bool ok = getVarint(in, pos, version) && version == kSnapshotVersion;
+
+        ok = ok && getVarint(in, pos, count);
+        for (uint64_t i = 0; ok && i < count; i++)
+        {
+            std::string id;
+            ok = getString(in, pos, id);
+            m_conversationLookup.emplace(id, static_cast<uint32_t>(m_conversationIds.size()));
+            m_conversationIds.push_back(std::move(id));
+        }
+
+        ok = ok && getVarint(in, pos, count);
+        for (uint64_t i = 0; ok && i < count; i++)
+        {
+            uint64_t conversation, messageIndex, length;
+            ok = getVarint(in, pos, conversation) && getVarint(in, pos, messageIndex) && getVarint(in, pos, length) &&
+                 conversation < m_conversationIds.size();
+            m_docs.push_back({static_cast<uint32_t>(conversation), static_cast<uint32_t>(messageIndex), static_cast<uint32_t>(length)});
+            m_totalLength += length;
+        }
+
+        ok = ok && getVarint(in, pos, count);
+        for (uint64_t i = 0; ok && i < count; i++)
+        {
+            std::string term;
+            uint64_t docFreq, lastDoc;
+            PostingList list;
+            ok = getString(in, pos, term) && getVarint(in, pos, docFreq) && getVarint(in, pos, lastDoc) &&
+                 getString(in, pos, list.bytes);
+            list.docFreq = static_cast<uint32_t>(docFreq);
+            list.lastDoc = static_cast<uint32_t>(lastDoc);
+            m_postings.emplace(std::move(term), std::move(list));
+        }
+
+        if (!ok)
+        {
+            LOG_ERROR("Search index snapshot is corrupt, ignoring: {}", m_snapshotPath);
+            clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    void SearchIndex::replayJournal()
+    {
+        std::ifstream file(m_journalPath, std::ios::binary);
+        if (!file.is_open())
+        {
+            return;
+        }
+        file.seekg(static_cast<std::streamoff>(m_journalOffset));
+
+        // One document per line: conversationId \t messageIndex \t space-separated terms
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream ss(line);
+            std::string conversationId, indexField, termsField;
+            if (!std::getline(ss, conversationId, '\t') || !std::getline(ss, indexField, '\t'))
+            {
+                continue; // Torn last line from a crash
+            }
+            std::getline(ss, termsField);
+
+            std::vector<std::string> terms;
+            std::istringstream termStream(termsField);
+            std::string term;
+            while (termStream >> term)
+            {
+                terms.push_back(term);
+            }
+
+            try
+            {
+                indexTerms(conversationId, std::stoi(indexField), terms);
+                m_journalEntries++;
+            }
+            catch (const std::exception &)
+            {
+                continue;
+            }
+        }
+
+        std::error_code ec;
+        m_journalOffset = fs::file_size(m_journalPath, ec);
+    }
+
+    void SearchIndex::appendJournal(const std::string &conversationId, int messageIndex, const std::vector<std::string> &terms)
+    {
+        // A crash can leave a torn last line; start on a fresh one
+        bool needsNewline = false;
+        {
+            std::ifstream in(m_journalPath, std::ios::binary | std::ios::ate);
+            if (in.is_open() && in.tellg() > 0)
+            {
+                char last;
+                in.seekg(-1, std::ios::end);
+                needsNewline = in.get(last) && last != '\n';
+            }
+        }
+
+        std::ofstream file(m_journalPath, std::ios::binary | std::ios::app);
+        if (!file.is_open())
+        {
+            LOG_ERROR("Failed to open search index journal: {}", m_journalPath);
+            return;
+        }
+        if (needsNewline)
+        {
+            file << '\n';
+        }
+
+        file << conversationId << '\t' << messageIndex << '\t';
+        for (std::size_t i = 0; i < terms.size(); i++)
+        {
+            file << (i ? " " : "") << terms[i];
+        }
+        file << '\n';
+        file.close();
+
+        std::error_code ec;
+        m_journalOffset = fs::file_size(m_journalPath, ec);
+        m_journalEntries++;
+    }
+
+} // namespace tarius::models
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Incremental full-text index over conversation messages.
+     *
+     * Every message is a document identified by (conversation id, message
+     * index). Posting lists are delta + varint encoded and only ever appended
+     * to, so adding a message is O(tokens). Queries are ranked with BM25.
+     *
+     * Persistence is a binary snapshot plus an append-only journal of the
+     * documents added since; the journal is folded into a new snapshot once
+     * it grows large and on shutdown.
+     *
+     * Several processes may share the directory. Each write first catches up
+     * on journal entries other processes appended, and reloads the snapshot
+     * if another process replaced it, so a snapshot always covers every
+     * process's documents.
+     */
+    class SearchIndex
+    {
+    public:
+        struct Hit
+        {
+            std::string conversationId;
+            int messageIndex;
+            double score;
+        };
+
+        explicit SearchIndex(const std::string &directory);
+        ~SearchIndex();
+
+        // Index a message. Documents must be added in chronological order.
+        void addDocument(const std::string &conversationId, int messageIndex, const std::string &text);
+
+        // Top-k documents for the query, best first
+        std::vector<Hit> search(const std::string &query, std::size_t k) const;
+
+        std::size_t documentCount() const { return m_docs.size(); }
+
+        // Write a fresh snapshot and truncate the journal
+        bool saveSnapshot();
+
+        // Lowercased alphanumeric terms with stop words removed
+        static std::vector<std::string> tokenize(const std::string &text);
+
+    private:
+        struct DocInfo
+        {
+            uint32_t conversation; // Index into m_conversationIds
+            uint32_t messageIndex;
+            uint32_t length; // Number of terms, for BM25 length normalisation
+        };
+
+        struct PostingList
+        {
+            std::string bytes; // varint(docId delta), varint(term frequency) pairs
+            uint32_t lastDoc = 0;
+            uint32_t docFreq = 0;
+        };
+
+        std::string m_snapshotPath;
+        std::string m_journalPath;
+        std::string m_lockPath;
+        std::size_t m_journalEntries;
+
+        // How much of the journal, and which snapshot, the in-memory index reflects
+        uintmax_t m_journalOffset;
+        std::filesystem::file_time_type m_snapshotTime;
+
+        std::vector<std::string> m_conversationIds;
+        std::unordered_map<std::string, uint32_t> m_conversationLookup;
+        std::vector<DocInfo> m_docs;
+        uint64_t m_totalLength;
+        std::unordered_map<std::string, PostingList> m_postings;
+
+        void indexTerms(const std::string &conversationId, int messageIndex, const std::vector<std::string> &terms);
+        bool loadSnapshot();
+        bool writeSnapshot();
+        void replayJournal();
+        void catchUp();
+        void clear();
+        void appendJournal(const std::string &conversationId, int messageIndex, const std::vector<std::string> &terms);
+    };
+
+} // namespace tarius::models
@@ -0,0 +1,229 @@
+#include "semantic_memory.h"
+#include "../utils/file_lock.h"
+#include "../utils/logger.h"
+#include "../kernels/similarity.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace tarius::models
+{
+    namespace
+    {
+        constexpr char kMagic[4] = {'T', 'V', 'E', 'C'};
+
+        // Below this many entries an exact scan beats walking the graph
+        constexpr std::size_t kBruteForceLimit = 4096;
+
+        template <typename T>
+        void writeValue(std::ofstream &out, const T &value)
+        {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool readValue(std::ifstream &in, T &value)
+        {
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+        }
+
+        void writeString(std::ofstream &out, const std::string &value)
+        {
+            writeValue(out, static_cast<uint32_t>(value.size()));
+            out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        bool readString(std::ifstream &in, std::string &value)
+        {
+            uint32_t length;
+            if (!readValue(in, length))
+            {
+                return false;
+            }
+            value.resize(length);
+            return static_cast<bool>(in.read(value.data(), length));
+        }
+    } // namespace
+
+    SemanticMemory::SemanticMemory(const std::string &directory)
+        : m_path(directory + "/vectors.bin"),
+          m_lockPath(utils::FileLock::forDirectory(directory)),
+          m_readOffset(0),
+          m_index(std::make_unique<HnswIndex>(m_arena))
+    {
+        fs::create_directories(directory);
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Shared);
+        load();
+        LOG_INFO("Loaded {} semantic memory entries", m_entries.size());
+    }
+
+    SemanticMemory::~SemanticMemory() = default;
+
+    bool SemanticMemory::add(const Entry &entry, const std::vector<float> &embedding)
+    {
+        if (embedding.empty())
+        {
+            return false;
+        }
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Exclusive);
+        load();
+
+        // A different model produces vectors of another size; those cannot be
+        // compared with what is stored, so start a fresh store
+        if (m_arena.dimension() != embedding.size())
+        {
+            if (m_arena.size() > 0)
+            {
+                LOG_WARN("Embedding dimension changed from {} to {}, resetting semantic memory",
+                         m_arena.dimension(), embedding.size());
+            }
+            reset(embedding.size());
+            fs::remove(m_path);
+        }
+
+        // Drop a record torn by a crash so new records stay readable
+        std::error_code ec;
+        if (fs::exists(m_path) && fs::file_size(m_path, ec) > m_readOffset)
+        {
+            fs::resize_file(m_path, m_readOffset, ec);
+        }
+
+        if (!append(entry, embedding))
+        {
+            return false;
+        }
+        m_readOffset = fs::file_size(m_path, ec);
+
+        uint32_t id = m_arena.add(embedding.data());
+        m_entries.push_back(entry);
+        m_index->insert(id);
+        return true;
+    }
+
+    std::vector<SemanticMemory::Match> SemanticMemory::search(const std::vector<float> &queryEmbedding, std::size_t k) const
+    {
+        std::vector<Match> matches;
+        if (queryEmbedding.size() != m_arena.dimension() || m_entries.empty())
+        {
+            return matches;
+        }
+
+        if (m_entries.size() <= kBruteForceLimit)
+        {
+            std::vector<float> scores(m_arena.size());
+            kernels::dotBatchF32(queryEmbedding.data(), m_arena.rows(), m_arena.size(), m_arena.dimension(), scores.data());
+            for (const auto &scored : kernels::topK(scores.data(), scores.size(), k))
+            {
+                matches.push_back({m_entries[scored.id], scored.score});
+            }
+            return matches;
+        }
+
+        for (const auto &[id, similarity] : m_index->search(queryEmbedding.data(), k))
+        {
+            matches.push_back({m_entries[id], similarity});
+        }
+        return matches;
+    }
+
+    void SemanticMemory::reset(std::size_t dimension)
+    {
+        m_arena.reset(dimension);
+        m_index = std::make_unique<HnswIndex>(m_arena);
+        m_entries.clear();
+        m_readOffset = 0;
+    }
+
+    void SemanticMemory::load()
+    {
+        std::error_code ec;
+        auto fileSize = fs::file_size(m_path, ec);
+        if (ec || fileSize < m_readOffset)
+        {
+            // Missing, or replaced by another process with a fresh store
+            if (m_readOffset > 0)
+            {
+                reset(0);
+            }
+            if (ec)
+            {
+                return;
+            }
+        }
+        if (fileSize == m_readOffset)
+        {
+            return;
+        }
+
+        std::ifstream in(m_path, std::ios::binary);
+        if (!in.is_open())
+        {
+            return;
+        }
+
+        char magic[sizeof(kMagic)];
+        uint32_t dimension;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !readValue(in, dimension) || dimension == 0)
+        {
+            LOG_ERROR("Semantic memory file is corrupt, ignoring: {}", m_path);
+            return;
+        }
+
+        // The store is only ever recreated for a new dimension
+        if (m_readOffset == 0 || dimension != m_arena.dimension())
+        {
+            reset(dimension);
+            m_readOffset = static_cast<uintmax_t>(in.tellg());
+        }
+        else
+        {
+            in.seekg(static_cast<std::streamoff>(m_readOffset));
+        }
+
+        std::vector<float> vector(m_arena.dimension());
+        while (true)
+        {
+            Entry entry;
+            int32_t messageIndex;
+            if (!readString(in, entry.conversationId) || !readValue(in, messageIndex) || !readString(in, entry.text) ||
+                !in.read(reinterpret_cast<char *>(vector.data()), static_cast<std::streamsize>(vector.size() * sizeof(float))))
+            {
+                break; // End of file, or a record torn by a crash
+            }
+            entry.messageIndex = messageIndex;
+
+            m_index->insert(m_arena.add(vector.data()));
+            m_entries.push_back(std::move(entry));
+            m_readOffset = static_cast<uintmax_t>(in.tellg());
+        }
+    }
+
+    bool SemanticMemory::append(const Entry &entry, const std::vector<float> &embedding)
+    {
+        bool isNew = !fs::exists(m_path);
+        std::ofstream out(m_path, std::ios::binary | std::ios::app);
+        if (!out.is_open())
+        {
+            LOG_ERROR("Failed to open semantic memory file for writing: {}", m_path);
+            return false;
+        }
+
+        if (isNew)
+        {
+            out.write(kMagic, sizeof(kMagic));
+            writeValue(out, static_cast<uint32_t>(embedding.size()));
+        }
+
+        writeString(out, entry.conversationId);
+        writeValue(out, static_cast<int32_t>(entry.messageIndex));
+        writeString(out, entry.text);
+        out.write(reinterpret_cast<const char *>(embedding.data()), static_cast<std::streamsize>(embedding.size() * sizeof(float)));
+        return true;
+    }
+
+} // namespace tarius::models
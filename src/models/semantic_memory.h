@@ -0,0 +1,60 @@
+#pragma once
+
+#include "hnsw_index.h"
+#include "vector_arena.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Embedding store for long-term recall of messages and summaries.
+     *
+     * Embeddings live in a VectorArena and are served through an HNSW graph.
+     * Every entry is appended to a binary file under the data directory and
+     * the graph is rebuilt from it on startup. Processes sharing the file
+     * pick up each other's entries before appending their own.
+     */
+    class SemanticMemory
+    {
+    public:
+        struct Entry
+        {
+            std::string conversationId;
+            int messageIndex; // -1 for a conversation summary
+            std::string text;
+        };
+
+        struct Match
+        {
+            Entry entry;
+            float similarity;
+        };
+
+        explicit SemanticMemory(const std::string &directory);
+        ~SemanticMemory();
+
+        // Store an entry with its L2-normalised embedding
+        bool add(const Entry &entry, const std::vector<float> &embedding);
+
+        // Most similar entries to the query embedding, best first
+        std::vector<Match> search(const std::vector<float> &queryEmbedding, std::size_t k) const;
+
+        std::size_t size() const { return m_entries.size(); }
+
+    private:
+        std::string m_path;
+        std::string m_lockPath;
+        uintmax_t m_readOffset; // End of the last complete record loaded
+        VectorArena m_arena;
+        std::unique_ptr<HnswIndex> m_index;
+        std::vector<Entry> m_entries;
+
+        // Load records past m_readOffset, starting over if the file was replaced
+        void load();
+        void reset(std::size_t dimension);
+        bool append(const Entry &entry, const std::vector<float> &embedding);
+    };
+
+} // namespace tarius::models
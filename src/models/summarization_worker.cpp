@@ -0,0 +1,300 @@
+#include "summarization_worker.h"
+#include "../utils/logger.h"
+#include "../utils/tracer.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tarius::models
+{
+    namespace
+    {
+        // Roughly 1000 tokens of conversation per chunk, which leaves room for
+        // the instructions and the generated summary in a 2048-token context
+        constexpr std::size_t kChunkChars = 4000;
+
+        // Number of summaries combined by one merge call
+        constexpr std::size_t kMergeFanIn = 4;
+
+        std::string chunkPrompt(const std::string &text)
+        {
+            return "Summarize this part of a conversation in a few sentences. Keep names, decisions, "
+                   "dates and open questions:\n\n" +
+                   text;
+        }
+
+        std::string mergePrompt(const std::vector<std::string> &summaries, std::size_t begin, std::size_t end)
+        {
+            std::string prompt = "Combine these partial summaries of one conversation into a single concise summary. "
+                                 "Keep names, decisions, dates and open questions:\n\n";
+            for (std::size_t i = begin; i < end; i++)
+            {
+                prompt += "- " + summaries[i] + "\n";
+            }
+            return prompt;
+        }
+    } // namespace
+
+    const char *const SummarizationWorker::kSystemPrompt =
+        "You are Tarius, an AI that summarizes conversations. Create concise, accurate summaries that capture "
+        "the key points, topics, and outcomes of conversations. Focus on extracting the most important "
+        "information while maintaining clarity and objectivity.";
+
+    SummarizationWorker::SummarizationWorker()
+        : m_nextClient(1), m_running(0), m_stopping(false), m_interactive(0)
+    {
+        m_thread = std::thread(&SummarizationWorker::run, this);
+    }
+
+    SummarizationWorker::~SummarizationWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    SummarizationWorker::ClientId SummarizationWorker::attach(Callbacks callbacks)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ClientId client = m_nextClient++;
+        m_clients.emplace(client, std::move(callbacks));
+        return client;
+    }
+
+    void SummarizationWorker::detach(ClientId client)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_clients.erase(client);
+
+        std::deque<Job> kept;
+        for (auto &job : m_queue)
+        {
+            if (job.client == client)
+            {
+                m_queued.erase(jobKey(job));
+            }
+            else
+            {
+                kept.push_back(std::move(job));
+            }
+        }
+        m_queue.swap(kept);
+
+        // A summary in progress stops before its next model call
+        m_cv.notify_all();
+        m_cv.wait(lock, [this, client]
+                  { return m_running != client; });
+    }
+
+    void SummarizationWorker::enqueue(ClientId client, const std::string &conversationId)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Job job{client, conversationId};
+            if (!m_clients.count(client) || !m_queued.insert(jobKey(job)).second)
+            {
+                return;
+            }
+            m_queue.push_back(std::move(job));
+        }
+        m_cv.notify_all();
+    }
+
+    void SummarizationWorker::setInteractive(bool active)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (active)
+            {
+                m_interactive++;
+            }
+            else if (m_interactive > 0)
+            {
+                m_interactive--;
+            }
+        }
+        m_cv.notify_all();
+    }
+
+    std::string SummarizationWorker::jobKey(const Job &job)
+    {
+        return std::to_string(job.client) + "/" + job.conversationId;
+    }
+
+    std::size_t SummarizationWorker::pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    bool SummarizationWorker::waitUntilIdle(ClientId client)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this, client]
+                  { return m_stopping || !m_clients.count(client) || m_interactive == 0; });
+        return !m_stopping && m_clients.count(client);
+    }
+
+    void SummarizationWorker::run()
+    {
+        utils::Tracer::setThreadName("summarizer");
+
+#ifdef __linux__
+        // Only this thread is lowered; on Linux niceness is per thread
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+
+        while (true)
+        {
+            Job job;
+            Callbacks callbacks;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]
+                          { return m_stopping || !m_queue.empty(); });
+                if (m_stopping)
+                {
+                    return;
+                }
+
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+                m_queued.erase(jobKey(job));
+
+                // detach() waits for m_running to move on, so the client's
+                // callbacks stay valid until then
+                callbacks = m_clients.at(job.client);
+                m_running = job.client;
+            }
+
+            try
+            {
+                process(job, callbacks);
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Background summarization of {} failed: {}", job.conversationId, e.what());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = 0;
+            }
+            m_cv.notify_all();
+        }
+    }
+
+    void SummarizationWorker::process(const Job &job, const Callbacks &callbacks)
+    {
+        Conversation conversation;
+        if (!callbacks.loadConversation(job.conversationId, conversation))
+        {
+            return;
+        }
+
+        Summary previous;
+        bool hasPrevious = callbacks.loadSummary(job.conversationId, previous);
+
+        Summary summary;
+        if (buildSummary(conversation, hasPrevious ? &previous : nullptr, callbacks.summarize,
+                         [this, &job]
+                         { return waitUntilIdle(job.client); },
+                         summary))
+        {
+            callbacks.saveSummary(summary);
+            LOG_INFO("Background summary ready for conversation: {}", job.conversationId);
+        }
+    }
+
+    bool SummarizationWorker::buildSummary(const Conversation &conversation, const Summary *previous,
+                                           const Summarize &summarize, const std::function<bool()> &beforeCall,
+                                           Summary &out)
+    {
+        std::vector<std::string> chunks;
+        std::size_t start = 0;
+        if (previous && previous->messageCount <= conversation.messages.size())
+        {
+            chunks = previous->chunkSummaries;
+            start = previous->messageCount;
+        }
+
+        if (start == conversation.messages.size() && !chunks.empty())
+        {
+            return false; // Nothing new since the last summary
+        }
+
+        // Summarize the new messages chunk by chunk
+        std::string chunkText;
+        auto flushChunk = [&]()
+        {
+            if (chunkText.empty())
+            {
+                return true;
+            }
+            if (!beforeCall())
+            {
+                return false;
+            }
+            chunks.push_back(summarize(chunkPrompt(chunkText)));
+            chunkText.clear();
+            return true;
+        };
+
+        for (std::size_t i = start; i < conversation.messages.size(); i++)
+        {
+            const Message &msg = conversation.messages[i];
+            std::string line = msg.speaker + ": " + msg.content.substr(0, kChunkChars) + "\n";
+
+            if (chunkText.size() + line.size() > kChunkChars && !flushChunk())
+            {
+                return false;
+            }
+            chunkText += line;
+        }
+        if (!flushChunk() || chunks.empty())
+        {
+            return false;
+        }
+
+        // Merge chunk summaries level by level until one remains
+        std::vector<std::string> level = chunks;
+        while (level.size() > 1)
+        {
+            std::vector<std::string> next;
+            for (std::size_t begin = 0; begin < level.size(); begin += kMergeFanIn)
+            {
+                std::size_t end = std::min(begin + kMergeFanIn, level.size());
+                if (end - begin == 1)
+                {
+                    next.push_back(level[begin]);
+                    continue;
+                }
+                if (!beforeCall())
+                {
+                    return false;
+                }
+                next.push_back(summarize(mergePrompt(level, begin, end)));
+            }
+            level = std::move(next);
+        }
+
+        out.conversationId = conversation.id;
+        out.content = level.front();
+        out.timestamp = std::chrono::system_clock::now();
+        out.chunkSummaries = std::move(chunks);
+        out.messageCount = conversation.messages.size();
+        return true;
+    }
+
+} // namespace tarius::models
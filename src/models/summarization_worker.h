@@ -0,0 +1,111 @@
+#pragma once
+
+#include "memory_manager.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tarius::models
+{
+    /**
+     * @brief Background worker that summarizes finished conversations.
+     *
+     * Conversations are split into chunks that each fit comfortably in the
+     * model's context. Every chunk gets its own summary, and chunk summaries
+     * are then merged in small groups until a single summary remains. Chunk
+     * summaries are kept in the Summary record, so a conversation that grows
+     * later only has its new messages summarized.
+     *
+     * The worker thread runs at low OS priority and waits between LLM calls
+     * while interactive generation is in progress. One worker can serve
+     * several memory managers, e.g. one per session, each attached as a
+     * client with its own storage callbacks.
+     */
+    class SummarizationWorker
+    {
+    public:
+        // Runs one summarization prompt through the model
+        using Summarize = std::function<std::string(const std::string &prompt)>;
+
+        struct Callbacks
+        {
+            Summarize summarize;
+            std::function<bool(const std::string &id, Conversation &conversation)> loadConversation;
+            std::function<bool(const std::string &id, Summary &summary)> loadSummary;
+            std::function<void(const Summary &summary)> saveSummary;
+        };
+
+        // System prompt the summarize callback should run under
+        static const char *const kSystemPrompt;
+
+        using ClientId = uint64_t;
+
+        SummarizationWorker();
+        ~SummarizationWorker();
+
+        // Register a memory manager; its callbacks are used until detach()
+        ClientId attach(Callbacks callbacks);
+
+        // Drop the client's queued conversations and wait out one in progress
+        void detach(ClientId client);
+
+        // Queue a conversation; duplicates of a pending id are ignored
+        void enqueue(ClientId client, const std::string &conversationId);
+
+        // While any client is active, the worker holds off starting new LLM
+        // calls. Calls nest, so each true needs a matching false.
+        void setInteractive(bool active);
+
+        std::size_t pending() const;
+
+        /**
+         * @brief Build or extend a summary with the chunk-and-merge scheme.
+         *
+         * @param conversation The conversation to summarize
+         * @param previous An earlier summary of the same conversation, or nullptr
+         * @param summarize The model call
+         * @param beforeCall Invoked before every model call; returns false to abort
+         * @param out The resulting summary
+         * @return true if a summary was produced
+         */
+        static bool buildSummary(const Conversation &conversation, const Summary *previous,
+                                 const Summarize &summarize, const std::function<bool()> &beforeCall,
+                                 Summary &out);
+
+    private:
+        struct Job
+        {
+            ClientId client;
+            std::string conversationId;
+        };
+
+        std::unordered_map<ClientId, Callbacks> m_clients;
+        ClientId m_nextClient;
+        ClientId m_running; // Client whose conversation is being summarized, or 0
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<Job> m_queue;
+        std::unordered_set<std::string> m_queued; // jobKey() of each queued job
+        bool m_stopping;
+        int m_interactive;
+
+        std::thread m_thread;
+
+        void run();
+        void process(const Job &job, const Callbacks &callbacks);
+
+        // Blocks while interactive generation is active; false once stopping
+        // or once the client has been detached
+        bool waitUntilIdle(ClientId client);
+
+        static std::string jobKey(const Job &job);
+    };
+
+} // namespace tarius::models
@@ -0,0 +1,431 @@
+#include "summary_rollup.h"
+#include "../utils/file_lock.h"
+#include "../utils/json_handler.h"
+#include "../utils/logger.h"
+#include "../utils/time_utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace tarius::models
+{
+    namespace
+    {
+        // Number of child summaries combined by one merge call
+        constexpr std::size_t kMergeFanIn = 6;
+
+        int firstOfMonth(int day)
+        {
+            int y, m, d;
+            utils::TimeUtils::civilFromDays(day, y, m, d);
+            return day - (d - 1);
+        }
+
+        int lastOfMonth(int day)
+        {
+            int y, m, d;
+            utils::TimeUtils::civilFromDays(day, y, m, d);
+            return m == 12 ? utils::TimeUtils::daysFromCivil(y + 1, 1, 1) - 1 : utils::TimeUtils::daysFromCivil(y, m + 1, 1) - 1;
+        }
+
+        const char *levelName(SummaryRollup::Level level)
+        {
+            switch (level)
+            {
+            case SummaryRollup::Level::Day:
+                return "day";
+            case SummaryRollup::Level::Week:
+                return "week";
+            default:
+                return "month";
+            }
+        }
+
+        std::string mergePrompt(SummaryRollup::Level level, const std::vector<std::string> &parts,
+                                std::size_t begin, std::size_t end)
+        {
+            std::string prompt = std::string("Combine these summaries into one concise summary of the ") +
+                                 levelName(level) + ". Keep names, decisions, dates and open questions:\n\n";
+            for (std::size_t i = begin; i < end; i++)
+            {
+                prompt += "- " + parts[i] + "\n";
+            }
+            return prompt;
+        }
+    } // namespace
+
+    SummaryRollup::SummaryRollup(const std::string &directory, LoadSummary loadSummary)
+        : m_directory(directory), m_lockPath(utils::FileLock::forDirectory(directory)),
+          m_generationPath(directory + "/generation"), m_loadSummary(std::move(loadSummary)), m_generation(0)
+    {
+        fs::create_directories(m_directory);
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Shared);
+        load();
+    }
+
+    bool SummaryRollup::parseDate(const std::string &date, int &day)
+    {
+        return utils::TimeUtils::parseIsoDate(date, day);
+    }
+
+    std::string SummaryRollup::formatDate(int day)
+    {
+        return utils::TimeUtils::formatIsoDate(day);
+    }
+
+    std::string SummaryRollup::dayKey(int day)
+    {
+        return "day_" + formatDate(day);
+    }
+
+    std::string SummaryRollup::weekKey(int monday)
+    {
+        return "week_" + formatDate(monday);
+    }
+
+    std::string SummaryRollup::monthKey(int firstOfMonth)
+    {
+        return "month_" + formatDate(firstOfMonth).substr(0, 7);
+    }
+
+    void SummaryRollup::addConversation(const std::string &conversationId, const std::string &date)
+    {
+        int day;
+        if (!parseDate(date, day))
+        {
+            LOG_WARN("Cannot place conversation {} in the rollup, bad date: {}", conversationId, date);
+            return;
+        }
+
+        int monday = day - utils::TimeUtils::weekday(day);
+        int monthStart = firstOfMonth(day);
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Exclusive);
+        load();
+
+        touch(dayKey(day), Level::Day, day, day, conversationId);
+        touch(weekKey(monday), Level::Week, monday, monday + 6, dayKey(day));
+        touch(monthKey(monthStart), Level::Month, monthStart, lastOfMonth(day), dayKey(day));
+        bumpGeneration();
+    }
+
+    void SummaryRollup::touch(const std::string &key, Level level, int firstDay, int lastDay, const std::string &child)
+    {
+        auto [it, inserted] = m_nodes.try_emplace(key);
+        Node &node = it->second;
+        if (inserted)
+        {
+            node.level = level;
+            node.firstDay = firstDay;
+            node.lastDay = lastDay;
+        }
+
+        if (std::find(node.children.begin(), node.children.end(), child) == node.children.end())
+        {
+            // Keys and conversation ids both sort chronologically
+            node.children.insert(std::upper_bound(node.children.begin(), node.children.end(), child), child);
+        }
+        node.stale = true;
+        node.revision++;
+        save(key, node);
+    }
+
+    SummaryRollup::Plan SummaryRollup::plan(const std::string &from, const std::string &to, bool merge)
+    {
+        Plan plan;
+        plan.merge = merge;
+        int first, last;
+        if (!parseDate(from, first) || !parseDate(to, last) || first > last)
+        {
+            return plan;
+        }
+
+        utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Shared);
+        load();
+
+        auto emit = [&](const std::string &key)
+        {
+            plan.keys.push_back(key);
+            collect(plan, key);
+        };
+
+        // Whole weeks where they fit, single days elsewhere
+        auto coverWeeksAndDays = [&](int a, int b)
+        {
+            for (int day = a; day <= b;)
+            {
+                if (utils::TimeUtils::weekday(day) == 0 && day + 6 <= b)
+                {
+                    emit(weekKey(day));
+                    day += 7;
+                }
+                else
+                {
+                    emit(dayKey(day));
+                    day++;
+                }
+            }
+        };
+
+        // The whole months inside the range, if any
+        int monthsBegin = first == firstOfMonth(first) ? first : lastOfMonth(first) + 1;
+        int monthsEnd = last == lastOfMonth(last) ? last : firstOfMonth(last) - 1;
+        if (monthsBegin > monthsEnd)
+        {
+            coverWeeksAndDays(first, last);
+            return plan;
+        }
+
+        coverWeeksAndDays(first, monthsBegin - 1);
+        for (int day = monthsBegin; day <= monthsEnd; day = lastOfMonth(day) + 1)
+        {
+            emit(monthKey(day));
+        }
+        coverWeeksAndDays(monthsEnd + 1, last);
+        return plan;
+    }
+
+    void SummaryRollup::collect(Plan &plan, const std::string &key)
+    {
+        auto it = m_nodes.find(key);
+        if (it == m_nodes.end() || plan.nodes.count(key))
+        {
+            return;
+        }
+
+        const Node &node = plan.nodes.emplace(key, it->second).first->second;
+        if (!needsBuild(node, plan.merge))
+        {
+            return;
+        }
+        for (const auto &child : node.children)
+        {
+            if (node.level == Level::Day)
+            {
+                Summary summary;
+                if (m_loadSummary(child, summary) && !summary.content.empty())
+                {
+                    plan.summaries[key].push_back(summary.content);
+                }
+            }
+            else
+            {
+                collect(plan, child);
+            }
+        }
+    }
+
+    void SummaryRollup::build(Plan &plan, const Summarize &summarize)
+    {
+        for (const auto &key : plan.keys)
+        {
+            resolve(plan, key, summarize);
+        }
+    }
+
+    std::vector<SummaryRollup::Period> SummaryRollup::finish(const Plan &plan)
+    {
+        if (!plan.rebuilt.empty())
+        {
+            utils::FileLock fileLock(m_lockPath, utils::FileLock::Mode::Exclusive);
+            load();
+
+            for (const auto &[key, revision] : plan.rebuilt)
+            {
+                // A conversation that landed during the build leaves the node stale
+                auto it = m_nodes.find(key);
+                if (it == m_nodes.end() || it->second.revision != revision)
+                {
+                    continue;
+                }
+                const Node &built = plan.nodes.at(key);
+                Node &node = it->second;
+                node.content = built.content;
+                node.stale = false;
+                node.merged = built.merged;
+                save(key, node);
+            }
+            bumpGeneration();
+        }
+
+        std::vector<Period> periods;
+        for (const auto &key : plan.keys)
+        {
+            auto it = plan.nodes.find(key);
+            if (it != plan.nodes.end() && !it->second.content.empty())
+            {
+                const Node &node = it->second;
+                periods.push_back({node.level, formatDate(node.firstDay), formatDate(node.lastDay), node.content});
+            }
+        }
+        return periods;
+    }
+
+    bool SummaryRollup::needsBuild(const Node &node, bool merge)
+    {
+        return node.stale || (merge && !node.merged);
+    }
+
+    const SummaryRollup::Node *SummaryRollup::resolve(Plan &plan, const std::string &key, const Summarize &summarize)
+    {
+        auto it = plan.nodes.find(key);
+        if (it == plan.nodes.end())
+        {
+            return nullptr;
+        }
+
+        // Only what plan() collected children for can be rebuilt
+        const bool merge = plan.merge && summarize;
+        Node &node = it->second;
+        if (!needsBuild(node, merge))
+        {
+            return node.content.empty() ? nullptr : &node;
+        }
+
+        std::vector<std::string> parts;
+        if (node.level == Level::Day)
+        {
+            parts = plan.summaries[key];
+        }
+        else
+        {
+            for (const auto &child : node.children)
+            {
+                if (const Node *childNode = resolve(plan, child, summarize))
+                {
+                    parts.push_back(formatDate(childNode->firstDay) + ": " + childNode->content);
+                }
+            }
+        }
+
+        if (merge && parts.size() > 1)
+        {
+            // Merge level by level so no single prompt grows with the period
+            while (parts.size() > 1)
+            {
+                std::vector<std::string> next;
+                for (std::size_t begin = 0; begin < parts.size(); begin += kMergeFanIn)
+                {
+                    std::size_t end = std::min(begin + kMergeFanIn, parts.size());
+                    next.push_back(end - begin == 1 ? parts[begin] : summarize(mergePrompt(node.level, parts, begin, end)));
+                }
+                parts = std::move(next);
+            }
+            node.content = parts.front();
+        }
+        else
+        {
+            node.content.clear();
+            for (const auto &part : parts)
+            {
+                node.content += (node.content.empty() ? "" : "\n") + part;
+            }
+        }
+
+        node.stale = false;
+        node.merged = merge;
+        plan.rebuilt[key] = node.revision;
+        return node.content.empty() ? nullptr : &node;
+    }
+
+    void SummaryRollup::load()
+    {
+        uint64_t generation = readGeneration();
+        if (m_generation != 0 && generation == m_generation)
+        {
+            return; // Nobody has written since
+        }
+
+        for (const auto &entry : fs::directory_iterator(m_directory))
+        {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json")
+            {
+                continue;
+            }
+
+            std::string key = entry.path().stem().string();
+            auto fileTime = entry.last_write_time();
+            auto known = m_nodes.find(key);
+            if (known != m_nodes.end() && known->second.fileTime == fileTime)
+            {
+                continue;
+            }
+
+            nlohmann::json j;
+            if (!utils::JsonHandler::loadFromFile(entry.path().string(), j))
+            {
+                continue;
+            }
+
+            try
+            {
+                Node node;
+                std::string level = j.at("level").get<std::string>();
+                node.level = level == "day" ? Level::Day : level == "week" ? Level::Week
+                                                                             : Level::Month;
+                if (!parseDate(j.at("from").get<std::string>(), node.firstDay) ||
+                    !parseDate(j.at("to").get<std::string>(), node.lastDay))
+                {
+                    continue;
+                }
+                node.children = j.at("children").get<std::vector<std::string>>();
+                node.content = j.value("content", "");
+                node.stale = j.value("stale", true);
+                node.merged = j.value("merged", false);
+                node.revision = j.value("revision", uint64_t{0});
+                node.fileTime = fileTime;
+                m_nodes[key] = std::move(node);
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Failed to parse rollup node {}: {}", entry.path().string(), e.what());
+            }
+        }
+        m_generation = generation;
+    }
+
+    uint64_t SummaryRollup::readGeneration() const
+    {
+        uint64_t generation = 0;
+        std::ifstream file(m_generationPath);
+        file >> generation;
+        return generation;
+    }
+
+    void SummaryRollup::bumpGeneration()
+    {
+        // load() has just run under the same lock, so m_generation is current
+        std::ofstream file(m_generationPath, std::ios::trunc);
+        file << ++m_generation;
+        if (!file)
+        {
+            LOG_WARN("Failed to write {}; other processes may miss rollup updates", m_generationPath);
+        }
+    }
+
+    bool SummaryRollup::save(const std::string &key, Node &node) const
+    {
+        nlohmann::json j;
+        j["level"] = levelName(node.level);
+        j["from"] = formatDate(node.firstDay);
+        j["to"] = formatDate(node.lastDay);
+        j["children"] = node.children;
+        j["content"] = node.content;
+        j["stale"] = node.stale;
+        j["merged"] = node.merged;
+        j["revision"] = node.revision;
+        std::string path = m_directory + "/" + key + ".json";
+        if (!utils::JsonHandler::saveToFile(path, j))
+        {
+            return false;
+        }
+
+        std::error_code ec;
+        node.fileTime = fs::last_write_time(path, ec);
+        return true;
+    }
+
+} // namespace tarius::models
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "memory_manager.h"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Day, week and month summaries built on top of conversation summaries.
+     *
+     * Conversation summaries feed one node per day; day nodes feed one node
+     * per ISO week (Monday to Sunday) and one per calendar month. A node is
+     * marked stale when a child lands and is only rebuilt when a query needs
+     * it, so a range query reads a handful of precomputed nodes instead of
+     * every summary in the range.
+     *
+     * Nodes are small JSON files under the rollup directory and are all held
+     * in memory. Every update bumps a generation stamp next to them, and the
+     * directory is only rescanned when another process sharing it has
+     * written since.
+     *
+     * A query runs in three steps so the model calls hold no lock: plan()
+     * copies the nodes covering the range and the summaries under stale
+     * ones, build() rebuilds the copies, and finish() stores those no new
+     * conversation has landed in meanwhile.
+     */
+    class SummaryRollup
+    {
+    public:
+        enum class Level
+        {
+            Day,
+            Week,
+            Month
+        };
+
+        struct Period
+        {
+            Level level;
+            std::string from; // First day, YYYY-MM-DD
+            std::string to;   // Last day, YYYY-MM-DD
+            std::string content;
+        };
+
+        using Summarize = std::function<std::string(const std::string &prompt)>;
+        using LoadSummary = std::function<bool(const std::string &conversationId, Summary &summary)>;
+
+    private:
+        struct Node
+        {
+            Level level;
+            int firstDay;
+            int lastDay;
+            std::vector<std::string> children; // Conversation ids for days, day keys otherwise
+            std::string content;
+            bool stale = true;
+            bool merged = false;   // Built by the model rather than concatenated
+            uint64_t revision = 0; // Bumped whenever a child lands
+            std::filesystem::file_time_type fileTime; // Of the file this was read from or written to
+        };
+
+    public:
+        // A query between plan() and finish(); only SummaryRollup reads it
+        struct Plan
+        {
+            bool merge = false;                                        // build() is given a summarizer
+            std::vector<std::string> keys;                             // Periods covering the range, in order
+            std::map<std::string, Node> nodes;                         // Copies of those and what is under them
+            std::map<std::string, std::vector<std::string>> summaries; // Day nodes to rebuild: their conversations
+            std::map<std::string, uint64_t> rebuilt;                   // Key to the revision it was built from
+        };
+
+        SummaryRollup(const std::string &directory, LoadSummary loadSummary);
+
+        // True until the first conversation has been registered
+        bool empty() const { return m_nodes.empty(); }
+
+        // Register a new or updated conversation summary for a day (YYYY-MM-DD)
+        // and mark the day, week and month above it stale
+        void addConversation(const std::string &conversationId, const std::string &date);
+
+        /**
+         * @brief The periods covering an inclusive date range, for build().
+         *
+         * The range is covered by whole months first, then whole weeks, then
+         * single days. merge says whether build() will be given a summarizer;
+         * nodes built without one are rebuilt when it is.
+         */
+        Plan plan(const std::string &from, const std::string &to, bool merge);
+
+        // Rebuild the stale nodes of a plan with summarize, or by concatenating
+        // their children when it is empty. Touches nothing but the plan.
+        static void build(Plan &plan, const Summarize &summarize);
+
+        // Store what build() rebuilt and return the periods with
+        // conversations, oldest first
+        std::vector<Period> finish(const Plan &plan);
+
+        // Days since 1970-01-01 for a YYYY-MM-DD date; false if it does not parse
+        static bool parseDate(const std::string &date, int &day);
+        static std::string formatDate(int day);
+
+    private:
+        std::string m_directory;
+        std::string m_lockPath;
+        std::string m_generationPath;
+        LoadSummary m_loadSummary;
+        std::map<std::string, Node> m_nodes;
+        uint64_t m_generation; // Of the directory as last read or written; 0 before the first read
+
+        // Read node files that are new or changed, if anyone has written since
+        void load();
+        bool save(const std::string &key, Node &node) const;
+        uint64_t readGeneration() const;
+        // After an update, with the lock still held
+        void bumpGeneration();
+
+        // Register child under the node for key, creating it as needed
+        void touch(const std::string &key, Level level, int firstDay, int lastDay, const std::string &child);
+
+        // Copy the node for key into the plan, with what a rebuild would read
+        void collect(Plan &plan, const std::string &key);
+
+        // Rebuild the planned node if stale; returns nullptr if the period has no conversations
+        static const Node *resolve(Plan &plan, const std::string &key, const Summarize &summarize);
+
+        static bool needsBuild(const Node &node, bool merge);
+        static std::string dayKey(int day);
+        static std::string weekKey(int monday);
+        static std::string monthKey(int firstOfMonth);
+    };
+
+} // namespace tarius::models
@@ -0,0 +1,46 @@
+#include "vector_arena.h"
+#include "../kernels/similarity.h"
+
+namespace tarius::models
+{
+
+    VectorArena::VectorArena(std::size_t dimension)
+        : m_dimension(dimension)
+    {
+    }
+
+    void VectorArena::reset(std::size_t dimension)
+    {
+        m_dimension = dimension;
+        m_floats.clear();
+        m_int8.clear();
+        m_scales.clear();
+    }
+
+    uint32_t VectorArena::add(const float *vector)
+    {
+        uint32_t id = static_cast<uint32_t>(m_scales.size());
+
+        m_floats.insert(m_floats.end(), vector, vector + m_dimension);
+        m_int8.resize(m_int8.size() + m_dimension);
+        m_scales.push_back(quantize(vector, m_dimension, m_int8.data() + static_cast<std::size_t>(id) * m_dimension));
+
+        return id;
+    }
+
+    float VectorArena::dot(const float *query, uint32_t id) const
+    {
+        return kernels::dotF32(query, row(id), m_dimension);
+    }
+
+    float VectorArena::dotQuantized(const int8_t *query, float queryScale, uint32_t id) const
+    {
+        return static_cast<float>(kernels::dotI8(query, quantizedRow(id), m_dimension)) * queryScale * m_scales[id];
+    }
+
+    float VectorArena::quantize(const float *in, std::size_t dimension, int8_t *out)
+    {
+        return kernels::quantizeI8(in, out, dimension);
+    }
+
+} // namespace tarius::models
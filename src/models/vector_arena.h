@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tarius::models
+{
+    /**
+     * @brief Contiguous storage for fixed-dimension embedding vectors.
+     *
+     * Each vector is kept twice: as float32 for exact scoring and as int8
+     * with a per-row scale for cheap approximate scoring during graph
+     * traversal. Rows are addressed by the id returned from add().
+     */
+    class VectorArena
+    {
+    public:
+        explicit VectorArena(std::size_t dimension = 0);
+
+        std::size_t dimension() const { return m_dimension; }
+        std::size_t size() const { return m_scales.size(); }
+
+        // Drop all rows and switch to a new dimension
+        void reset(std::size_t dimension);
+
+        // Append a vector of dimension() floats, returns its id
+        uint32_t add(const float *vector);
+
+        const float *row(uint32_t id) const { return m_floats.data() + static_cast<std::size_t>(id) * m_dimension; }
+        const int8_t *quantizedRow(uint32_t id) const { return m_int8.data() + static_cast<std::size_t>(id) * m_dimension; }
+        float scale(uint32_t id) const { return m_scales[id]; }
+
+        // Contiguous view over all float rows, for batch scoring
+        const float *rows() const { return m_floats.data(); }
+
+        // Exact dot product between a query and a stored row
+        float dot(const float *query, uint32_t id) const;
+
+        // Approximate dot product between a quantized query and a stored row
+        float dotQuantized(const int8_t *query, float queryScale, uint32_t id) const;
+
+        // Symmetric int8 quantization, returns the scale to multiply back by
+        static float quantize(const float *in, std::size_t dimension, int8_t *out);
+
+    private:
+        std::size_t m_dimension;
+        std::vector<float> m_floats;
+        std::vector<int8_t> m_int8;
+        std::vector<float> m_scales;
+    };
+
+} // namespace tarius::models
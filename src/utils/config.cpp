@@ -1,21 +1,85 @@
 #include "config.h"
+#include "json_handler.h"
 #include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <filesystem>
+#include <type_traits>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 namespace tarius::utils
 {
+    namespace
+    {
+        // Objects and arrays are kept as their JSON text
+        Config::Value toValue(const json &j)
+        {
+            switch (j.type())
+            {
+            case json::value_t::boolean:
+                return j.get<bool>();
+            case json::value_t::number_integer:
+            case json::value_t::number_unsigned:
+                return j.get<int64_t>();
+            case json::value_t::number_float:
+                return j.get<double>();
+            case json::value_t::string:
+                return j.get<std::string>();
+            default:
+                return j.dump();
+            }
+        }
 
-    Config::Config()
-        : m_configFilePath("data/config.json")
+        json toJson(const Config::Value &value)
+        {
+            return std::visit([](const auto &v) -> json
+                              {
+                                  if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::monostate>)
+                                  {
+                                      return nullptr;
+                                  }
+                                  else
+                                  {
+                                      return v;
+                                  } },
+                              value);
+        }
+    } // namespace
+
+    std::size_t Config::Values::slotOf(const std::string &key)
     {
+        auto it = slots.find(key);
+        if (it != slots.end())
+        {
+            return it->second;
+        }
+        slots.emplace(key, keys.size());
+        keys.push_back(key);
+        values.emplace_back();
+        return keys.size() - 1;
     }
 
-    Config::~Config() = default;
+    Config::Config(const std::string &configFilePath)
+        : m_configFilePath(configFilePath), m_nextSubscriberId(1), m_inotifyFd(-1), m_wakeFd(-1)
+    {
+        auto values = std::make_shared<Values>();
+        setDefaults(*values);
+        m_values = std::move(values);
+    }
+
+    Config::~Config()
+    {
+        stopWatching();
+    }
 
     bool Config::load()
     {
@@ -23,178 +87,382 @@ namespace tarius::utils
         if (!fs::exists(m_configFilePath))
         {
             LOG_INFO("Config file does not exist, creating with defaults");
-            setDefaults();
             return save();
         }
 
-        // Read file
-        std::ifstream file(m_configFilePath);
-        if (!file.is_open())
-        {
-            LOG_ERROR("Failed to open config file for reading: {}", m_configFilePath);
-            setDefaults();
-            return false;
-        }
-
+        // Read and parse the whole file before touching the current values
+        json configJson;
         try
         {
-            json configJson = json::parse(file);
-            file.close();
-
-            // Clear existing values
-            m_configValues.clear();
-
-            // Load values from JSON
-            for (auto it = configJson.begin(); it != configJson.end(); ++it)
+            std::ifstream file(m_configFilePath);
+            if (!file.is_open())
             {
-                m_configValues[it.key()] = it.value().dump();
+                LOG_ERROR("Failed to open config file for reading: {}", m_configFilePath);
+                return false;
             }
-
-            LOG_INFO("Loaded configuration from {}", m_configFilePath);
-            return true;
+            configJson = json::parse(file);
         }
         catch (const std::exception &e)
         {
             LOG_ERROR("Failed to parse config file: {}", e.what());
-            setDefaults();
             return false;
         }
+
+        if (!configJson.is_object())
+        {
+            LOG_ERROR("Config file {} does not hold an object", m_configFilePath);
+            return false;
+        }
+
+        // Keys missing from the file fall back to their defaults
+        publish([&configJson](Values &next)
+                {
+                    for (auto &value : next.values)
+                    {
+                        value = std::monostate{};
+                    }
+                    setDefaults(next);
+                    for (auto it = configJson.begin(); it != configJson.end(); ++it)
+                    {
+                        next.values[next.slotOf(it.key())] = toValue(it.value());
+                    } });
+
+        LOG_INFO("Loaded configuration from {}", m_configFilePath);
+        return true;
     }
 
     bool Config::save()
     {
-        // Create directory if it doesn't exist
-        fs::create_directories(fs::path(m_configFilePath).parent_path());
+        auto values = snapshot();
 
-        // Create JSON object
-        json configJson;
-
-        // Add values to JSON
-        for (const auto &pair : m_configValues)
+        json configJson = json::object();
+        for (std::size_t i = 0; i < values->keys.size(); i++)
         {
-            try
+            if (!std::holds_alternative<std::monostate>(values->values[i]))
             {
-                configJson[pair.first] = json::parse(pair.second);
-            }
-            catch (const std::exception &)
-            {
-                // If parsing fails, store as string
-                configJson[pair.first] = pair.second;
+                configJson[values->keys[i]] = toJson(values->values[i]);
             }
         }
 
-        // Write to file
-        std::ofstream file(m_configFilePath);
-        if (!file.is_open())
+        // A watcher never sees a half-written file
+        if (!JsonHandler::saveToFileAtomic(m_configFilePath, configJson))
         {
-            LOG_ERROR("Failed to open config file for writing: {}", m_configFilePath);
+            LOG_ERROR("Failed to write config file: {}", m_configFilePath);
             return false;
         }
 
-        file << configJson.dump(4);
-        file.close();
-
         LOG_INFO("Saved configuration to {}", m_configFilePath);
         return true;
     }
 
-    std::string Config::getString(const std::string &key, const std::string &defaultValue) const
+    bool Config::watch()
     {
-        auto it = m_configValues.find(key);
-        if (it != m_configValues.end())
+        if (m_watchThread.joinable())
         {
-            try
-            {
-                return json::parse(it->second).get<std::string>();
-            }
-            catch (const std::exception &)
-            {
-                // If parsing fails, return the raw value
-                return it->second;
-            }
+            return true;
         }
-        return defaultValue;
+
+        // Watch the directory: editors often replace the file rather than write it
+        fs::path directory = fs::path(m_configFilePath).parent_path();
+        if (directory.empty())
+        {
+            directory = ".";
+        }
+        fs::create_directories(directory);
+
+        m_inotifyFd = inotify_init1(IN_CLOEXEC);
+        if (m_inotifyFd < 0)
+        {
+            LOG_ERROR("Failed to create inotify instance: {}", std::strerror(errno));
+            return false;
+        }
+        if (inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            LOG_ERROR("Failed to watch {}: {}", directory.string(), std::strerror(errno));
+            close(m_inotifyFd);
+            m_inotifyFd = -1;
+            return false;
+        }
+
+        m_wakeFd = eventfd(0, EFD_CLOEXEC);
+        if (m_wakeFd < 0)
+        {
+            LOG_ERROR("Failed to create eventfd: {}", std::strerror(errno));
+            close(m_inotifyFd);
+            m_inotifyFd = -1;
+            return false;
+        }
+
+        m_watchThread = std::thread(&Config::watchLoop, this);
+        LOG_INFO("Watching {} for changes", m_configFilePath);
+        return true;
     }
 
-    int Config::getInt(const std::string &key, int defaultValue) const
+    void Config::stopWatching()
     {
-        auto it = m_configValues.find(key);
-        if (it != m_configValues.end())
+        if (!m_watchThread.joinable())
         {
-            try
-            {
-                return json::parse(it->second).get<int>();
-            }
-            catch (const std::exception &)
-            {
-                return defaultValue;
-            }
+            return;
         }
-        return defaultValue;
+
+        uint64_t one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0)
+        {
+            LOG_ERROR("Failed to wake config watcher: {}", std::strerror(errno));
+        }
+        m_watchThread.join();
+
+        close(m_inotifyFd);
+        close(m_wakeFd);
+        m_inotifyFd = -1;
+        m_wakeFd = -1;
     }
 
-    double Config::getDouble(const std::string &key, double defaultValue) const
+    void Config::watchLoop()
     {
-        auto it = m_configValues.find(key);
-        if (it != m_configValues.end())
+        const std::string fileName = fs::path(m_configFilePath).filename().string();
+        alignas(inotify_event) char buffer[4096];
+        pollfd fds[2] = {{m_inotifyFd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+
+        while (true)
         {
-            try
+            if (poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                LOG_ERROR("Config watcher stopped: {}", std::strerror(errno));
+                return;
+            }
+            if (fds[1].revents & POLLIN)
+            {
+                return;
+            }
+
+            ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+            bool changed = false;
+            for (ssize_t offset = 0; offset < length;)
             {
-                return json::parse(it->second).get<double>();
+                const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                changed |= event->len > 0 && fileName == event->name;
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
             }
-            catch (const std::exception &)
+
+            if (changed)
             {
-                return defaultValue;
+                LOG_INFO("Config file changed, reloading");
+                load();
             }
         }
-        return defaultValue;
     }
 
-    bool Config::getBool(const std::string &key, bool defaultValue) const
+    std::shared_ptr<const Config::Values> Config::snapshot() const
+    {
+        return std::atomic_load(&m_values);
+    }
+
+    std::size_t Config::slotOf(const std::string &key)
     {
-        auto it = m_configValues.find(key);
-        if (it != m_configValues.end())
+        auto values = snapshot();
+        auto it = values->slots.find(key);
+        if (it != values->slots.end())
         {
-            try
+            return it->second;
+        }
+
+        // An empty slot changes nothing a subscriber could see
+        std::size_t slot = 0;
+        publish([&key, &slot](Values &next)
+                { slot = next.slotOf(key); });
+        return slot;
+    }
+
+    void Config::publish(const std::function<void(Values &next)> &change)
+    {
+        std::vector<std::string> changedKeys;
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            auto current = snapshot();
+            auto next = std::make_shared<Values>(*current);
+            change(*next);
+
+            for (std::size_t i = 0; i < next->values.size(); i++)
             {
-                return json::parse(it->second).get<bool>();
+                bool wasSet = i < current->values.size();
+                if (wasSet ? next->values[i] != current->values[i]
+                           : !std::holds_alternative<std::monostate>(next->values[i]))
+                {
+                    changedKeys.push_back(next->keys[i]);
+                }
             }
-            catch (const std::exception &)
+            std::atomic_store(&m_values, std::shared_ptr<const Values>(std::move(next)));
+        }
+        notify(changedKeys);
+    }
+
+    void Config::notify(const std::vector<std::string> &changedKeys)
+    {
+        if (changedKeys.empty())
+        {
+            return;
+        }
+
+        // Held through the callbacks, so unsubscribe waits for a running one
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        for (const auto &subscription : m_subscribers)
+        {
+            bool matches = std::any_of(changedKeys.begin(), changedKeys.end(), [&subscription](const std::string &key)
+                                       { return key.compare(0, subscription.prefix.size(), subscription.prefix) == 0; });
+            if (matches)
             {
-                return defaultValue;
+                subscription.callback(*this);
             }
         }
-        return defaultValue;
+    }
+
+    std::size_t Config::subscribe(const std::string &prefix, Callback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        std::size_t id = m_nextSubscriberId++;
+        m_subscribers.push_back({id, prefix, std::move(callback)});
+        return id;
+    }
+
+    void Config::unsubscribe(std::size_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(), [id](const Subscription &subscription)
+                                           { return subscription.id == id; }),
+                            m_subscribers.end());
+    }
+
+    template <typename T>
+    T Config::get(const std::string &key, const T &defaultValue) const
+    {
+        auto values = snapshot();
+        auto it = values->slots.find(key);
+        return it == values->slots.end() ? defaultValue : as(values->values[it->second], defaultValue);
+    }
+
+    std::string Config::getString(const std::string &key, const std::string &defaultValue) const
+    {
+        return get(key, defaultValue);
+    }
+
+    int Config::getInt(const std::string &key, int defaultValue) const
+    {
+        return get(key, defaultValue);
+    }
+
+    double Config::getDouble(const std::string &key, double defaultValue) const
+    {
+        return get(key, defaultValue);
+    }
+
+    bool Config::getBool(const std::string &key, bool defaultValue) const
+    {
+        return get(key, defaultValue);
+    }
+
+    void Config::set(const std::string &key, Value value)
+    {
+        publish([&key, &value](Values &next)
+                { next.values[next.slotOf(key)] = std::move(value); });
     }
 
     void Config::setString(const std::string &key, const std::string &value)
     {
-        m_configValues[key] = json(value).dump();
+        set(key, value);
     }
 
     void Config::setInt(const std::string &key, int value)
     {
-        m_configValues[key] = json(value).dump();
+        set(key, int64_t{value});
     }
 
     void Config::setDouble(const std::string &key, double value)
     {
-        m_configValues[key] = json(value).dump();
+        set(key, value);
     }
 
     void Config::setBool(const std::string &key, bool value)
     {
-        m_configValues[key] = json(value).dump();
+        set(key, value);
+    }
+
+    bool Config::as(const Value &value, bool defaultValue)
+    {
+        const bool *b = std::get_if<bool>(&value);
+        return b ? *b : defaultValue;
+    }
+
+    int Config::as(const Value &value, int defaultValue)
+    {
+        if (const int64_t *i = std::get_if<int64_t>(&value))
+        {
+            return static_cast<int>(*i);
+        }
+        if (const double *d = std::get_if<double>(&value))
+        {
+            return static_cast<int>(*d);
+        }
+        return defaultValue;
+    }
+
+    double Config::as(const Value &value, double defaultValue)
+    {
+        if (const double *d = std::get_if<double>(&value))
+        {
+            return *d;
+        }
+        if (const int64_t *i = std::get_if<int64_t>(&value))
+        {
+            return static_cast<double>(*i);
+        }
+        return defaultValue;
     }
 
-    void Config::setDefaults()
+    std::string Config::as(const Value &value, const std::string &defaultValue)
     {
+        if (const std::string *s = std::get_if<std::string>(&value))
+        {
+            return *s;
+        }
+        // Anything else reads back as its JSON text
+        return std::holds_alternative<std::monostate>(value) ? defaultValue : toJson(value).dump();
+    }
+
+    void Config::setDefaults(Values &values)
+    {
+        auto set = [&values](const std::string &key, Value value)
+        {
+            values.values[values.slotOf(key)] = std::move(value);
+        };
+
         // Set default configuration values
-        setString("user.name", "Wee Hung");
-        setString("ai.name", "Tarius");
-        setBool("ai.proactive_reminders", true);
-        setInt("memory.max_recent_messages", 10);
-        setInt("memory.summarize_after_days", 1);
+        set("user.name", std::string("Wee Hung"));
+        set("ai.name", std::string("Tarius"));
+        set("ai.proactive_reminders", true);
+        set("log.console_level", std::string("info"));
+        set("log.overflow", std::string("block"));
+        set("model.path", std::string("./models/Dolphin3.0-Llama3.2-1B-Q4_K_M.gguf"));
+        set("model.context_size", int64_t{2048});
+        set("model.parallel", int64_t{1});
+        set("model.threads", int64_t{4});
+        set("model.n_predict", int64_t{256});
+        set("model.temperature", 0.0); // Greedy
+        set("model.top_k", int64_t{40});
+        set("model.top_p", 0.9);
+        set("server.port", int64_t{8765});
+        set("server.socket", std::string(""));
+        set("server.workers", int64_t{2});
+        set("sessions.max_open", int64_t{16});
+        set("memory.max_recent_messages", int64_t{10});
+        set("memory.summarize_after_days", int64_t{1});
+        set("memory.compact_after_days", int64_t{7});
+        set("memory.raw_retention_days", int64_t{365});
+        set("memory.compress_cold_segments", true);
     }
 
-} // namespace tarius::utils
\ No newline at end of file
+} // namespace tarius::utils
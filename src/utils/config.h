@@ -1,21 +1,82 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
-// Add any other necessary includes
+#include <variant>
+#include <vector>
 
 namespace tarius::utils
 {
 
+    /**
+     * @brief Settings from data/config.json, parsed once into typed values.
+     *
+     * Values live in an immutable snapshot that is swapped whole on every
+     * change, so readers never wait for a writer or see a half-applied
+     * reload. A Handle resolves its key once and afterwards reads by
+     * index, which is what hot paths should hold on to.
+     *
+     * Subscribers are called after a change to any key under their prefix
+     * becomes visible. With watch(), edits to the file are picked up through
+     * inotify; a file that fails to parse is reported and the current values
+     * stay in place.
+     */
     class Config
     {
     public:
-        Config();
+        using Value = std::variant<std::monostate, bool, int64_t, double, std::string>;
+        using Callback = std::function<void(const Config &config)>;
+
+        // Reads one setting, falling back to a default while it is unset or
+        // of another type. Must not outlive the Config.
+        template <typename T>
+        class Handle
+        {
+        public:
+            Handle() = default;
+
+            T get() const
+            {
+                if (!m_config)
+                {
+                    return m_default;
+                }
+                return Config::as(m_config->snapshot()->values[m_slot], m_default);
+            }
+
+        private:
+            friend class Config;
+
+            Handle(const Config *config, std::size_t slot, T defaultValue)
+                : m_config(config), m_slot(slot), m_default(std::move(defaultValue))
+            {
+            }
+
+            const Config *m_config = nullptr;
+            std::size_t m_slot = 0;
+            T m_default{};
+        };
+
+        explicit Config(const std::string &configFilePath = "data/config.json");
         ~Config();
 
+        Config(const Config &) = delete;
+        Config &operator=(const Config &) = delete;
+
+        // Defaults overlaid with the file; on failure the current values stay
         bool load();
         bool save();
 
+        // Reload whenever the file changes, from a background thread
+        bool watch();
+        void stopWatching();
+
         // Getters
         std::string getString(const std::string &key, const std::string &defaultValue = "") const;
         int getInt(const std::string &key, int defaultValue = 0) const;
@@ -28,11 +89,71 @@ namespace tarius::utils
         void setDouble(const std::string &key, double value);
         void setBool(const std::string &key, bool value);
 
+        template <typename T>
+        Handle<T> handle(const std::string &key, T defaultValue)
+        {
+            return Handle<T>(this, slotOf(key), std::move(defaultValue));
+        }
+
+        Handle<std::string> handle(const std::string &key, const char *defaultValue)
+        {
+            return handle(key, std::string(defaultValue));
+        }
+
+        // Callbacks run on the thread that made the change, one call per
+        // change however many keys it touched. They may read the config but
+        // must not change it or the subscriptions.
+        std::size_t subscribe(const std::string &prefix, Callback callback);
+        void unsubscribe(std::size_t id);
+
     private:
+        // Keys get a slot the first time they are set or asked for and keep
+        // it, so a Handle's index stays valid across reloads
+        struct Values
+        {
+            std::unordered_map<std::string, std::size_t> slots;
+            std::vector<std::string> keys;
+            std::vector<Value> values;
+
+            std::size_t slotOf(const std::string &key);
+        };
+
+        struct Subscription
+        {
+            std::size_t id;
+            std::string prefix;
+            Callback callback;
+        };
+
         std::string m_configFilePath;
-        std::unordered_map<std::string, std::string> m_configValues;
 
-        void setDefaults();
+        std::shared_ptr<const Values> m_values;
+        std::mutex m_writeMutex; // Serializes writers, never taken by readers
+
+        std::mutex m_subscriberMutex;
+        std::vector<Subscription> m_subscribers;
+        std::size_t m_nextSubscriberId;
+
+        std::thread m_watchThread;
+        int m_inotifyFd;
+        int m_wakeFd;
+
+        std::shared_ptr<const Values> snapshot() const;
+        std::size_t slotOf(const std::string &key);
+        template <typename T>
+        T get(const std::string &key, const T &defaultValue) const;
+        void set(const std::string &key, Value value);
+        // Swap in next and tell subscribers which keys changed; takes the lock
+        void publish(const std::function<void(Values &next)> &change);
+        void notify(const std::vector<std::string> &changedKeys);
+        void watchLoop();
+
+        static void setDefaults(Values &values);
+
+        static bool as(const Value &value, bool defaultValue);
+        static int as(const Value &value, int defaultValue);
+        static double as(const Value &value, double defaultValue);
+        static std::string as(const Value &value, const std::string &defaultValue);
     };
 
-} // namespace tarius::utils
\ No newline at end of file
+} // namespace tarius::utils
@@ -0,0 +1,48 @@
+#include "file_lock.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace tarius::utils
+{
+
+    FileLock::FileLock(const std::string &path, Mode mode)
+        : m_fd(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+    {
+        if (m_fd < 0)
+        {
+            LOG_ERROR("Failed to open lock file {}: {}", path, std::strerror(errno));
+            return;
+        }
+
+        int operation = mode == Mode::Exclusive ? LOCK_EX : LOCK_SH;
+        while (::flock(m_fd, operation) != 0)
+        {
+            if (errno != EINTR)
+            {
+                LOG_ERROR("Failed to lock {}: {}", path, std::strerror(errno));
+                ::close(m_fd);
+                m_fd = -1;
+                return;
+            }
+        }
+    }
+
+    FileLock::~FileLock()
+    {
+        if (m_fd >= 0)
+        {
+            // Closing the descriptor releases the lock
+            ::close(m_fd);
+        }
+    }
+
+    std::string FileLock::forDirectory(const std::string &directory)
+    {
+        return directory + "/.lock";
+    }
+
+} // namespace tarius::utils
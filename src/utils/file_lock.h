@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+namespace tarius::utils
+{
+
+    // Advisory lock on a file, held for the lifetime of the object. Several
+    // Tarius processes can share one data directory; writers hold an
+    // exclusive lock and readers a shared one. Locks are per object, so a
+    // thread must not take a second lock on the same file while holding one.
+    class FileLock
+    {
+    public:
+        enum class Mode
+        {
+            Shared,
+            Exclusive
+        };
+
+        // Blocks until the lock is granted; the file is created if missing
+        FileLock(const std::string &path, Mode mode);
+        ~FileLock();
+
+        FileLock(const FileLock &) = delete;
+        FileLock &operator=(const FileLock &) = delete;
+
+        bool isLocked() const { return m_fd >= 0; }
+
+        // The lock file guarding a directory
+        static std::string forDirectory(const std::string &directory);
+
+    private:
+        int m_fd;
+    };
+
+} // namespace tarius::utils
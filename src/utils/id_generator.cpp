@@ -0,0 +1,87 @@
+#include "id_generator.h"
+#include "time_utils.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+
+namespace tarius::utils
+{
+    namespace
+    {
+        // Crockford base32, lowercase so ids stay distinct on case-insensitive file systems
+        constexpr char kAlphabet[] = "0123456789abcdefghjkmnpqrstvwxyz";
+        constexpr int kSequenceDigits = 3;
+        constexpr int kNodeDigits = 4;
+        constexpr uint32_t kSequenceLimit = 1u << (5 * kSequenceDigits);
+
+        void appendBase32(std::string &out, uint32_t value, int digits)
+        {
+            for (int shift = 5 * (digits - 1); shift >= 0; shift -= 5)
+            {
+                out.push_back(kAlphabet[(value >> shift) & 31]);
+            }
+        }
+
+        struct State
+        {
+            std::mutex mutex;
+            int64_t lastMillis = 0;
+            uint32_t sequence = 0;
+            uint32_t node = std::random_device{}() & ((1u << (5 * kNodeDigits)) - 1);
+        };
+
+        State &state()
+        {
+            static State instance;
+            return instance;
+        }
+    } // namespace
+
+    std::string IdGenerator::next(const std::string &prefix)
+    {
+        int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+
+        uint32_t sequence;
+        uint32_t node;
+        {
+            State &s = state();
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            if (millis <= s.lastMillis)
+            {
+                // Same millisecond, or the clock went back: stay on the last
+                // timestamp and count up, borrowing the next millisecond if full
+                millis = s.lastMillis;
+                if (++s.sequence == kSequenceLimit)
+                {
+                    millis++;
+                    s.sequence = 0;
+                }
+            }
+            else
+            {
+                s.sequence = 0;
+            }
+            s.lastMillis = millis;
+            sequence = s.sequence;
+            node = s.node;
+        }
+
+        CivilTime civil = TimeZone::local().toCivil(
+            std::chrono::system_clock::time_point(std::chrono::milliseconds(millis)));
+
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), "%04d%02d%02d_%02d%02d%02d_%03d_", civil.year, civil.month, civil.day,
+                      civil.hour, civil.minute, civil.second, static_cast<int>(millis % 1000));
+
+        std::string id = prefix + "_" + stamp;
+        appendBase32(id, sequence, kSequenceDigits);
+        appendBase32(id, node, kNodeDigits);
+        return id;
+    }
+
+} // namespace tarius::utils
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+namespace tarius::utils
+{
+
+    // Unique, time-ordered ids of the form
+    //   <prefix>_YYYYMMDD_HHMMSS_mmm_<sequence><node>
+    // The readable local timestamp keeps the date derivable from the id and
+    // makes ids sort chronologically, including against older second-
+    // resolution ids, which are a prefix of the new form. The sequence keeps
+    // ids from one process strictly increasing even within a millisecond or
+    // when the clock steps back; the random per-process node keeps ids from
+    // different processes apart.
+    class IdGenerator
+    {
+    public:
+        static std::string next(const std::string &prefix);
+    };
+
+} // namespace tarius::utils
@@ -1,12 +1,35 @@
 #include "json_handler.h"
 #include "logger.h"
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
 namespace tarius::utils
 {
+    namespace
+    {
+        // Push a file's contents, or a directory's entries, out to the disk
+        bool syncToDisk(const std::string &path, int flags = 0)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | flags);
+            if (fd < 0 || fsync(fd) != 0)
+            {
+                LOG_ERROR("Failed to sync {}: {}", path, std::strerror(errno));
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                return false;
+            }
+            close(fd);
+            return true;
+        }
+    } // namespace
 
     bool JsonHandler::saveToFile(const std::string &filePath, const nlohmann::json &data)
     {
@@ -27,6 +50,48 @@ namespace tarius::utils
         return true;
     }
 
+    bool JsonHandler::saveToFileAtomic(const std::string &filePath, const nlohmann::json &data)
+    {
+        fs::create_directories(fs::path(filePath).parent_path());
+
+        std::string tmpPath = filePath + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file.is_open())
+            {
+                LOG_ERROR("Failed to open file for writing: {}", tmpPath);
+                return false;
+            }
+
+            file << data.dump(4);
+            if (!file.flush())
+            {
+                LOG_ERROR("Failed to write file: {}", tmpPath);
+                return false;
+            }
+        }
+
+        // The contents must be on disk before the rename is, or a power cut
+        // could leave the new name pointing at an empty file
+        if (!syncToDisk(tmpPath))
+        {
+            return false;
+        }
+
+        std::error_code ec;
+        fs::rename(tmpPath, filePath, ec);
+        if (ec)
+        {
+            LOG_ERROR("Failed to replace {}: {}", filePath, ec.message());
+            return false;
+        }
+
+        // And the rename itself lives in the directory
+        std::string directory = fs::path(filePath).parent_path().string();
+        syncToDisk(directory.empty() ? "." : directory, O_DIRECTORY);
+        return true;
+    }
+
     bool JsonHandler::loadFromFile(const std::string &filePath, nlohmann::json &data)
     {
         // Check if file exists
@@ -10,6 +10,11 @@ namespace tarius::utils
     {
     public:
         static bool saveToFile(const std::string &filePath, const nlohmann::json &data);
+
+        // Write to a temporary file, sync it and rename it over filePath, so
+        // readers, crashes and power loss only ever see the old or the new
+        // contents. Returns once the new contents are on disk.
+        static bool saveToFileAtomic(const std::string &filePath, const nlohmann::json &data);
         static bool loadFromFile(const std::string &filePath, nlohmann::json &data);
     };
 
@@ -0,0 +1,90 @@
+#include "log_queue.h"
+
+namespace tarius::utils
+{
+    namespace
+    {
+        // Slots reserve this much text up front so ordinary lines never allocate
+        constexpr std::size_t kReservedText = 256;
+    } // namespace
+
+    LogQueue::LogQueue(std::size_t capacity)
+        : m_writePos(0), m_readPos(0)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        m_slots = std::make_unique<Slot[]>(size);
+        m_mask = size - 1;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            m_slots[i].record.text.reserve(kReservedText);
+        }
+    }
+
+    bool LogQueue::tryPush(spdlog::level::level_enum level, std::string_view text)
+    {
+        uint64_t pos = m_writePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true)
+        {
+            slot = &m_slots[pos & m_mask];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            int64_t lag = static_cast<int64_t>(sequence - pos);
+            if (lag == 0)
+            {
+                // The slot is free for this position; claim it
+                if (m_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (lag < 0)
+            {
+                // Still holds the record from one lap ago
+                return false;
+            }
+            else
+            {
+                // Another producer took this position
+                pos = m_writePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->record.level = level;
+        slot->record.time = spdlog::log_clock::now();
+        slot->record.text.assign(text.data(), text.size());
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool LogQueue::tryPop(Record &record)
+    {
+        uint64_t pos = m_readPos.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[pos & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            return false;
+        }
+
+        record.level = slot.record.level;
+        record.time = slot.record.time;
+        record.text.swap(slot.record.text);
+
+        // Hand the slot to the producer one lap ahead
+        slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_readPos.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool LogQueue::empty() const
+    {
+        uint64_t pos = m_readPos.load(std::memory_order_relaxed);
+        return m_slots[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+} // namespace tarius::utils
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <spdlog/common.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace tarius::utils
+{
+    /**
+     * @brief Bounded lock-free queue of formatted log records, many
+     * producers to one consumer.
+     *
+     * Each slot carries a sequence number telling producers and the consumer
+     * whose turn it is (Vyukov's bounded queue), so a push is one CAS on the
+     * write position plus a copy into the slot's string, whose capacity is
+     * kept between uses. Records come out in the order their positions were
+     * claimed.
+     */
+    class LogQueue
+    {
+    public:
+        struct Record
+        {
+            spdlog::level::level_enum level = spdlog::level::info;
+            spdlog::log_clock::time_point time;
+            std::string text;
+        };
+
+        // Capacity is rounded up to a power of two
+        explicit LogQueue(std::size_t capacity);
+
+        // false when the queue is full
+        bool tryPush(spdlog::level::level_enum level, std::string_view text);
+
+        // Consumer only. Swaps the text into record, so its buffer is reused.
+        bool tryPop(Record &record);
+
+        bool empty() const;
+
+        // Positions claimed so far; a consumer that has popped this many is
+        // caught up with every push that returned before the call
+        uint64_t pushed() const { return m_writePos.load(std::memory_order_acquire); }
+        uint64_t popped() const { return m_readPos.load(std::memory_order_acquire); }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence;
+            Record record;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::size_t m_mask;
+
+        alignas(64) std::atomic<uint64_t> m_writePos;
+        alignas(64) std::atomic<uint64_t> m_readPos;
+    };
+
+} // namespace tarius::utils
@@ -1,15 +1,140 @@
 #include "logger.h"
+#include "log_queue.h"
+#include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace fs = std::filesystem;
 
 namespace tarius::utils
 {
+    namespace
+    {
+        constexpr std::size_t kQueueCapacity = 8192;
+
+        // The writer sleeps this long at most when idle, in case a wakeup is missed
+        constexpr std::chrono::milliseconds kIdleWait(100);
+
+        // Times the writer yields waiting for more records before it sleeps,
+        // so a burst of messages doesn't pay for a wakeup every few lines
+        constexpr int kIdleSpins = 64;
+
+        struct AsyncBackend
+        {
+            LogQueue queue{kQueueCapacity};
+            std::shared_ptr<spdlog::logger> logger; // Single-threaded sinks; only the writer uses it while running
+
+            std::atomic<bool> running{false};
+            std::atomic<bool> stopping{false};
+            std::atomic<bool> sleeping{false};
+            std::atomic<Logger::OverflowPolicy> policy{Logger::OverflowPolicy::Block};
+            std::atomic<uint64_t> dropped{0};
+            std::atomic<uint64_t> written{0}; // Queue positions written and flushed
+
+            std::mutex wakeMutex;
+            std::condition_variable wakeCv;
+            std::thread writer;
+
+            // Serializes synchronous writes once the writer has stopped
+            std::mutex directMutex;
+
+            void wake()
+            {
+                // Pairs with the fence in writerLoop: either the writer sees
+                // the new record, or this sees it asleep
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (sleeping.load(std::memory_order_relaxed))
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                    wakeCv.notify_one();
+                }
+            }
+
+            void writeRecord(const LogQueue::Record &record)
+            {
+                logger->log(record.time, spdlog::source_loc{}, record.level,
+                            spdlog::string_view_t(record.text.data(), record.text.size()));
+            }
+
+            // Write out everything queued; true if there was anything
+            bool drain(LogQueue::Record &record)
+            {
+                bool any = false;
+                while (queue.tryPop(record))
+                {
+                    writeRecord(record);
+                    any = true;
+                }
+                if (uint64_t lost = dropped.exchange(0, std::memory_order_relaxed))
+                {
+                    logger->warn("Dropped {} log messages while the log queue was full", lost);
+                    any = true;
+                }
+                if (any)
+                {
+                    logger->flush();
+                }
+                written.store(queue.popped(), std::memory_order_release);
+                return any;
+            }
+
+            bool spinUntilQueued()
+            {
+                for (int i = 0; i < kIdleSpins; i++)
+                {
+                    if (!queue.empty())
+                    {
+                        return true;
+                    }
+                    std::this_thread::yield();
+                }
+                return false;
+            }
+
+            void writerLoop()
+            {
+                LogQueue::Record record;
+                while (true)
+                {
+                    if (drain(record))
+                    {
+                        continue;
+                    }
+                    if (stopping.load(std::memory_order_acquire))
+                    {
+                        break;
+                    }
+                    if (spinUntilQueued())
+                    {
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(wakeMutex);
+                    sleeping.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (queue.empty() && !stopping.load(std::memory_order_acquire))
+                    {
+                        wakeCv.wait_for(lock, kIdleWait);
+                    }
+                    sleeping.store(false, std::memory_order_relaxed);
+                }
+                drain(record);
+            }
+        };
+
+        // Never freed, so threads still logging at exit keep a valid target
+        std::atomic<AsyncBackend *> g_backend{nullptr};
+    } // namespace
+
     bool Logger::s_initialized = false;
-    std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> Logger::s_console_sink = nullptr;
+    spdlog::sink_ptr Logger::s_console_sink = nullptr;
 
     void Logger::init(bool console_debug_output)
     {
@@ -23,8 +148,8 @@ namespace tarius::utils
             // Create logs directory if it doesn't exist
             fs::create_directories("logs");
 
-            // Create console sink
-            s_console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            // Create console sink; only the writer thread uses the sinks
+            s_console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_st>();
 
             // Set the initial console level based on the debug flag
             if (console_debug_output)
@@ -39,21 +164,21 @@ namespace tarius::utils
             s_console_sink->set_pattern("[%^%l%$] %v");
 
             // Create file sink (10MB max size, 3 rotated files)
-            auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+            auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_st>(
                 "logs/tarius.log", 1024 * 1024 * 10, 3);
             file_sink->set_level(spdlog::level::trace);
             file_sink->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
 
-            // Create logger with both sinks
-            auto logger = std::make_shared<spdlog::logger>("tarius", spdlog::sinks_init_list{s_console_sink, file_sink});
-            logger->set_level(spdlog::level::trace);
-            spdlog::set_default_logger(logger);
-
-#ifndef TARIUS_DISABLE_DEBUG_LOGS
-            spdlog::info("Logger initialized");
-#endif
+            // Create logger with both sinks, fed by the writer thread
+            auto *backend = new AsyncBackend();
+            backend->logger = std::make_shared<spdlog::logger>("tarius", spdlog::sinks_init_list{s_console_sink, file_sink});
+            backend->logger->set_level(spdlog::level::trace);
+            backend->running.store(true, std::memory_order_release);
+            backend->writer = std::thread(&AsyncBackend::writerLoop, backend);
+            g_backend.store(backend, std::memory_order_release);
 
             s_initialized = true;
+            LOG_INFO("Logger initialized");
         }
         catch (const spdlog::spdlog_ex &ex)
         {
@@ -69,14 +194,83 @@ namespace tarius::utils
         }
     }
 
+    void Logger::setOverflowPolicy(OverflowPolicy policy)
+    {
+        if (AsyncBackend *backend = g_backend.load(std::memory_order_acquire))
+        {
+            backend->policy.store(policy, std::memory_order_relaxed);
+        }
+    }
+
+    void Logger::flush()
+    {
+        AsyncBackend *backend = g_backend.load(std::memory_order_acquire);
+        if (!backend || !backend->running.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        uint64_t target = backend->queue.pushed();
+        while (backend->written.load(std::memory_order_acquire) < target &&
+               backend->running.load(std::memory_order_acquire))
+        {
+            backend->wake();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
     void Logger::shutdown()
     {
-        if (s_initialized)
+        if (!s_initialized)
+        {
+            return;
+        }
+
+        // Drain and stop the writer; later messages are written directly. A
+        // message racing this can still land in the queue after the last
+        // drain and be lost.
+        AsyncBackend *backend = g_backend.load(std::memory_order_acquire);
         {
-            spdlog::shutdown();
-            s_initialized = false;
-            s_console_sink = nullptr;
+            std::lock_guard<std::mutex> lock(backend->directMutex);
+            backend->stopping.store(true, std::memory_order_release);
+            backend->wake();
+            backend->writer.join();
+            backend->running.store(false, std::memory_order_release);
+
+            LogQueue::Record record;
+            backend->drain(record);
+        }
+        s_initialized = false;
+    }
+
+    void Logger::write(spdlog::level::level_enum level, std::string_view text)
+    {
+        AsyncBackend *backend = g_backend.load(std::memory_order_acquire);
+        if (!backend)
+        {
+            spdlog::log(level, "{}", text);
+            return;
         }
+
+        while (backend->running.load(std::memory_order_acquire))
+        {
+            if (backend->queue.tryPush(level, text))
+            {
+                backend->wake();
+                return;
+            }
+            if (backend->policy.load(std::memory_order_relaxed) == OverflowPolicy::Drop)
+            {
+                backend->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            backend->wake();
+            std::this_thread::yield();
+        }
+
+        std::lock_guard<std::mutex> lock(backend->directMutex);
+        backend->logger->log(level, spdlog::string_view_t(text.data(), text.size()));
+        backend->logger->flush();
     }
 
-} // namespace tarius::utils
\ No newline at end of file
+} // namespace tarius::utils
@@ -1,28 +1,63 @@
 #pragma once
 
 #include <string>
-#include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
+#include <string_view>
+#include <iterator>
+#include <spdlog/common.h>
+#include <spdlog/fmt/fmt.h>
 
-// Debug logging macros that can be disabled
-#ifdef TARIUS_DISABLE_DEBUG_LOGS
-// No-op macros when debug logs are disabled
-#define LOG_TRACE(...) (void)0
-#define LOG_DEBUG(...) (void)0
-#define LOG_INFO(...) (void)0
+// Levels compiled in: calls below TARIUS_LOG_LEVEL vanish along with the
+// formatting of their arguments
+#define TARIUS_LOG_LEVEL_TRACE 0
+#define TARIUS_LOG_LEVEL_DEBUG 1
+#define TARIUS_LOG_LEVEL_INFO 2
+#define TARIUS_LOG_LEVEL_WARN 3
+#define TARIUS_LOG_LEVEL_ERROR 4
+#define TARIUS_LOG_LEVEL_CRITICAL 5
 
+#ifndef TARIUS_LOG_LEVEL
+#ifdef TARIUS_DISABLE_DEBUG_LOGS
 // Keep error reporting even in release mode
-#define LOG_WARN(...) tarius::utils::Logger::warn(__VA_ARGS__)
-#define LOG_ERROR(...) tarius::utils::Logger::error(__VA_ARGS__)
-#define LOG_CRITICAL(...) tarius::utils::Logger::critical(__VA_ARGS__)
+#define TARIUS_LOG_LEVEL TARIUS_LOG_LEVEL_WARN
 #else
-// Standard logging macros when debug is enabled
+#define TARIUS_LOG_LEVEL TARIUS_LOG_LEVEL_TRACE
+#endif
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_TRACE
 #define LOG_TRACE(...) tarius::utils::Logger::trace(__VA_ARGS__)
+#else
+#define LOG_TRACE(...) (void)0
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_DEBUG
 #define LOG_DEBUG(...) tarius::utils::Logger::debug(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) (void)0
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_INFO
 #define LOG_INFO(...) tarius::utils::Logger::info(__VA_ARGS__)
+#else
+#define LOG_INFO(...) (void)0
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_WARN
 #define LOG_WARN(...) tarius::utils::Logger::warn(__VA_ARGS__)
+#else
+#define LOG_WARN(...) (void)0
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_ERROR
 #define LOG_ERROR(...) tarius::utils::Logger::error(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) (void)0
+#endif
+
+#if TARIUS_LOG_LEVEL <= TARIUS_LOG_LEVEL_CRITICAL
 #define LOG_CRITICAL(...) tarius::utils::Logger::critical(__VA_ARGS__)
+#else
+#define LOG_CRITICAL(...) (void)0
 #endif
 
 // Define a no-op logger for llama.cpp
@@ -38,54 +73,95 @@
 
 namespace tarius::utils
 {
+    /**
+     * @brief Asynchronous front end to the console and rotating file sinks.
+     *
+     * A call formats its message on the calling thread and pushes it onto a
+     * lock-free queue; a dedicated thread writes queued records to the sinks
+     * and flushes the file whenever the queue runs dry. Nothing on the
+     * caller's side takes a lock or touches a file.
+     *
+     * Before init() and after shutdown() messages are written synchronously.
+     */
     class Logger
     {
     public:
+        // What a call does when the queue is full
+        enum class OverflowPolicy
+        {
+            Block, // Wait for the writer thread to make room
+            Drop   // Discard the message; the writer reports how many were lost
+        };
+
         static void init(bool console_debug_output = true);
         static void shutdown();
 
         // Set console output level dynamically
         static void setConsoleLevel(spdlog::level::level_enum level);
 
+        static void setOverflowPolicy(OverflowPolicy policy);
+
+        // Wait until everything logged so far has reached the sinks
+        static void flush();
+
         template <typename... Args>
-        static void trace(const char *fmt, const Args &...args)
+        static void trace(const char *format, const Args &...args)
         {
-            spdlog::trace(fmt, args...);
+            log(spdlog::level::trace, format, args...);
         }
 
         template <typename... Args>
-        static void debug(const char *fmt, const Args &...args)
+        static void debug(const char *format, const Args &...args)
         {
-            spdlog::debug(fmt, args...);
+            log(spdlog::level::debug, format, args...);
         }
 
         template <typename... Args>
-        static void info(const char *fmt, const Args &...args)
+        static void info(const char *format, const Args &...args)
         {
-            spdlog::info(fmt, args...);
+            log(spdlog::level::info, format, args...);
         }
 
         template <typename... Args>
-        static void warn(const char *fmt, const Args &...args)
+        static void warn(const char *format, const Args &...args)
         {
-            spdlog::warn(fmt, args...);
+            log(spdlog::level::warn, format, args...);
         }
 
         template <typename... Args>
-        static void error(const char *fmt, const Args &...args)
+        static void error(const char *format, const Args &...args)
         {
-            spdlog::error(fmt, args...);
+            log(spdlog::level::err, format, args...);
         }
 
         template <typename... Args>
-        static void critical(const char *fmt, const Args &...args)
+        static void critical(const char *format, const Args &...args)
         {
-            spdlog::critical(fmt, args...);
+            log(spdlog::level::critical, format, args...);
         }
 
     private:
+        template <typename... Args>
+        static void log(spdlog::level::level_enum level, const char *format, const Args &...args)
+        {
+            // Up to 500 characters format on the stack
+            fmt::memory_buffer buffer;
+            try
+            {
+                fmt::vformat_to(std::back_inserter(buffer), fmt::string_view(format), fmt::make_format_args(args...));
+            }
+            catch (const std::exception &e)
+            {
+                write(spdlog::level::err, std::string("Bad log format \"") + format + "\": " + e.what());
+                return;
+            }
+            write(level, std::string_view(buffer.data(), buffer.size()));
+        }
+
+        static void write(spdlog::level::level_enum level, std::string_view text);
+
         static bool s_initialized;
-        static std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> s_console_sink;
+        static spdlog::sink_ptr s_console_sink;
     };
 
-} // namespace tarius::utils
\ No newline at end of file
+} // namespace tarius::utils
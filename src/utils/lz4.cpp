@@ -0,0 +1,189 @@
+#include "lz4.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace tarius::utils
+{
+    namespace
+    {
+        constexpr std::size_t kMinMatch = 4;
+        constexpr std::size_t kLastLiterals = 5; // The block must end in at least this many literals
+        constexpr std::size_t kMatchFindLimit = 12; // No match may start this close to the end
+        constexpr std::size_t kMaxOffset = 65535;
+        constexpr int kHashBits = 12;
+        constexpr uint32_t kNoPosition = UINT32_MAX;
+
+        uint32_t read32(const char *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - kHashBits);
+        }
+
+        // Lengths of 15 and above spill into extra bytes of 255 plus a remainder
+        void writeLength(std::string &out, std::size_t length)
+        {
+            for (; length >= 255; length -= 255)
+            {
+                out.push_back(static_cast<char>(255));
+            }
+            out.push_back(static_cast<char>(length));
+        }
+
+        void writeSequence(std::string &out, const char *literals, std::size_t literalLength, std::size_t offset,
+                           std::size_t matchLength)
+        {
+            std::size_t matchCode = matchLength - kMinMatch;
+            out.push_back(static_cast<char>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                            (matchCode < 15 ? matchCode : 15)));
+            if (literalLength >= 15)
+            {
+                writeLength(out, literalLength - 15);
+            }
+            out.append(literals, literalLength);
+            out.push_back(static_cast<char>(offset & 0xff));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (matchCode >= 15)
+            {
+                writeLength(out, matchCode - 15);
+            }
+        }
+
+        void writeLastLiterals(std::string &out, const char *literals, std::size_t literalLength)
+        {
+            out.push_back(static_cast<char>((literalLength < 15 ? literalLength : 15) << 4));
+            if (literalLength >= 15)
+            {
+                writeLength(out, literalLength - 15);
+            }
+            out.append(literals, literalLength);
+        }
+
+        bool readLength(const unsigned char *&ip, const unsigned char *end, std::size_t &length)
+        {
+            unsigned char byte;
+            do
+            {
+                if (ip >= end)
+                {
+                    return false;
+                }
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+    } // namespace
+
+    std::string Lz4::compress(const std::string &input)
+    {
+        const char *src = input.data();
+        const std::size_t size = input.size();
+
+        std::string out;
+        out.reserve(size / 2 + 16);
+
+        std::size_t anchor = 0;
+        if (size > kMatchFindLimit)
+        {
+            std::vector<uint32_t> table(std::size_t{1} << kHashBits, kNoPosition);
+            const std::size_t matchLimit = size - kLastLiterals;
+
+            std::size_t ip = 0;
+            while (ip < size - kMatchFindLimit)
+            {
+                uint32_t sequence = read32(src + ip);
+                uint32_t &slot = table[hash(sequence)];
+                std::size_t candidate = slot;
+                slot = static_cast<uint32_t>(ip);
+
+                if (candidate == kNoPosition || ip - candidate > kMaxOffset || read32(src + candidate) != sequence)
+                {
+                    ip++;
+                    continue;
+                }
+
+                std::size_t length = kMinMatch;
+                while (ip + length < matchLimit && src[candidate + length] == src[ip + length])
+                {
+                    length++;
+                }
+
+                writeSequence(out, src + anchor, ip - anchor, ip - candidate, length);
+                ip += length;
+                anchor = ip;
+            }
+        }
+
+        writeLastLiterals(out, src + anchor, size - anchor);
+        return out;
+    }
+
+    bool Lz4::decompress(const std::string &input, std::size_t rawSize, std::string &output)
+    {
+        output.assign(rawSize, '\0');
+        const unsigned char *ip = reinterpret_cast<const unsigned char *>(input.data());
+        const unsigned char *const end = ip + input.size();
+        char *const base = output.data();
+        std::size_t op = 0;
+
+        while (ip < end)
+        {
+            unsigned char token = *ip++;
+
+            std::size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(ip, end, literalLength))
+            {
+                return false;
+            }
+            if (literalLength > static_cast<std::size_t>(end - ip) || literalLength > rawSize - op)
+            {
+                return false;
+            }
+            std::memcpy(base + op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            if (ip == end)
+            {
+                break; // The last sequence carries literals only
+            }
+
+            if (end - ip < 2)
+            {
+                return false;
+            }
+            std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+            ip += 2;
+
+            std::size_t matchLength = token & 0x0f;
+            if (matchLength == 15 && !readLength(ip, end, matchLength))
+            {
+                return false;
+            }
+            matchLength += kMinMatch;
+
+            if (offset == 0 || offset > op || matchLength > rawSize - op)
+            {
+                return false;
+            }
+
+            // Byte by byte: the match may overlap the bytes it produces
+            const char *match = base + op - offset;
+            for (std::size_t i = 0; i < matchLength; i++)
+            {
+                base[op + i] = match[i];
+            }
+            op += matchLength;
+        }
+
+        return op == rawSize;
+    }
+
+} // namespace tarius::utils
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace tarius::utils
+{
+
+    // Compressor for the LZ4 block format (no frame header, no checksums).
+    // Output is readable by any LZ4 block decoder given the raw size.
+    class Lz4
+    {
+    public:
+        static std::string compress(const std::string &input);
+
+        // rawSize must be the exact size of the original input
+        static bool decompress(const std::string &input, std::size_t rawSize, std::string &output);
+    };
+
+} // namespace tarius::utils
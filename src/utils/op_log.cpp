@@ -0,0 +1,130 @@
+#include "op_log.h"
+#include "json_handler.h"
+#include "logger.h"
+#include <filesystem>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace tarius::utils
+{
+    OpLog::OpLog(const std::string &snapshotPath, const std::string &logPath)
+        : m_snapshotPath(snapshotPath), m_logPath(logPath), m_seq(0), m_pendingOps(0)
+    {
+    }
+
+    bool OpLog::load(nlohmann::json &data, std::vector<nlohmann::json> &ops)
+    {
+        data = nullptr;
+        ops.clear();
+        m_log.close();
+
+        uint64_t snapshotSeq = 0;
+        if (fs::exists(m_snapshotPath))
+        {
+            nlohmann::json snapshot;
+            if (!JsonHandler::loadFromFile(m_snapshotPath, snapshot))
+            {
+                return false;
+            }
+
+            if (snapshot.is_object() && snapshot.contains("seq") && snapshot.contains("data"))
+            {
+                snapshotSeq = snapshot["seq"].get<uint64_t>();
+                data = std::move(snapshot["data"]);
+            }
+            else
+            {
+                data = std::move(snapshot);
+            }
+        }
+        m_seq = snapshotSeq;
+
+        std::ifstream file(m_logPath, std::ios::binary);
+        if (file.is_open())
+        {
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            file.close();
+            const std::string contents = buffer.str();
+
+            std::size_t pos = 0;
+            while (pos < contents.size())
+            {
+                std::size_t end = contents.find('\n', pos);
+                if (end == std::string::npos)
+                {
+                    // Torn by a crash mid-append; cut it off so the next
+                    // append starts on a fresh line
+                    LOG_WARN("Dropping incomplete record at the end of {}", m_logPath);
+                    std::error_code ec;
+                    fs::resize_file(m_logPath, pos, ec);
+                    break;
+                }
+
+                try
+                {
+                    nlohmann::json op = nlohmann::json::parse(contents.begin() + pos, contents.begin() + end);
+                    uint64_t seq = op.value("seq", uint64_t{0});
+                    if (seq > snapshotSeq)
+                    {
+                        m_seq = std::max(m_seq, seq);
+                        ops.push_back(std::move(op));
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    LOG_WARN("Skipping unreadable record in {}: {}", m_logPath, e.what());
+                }
+                pos = end + 1;
+            }
+        }
+
+        m_pendingOps = ops.size();
+        return true;
+    }
+
+    bool OpLog::append(nlohmann::json op)
+    {
+        if (!m_log.is_open())
+        {
+            fs::create_directories(fs::path(m_logPath).parent_path());
+            m_log.open(m_logPath, std::ios::binary | std::ios::app);
+            if (!m_log.is_open())
+            {
+                LOG_ERROR("Failed to open operation log: {}", m_logPath);
+                return false;
+            }
+        }
+
+        op["seq"] = ++m_seq;
+        m_log << op.dump() << '\n';
+        if (!m_log.flush())
+        {
+            LOG_ERROR("Failed to append to operation log: {}", m_logPath);
+            m_log.close();
+            return false;
+        }
+
+        m_pendingOps++;
+        return true;
+    }
+
+    bool OpLog::writeSnapshot(const nlohmann::json &data)
+    {
+        nlohmann::json snapshot;
+        snapshot["seq"] = m_seq;
+        snapshot["data"] = data;
+        if (!JsonHandler::saveToFileAtomic(m_snapshotPath, snapshot))
+        {
+            return false;
+        }
+
+        // Everything in the log is now covered by the snapshot
+        m_log.close();
+        m_log.open(m_logPath, std::ios::binary | std::ios::trunc);
+        m_pendingOps = 0;
+        return true;
+    }
+
+} // namespace tarius::utils
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace tarius::utils
+{
+    /**
+     * @brief Snapshot plus append-only operation log for a small JSON store.
+     *
+     * Each mutation is appended to the log as one JSON line with a sequence
+     * number, so it costs one short write however large the store is. Now and
+     * then the owner writes a full snapshot, which replaces the snapshot file
+     * atomically and empties the log. The snapshot records the last sequence
+     * number it includes, so operations left in the log by a crash between
+     * the two steps are not applied twice. A torn last line is ignored.
+     *
+     * Appends are flushed to the OS but not synced, which would cost a disk
+     * round trip per change: an operation survives the process crashing as
+     * soon as append() returns, but only survives power loss or an OS crash
+     * once a snapshot including it has been written, which is synced.
+     */
+    class OpLog
+    {
+    public:
+        OpLog(const std::string &snapshotPath, const std::string &logPath);
+
+        /**
+         * @brief Read the snapshot and the operations logged after it.
+         *
+         * A snapshot in the older format, the bare data without a sequence
+         * number, is accepted as it is.
+         *
+         * @param data The snapshot data, or null if there is no snapshot
+         * @param ops Logged operations not yet in the snapshot, oldest first
+         * @return false if the snapshot exists but cannot be read
+         */
+        bool load(nlohmann::json &data, std::vector<nlohmann::json> &ops);
+
+        // Append one operation and flush it to the OS
+        bool append(nlohmann::json op);
+
+        // Replace the snapshot with data, which must include every appended
+        // operation, and empty the log
+        bool writeSnapshot(const nlohmann::json &data);
+
+        // Operations appended since the last snapshot
+        std::size_t pendingOps() const { return m_pendingOps; }
+
+    private:
+        std::string m_snapshotPath;
+        std::string m_logPath;
+        std::ofstream m_log;
+        uint64_t m_seq;
+        std::size_t m_pendingOps;
+    };
+
+} // namespace tarius::utils
@@ -0,0 +1,337 @@
+#include "time_utils.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace tarius::utils
+{
+    namespace
+    {
+        constexpr int64_t kSecondsPerDay = 86400;
+
+        // Local offsets are cached per quarter hour of UTC time
+        constexpr int64_t kBucketSeconds = 900;
+        constexpr std::size_t kCacheSlots = 4096; // About six weeks of quarter hours
+        constexpr uint64_t kBucketBias = uint64_t{1} << 31;
+        constexpr int64_t kOffsetBias = int64_t{1} << 30; // Keeps every filled slot non-zero
+
+        // Each slot packs the biased bucket number above the biased offset,
+        // so a lookup is one relaxed load and no lock
+        std::array<std::atomic<uint64_t>, kCacheSlots> g_offsetCache = {};
+
+        const char *const kMonthNames[] = {"January", "February", "March", "April", "May", "June", "July",
+                                           "August", "September", "October", "November", "December"};
+
+        int64_t floorDiv(int64_t a, int64_t b)
+        {
+            return a / b - (a % b != 0 && (a < 0) != (b < 0));
+        }
+
+        int64_t toSeconds(const std::chrono::system_clock::time_point &time)
+        {
+            return std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count();
+        }
+
+        // Clamped to what the clock can hold, about 1677 to 2262 at nanosecond resolution
+        std::chrono::system_clock::time_point fromSeconds(int64_t seconds)
+        {
+            using std::chrono::duration_cast;
+            using std::chrono::system_clock;
+            const int64_t low = duration_cast<std::chrono::seconds>(system_clock::duration::min()).count() + 1;
+            const int64_t high = duration_cast<std::chrono::seconds>(system_clock::duration::max()).count() - 1;
+            return system_clock::time_point(std::chrono::seconds(std::clamp(seconds, low, high)));
+        }
+
+        int64_t localOffset(int64_t seconds)
+        {
+            const int64_t bucket = floorDiv(seconds, kBucketSeconds);
+            const uint64_t key = static_cast<uint64_t>(bucket) + kBucketBias;
+            auto &slot = g_offsetCache[static_cast<std::size_t>(key % kCacheSlots)];
+
+            uint64_t packed = slot.load(std::memory_order_relaxed);
+            if ((packed >> 32) == key)
+            {
+                return static_cast<int64_t>(packed & 0xffffffffu) - kOffsetBias;
+            }
+
+            std::time_t t = static_cast<std::time_t>(bucket * kBucketSeconds);
+            std::tm tm = {};
+            localtime_r(&t, &tm);
+            const int64_t offset = tm.tm_gmtoff;
+            slot.store((key << 32) | static_cast<uint64_t>(offset + kOffsetBias), std::memory_order_relaxed);
+            return offset;
+        }
+
+        // Two digits, or four, at out
+        void put2(char *out, int value)
+        {
+            out[0] = static_cast<char>('0' + value / 10);
+            out[1] = static_cast<char>('0' + value % 10);
+        }
+
+        void put4(char *out, int value)
+        {
+            put2(out, value / 100);
+            put2(out + 2, value % 100);
+        }
+
+        // Digits of text[pos, pos + n); bad collects any non-digit
+        int digits(std::string_view text, std::size_t pos, std::size_t n, unsigned &bad)
+        {
+            int value = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                unsigned d = static_cast<unsigned>(static_cast<unsigned char>(text[pos + i])) - '0';
+                bad |= d > 9;
+                value = value * 10 + static_cast<int>(d);
+            }
+            return value;
+        }
+
+        bool parseIsoDateFields(std::string_view text, int &year, int &month, int &day)
+        {
+            unsigned bad = 0;
+            year = digits(text, 0, 4, bad);
+            month = digits(text, 5, 2, bad);
+            day = digits(text, 8, 2, bad);
+            bad |= text[4] != '-';
+            bad |= text[7] != '-';
+            return !bad && year >= TimeUtils::kMinYear && year <= TimeUtils::kMaxYear && month >= 1 && month <= 12 &&
+                   day >= 1 &&
+                   day <= TimeUtils::daysFromCivil(month == 12 ? year + 1 : year, month % 12 + 1, 1) -
+                              TimeUtils::daysFromCivil(year, month, 1);
+        }
+    } // namespace
+
+    TimeZone::TimeZone(bool isLocal, std::chrono::seconds offset)
+        : m_local(isLocal), m_offset(offset)
+    {
+    }
+
+    const TimeZone &TimeZone::utc()
+    {
+        static const TimeZone zone(false, std::chrono::seconds(0));
+        return zone;
+    }
+
+    const TimeZone &TimeZone::local()
+    {
+        static const TimeZone zone(true, std::chrono::seconds(0));
+        return zone;
+    }
+
+    TimeZone TimeZone::fixed(std::chrono::minutes offset)
+    {
+        return TimeZone(false, offset);
+    }
+
+    std::chrono::seconds TimeZone::offsetAt(const std::chrono::system_clock::time_point &time) const
+    {
+        return m_local ? std::chrono::seconds(localOffset(toSeconds(time))) : m_offset;
+    }
+
+    CivilTime TimeZone::toCivil(const std::chrono::system_clock::time_point &time) const
+    {
+        int64_t utcSeconds = toSeconds(time);
+        int64_t seconds = utcSeconds + (m_local ? localOffset(utcSeconds) : m_offset.count());
+        int64_t days = floorDiv(seconds, kSecondsPerDay);
+        int secondOfDay = static_cast<int>(seconds - days * kSecondsPerDay);
+
+        CivilTime civil;
+        TimeUtils::civilFromDays(static_cast<int>(days), civil.year, civil.month, civil.day);
+        civil.hour = secondOfDay / 3600;
+        civil.minute = secondOfDay / 60 % 60;
+        civil.second = secondOfDay % 60;
+        return civil;
+    }
+
+    std::chrono::system_clock::time_point TimeZone::fromCivil(const CivilTime &civil) const
+    {
+        // Months carry into years; everything below is linear in days
+        int64_t monthIndex = static_cast<int64_t>(civil.year) * 12 + (civil.month - 1);
+        int year = static_cast<int>(floorDiv(monthIndex, 12));
+        int month = static_cast<int>(monthIndex - static_cast<int64_t>(year) * 12) + 1;
+        int64_t wallSeconds = static_cast<int64_t>(TimeUtils::daysFromCivil(year, month, 1) + civil.day - 1) * kSecondsPerDay +
+                              static_cast<int64_t>(civil.hour) * 3600 + static_cast<int64_t>(civil.minute) * 60 + civil.second;
+
+        if (!m_local)
+        {
+            return fromSeconds(wallSeconds - m_offset.count());
+        }
+
+        // Try the offsets from a day either side; at most one change falls between
+        int64_t before = localOffset(wallSeconds - kSecondsPerDay);
+        int64_t after = localOffset(wallSeconds + kSecondsPerDay);
+        int64_t early = wallSeconds - before;
+        int64_t late = wallSeconds - after;
+        bool earlyValid = localOffset(early) == before;
+        bool lateValid = localOffset(late) == after;
+
+        if (earlyValid && lateValid)
+        {
+            return fromSeconds(std::min(early, late));
+        }
+        if (lateValid)
+        {
+            return fromSeconds(late);
+        }
+        // Valid before the change, or skipped by it: the offset before it
+        // moves a skipped time forward
+        return fromSeconds(early);
+    }
+
+    int TimeUtils::daysFromCivil(int year, int month, int day)
+    {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const int yoe = year - era * 400;
+        const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    void TimeUtils::civilFromDays(int days, int &year, int &month, int &day)
+    {
+        days += 719468;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const int doe = days - era * 146097;
+        const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const int mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp + (mp < 10 ? 3 : -9);
+        year = yoe + era * 400 + (month <= 2);
+    }
+
+    int TimeUtils::weekday(int days)
+    {
+        // 1970-01-01 was a Thursday
+        return ((days % 7) + 7 + 3) % 7;
+    }
+
+    int TimeUtils::dayOf(const std::chrono::system_clock::time_point &time, const TimeZone &zone)
+    {
+        int64_t seconds = toSeconds(time) + zone.offsetAt(time).count();
+        return static_cast<int>(floorDiv(seconds, kSecondsPerDay));
+    }
+
+    std::chrono::system_clock::time_point TimeUtils::startOfDay(int days, const TimeZone &zone)
+    {
+        CivilTime civil;
+        civilFromDays(days, civil.year, civil.month, civil.day);
+        return zone.fromCivil(civil);
+    }
+
+    std::size_t TimeUtils::formatIsoDate(int days, char *out)
+    {
+        int year, month, day;
+        civilFromDays(days, year, month, day);
+        put4(out, year);
+        out[4] = '-';
+        put2(out + 5, month);
+        out[7] = '-';
+        put2(out + 8, day);
+        out[kIsoDateLength] = '\0';
+        return kIsoDateLength;
+    }
+
+    std::size_t TimeUtils::formatIsoDateTime(const std::chrono::system_clock::time_point &time, char *out,
+                                             const TimeZone &zone)
+    {
+        CivilTime civil = zone.toCivil(time);
+        put4(out, civil.year);
+        out[4] = '-';
+        put2(out + 5, civil.month);
+        out[7] = '-';
+        put2(out + 8, civil.day);
+        out[10] = 'T';
+        put2(out + 11, civil.hour);
+        out[13] = ':';
+        put2(out + 14, civil.minute);
+        out[16] = ':';
+        put2(out + 17, civil.second);
+        out[kIsoDateTimeLength] = '\0';
+        return kIsoDateTimeLength;
+    }
+
+    std::string TimeUtils::formatIsoDate(int days)
+    {
+        char buffer[kIsoDateLength + 1];
+        return std::string(buffer, formatIsoDate(days, buffer));
+    }
+
+    std::string TimeUtils::formatIsoDate(const std::chrono::system_clock::time_point &time, const TimeZone &zone)
+    {
+        return formatIsoDate(dayOf(time, zone));
+    }
+
+    std::string TimeUtils::formatIsoDateTime(const std::chrono::system_clock::time_point &time, const TimeZone &zone)
+    {
+        char buffer[kIsoDateTimeLength + 1];
+        return std::string(buffer, formatIsoDateTime(time, buffer, zone));
+    }
+
+    std::string TimeUtils::formatReadable(const std::chrono::system_clock::time_point &time, bool withYear,
+                                          const TimeZone &zone)
+    {
+        CivilTime civil = zone.toCivil(time);
+        char day[3], clock[6];
+        put2(day, civil.day);
+        day[2] = '\0';
+        put2(clock, civil.hour % 12 == 0 ? 12 : civil.hour % 12);
+        clock[2] = ':';
+        put2(clock + 3, civil.minute);
+        clock[5] = '\0';
+
+        std::string text = kMonthNames[civil.month - 1];
+        text += ' ';
+        text += day;
+        if (withYear)
+        {
+            text += ", " + std::to_string(civil.year);
+        }
+        text += " at ";
+        text += clock;
+        text += civil.hour < 12 ? " AM" : " PM";
+        return text;
+    }
+
+    bool TimeUtils::parseIsoDate(std::string_view text, int &days)
+    {
+        int year, month, day;
+        if (text.size() != kIsoDateLength || !parseIsoDateFields(text, year, month, day))
+        {
+            return false;
+        }
+        days = daysFromCivil(year, month, day);
+        return true;
+    }
+
+    bool TimeUtils::parseIsoDateTime(std::string_view text, std::chrono::system_clock::time_point &time,
+                                     const TimeZone &zone)
+    {
+        CivilTime civil;
+        if (text.size() != kIsoDateTimeLength || !parseIsoDateFields(text, civil.year, civil.month, civil.day))
+        {
+            return false;
+        }
+
+        unsigned bad = 0;
+        civil.hour = digits(text, 11, 2, bad);
+        civil.minute = digits(text, 14, 2, bad);
+        civil.second = digits(text, 17, 2, bad);
+        bad |= text[10] != 'T';
+        bad |= text[13] != ':';
+        bad |= text[16] != ':';
+        if (bad || civil.hour > 23 || civil.minute > 59 || civil.second > 60)
+        {
+            return false;
+        }
+
+        time = zone.fromCivil(civil);
+        return true;
+    }
+
+} // namespace tarius::utils
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace tarius::utils
+{
+
+    // A date and time of day on the proleptic Gregorian calendar, in no
+    // particular zone
+    struct CivilTime
+    {
+        int year = 1970;
+        int month = 1; // 1-12
+        int day = 1;   // 1-31
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+    };
+
+    /**
+     * @brief UTC, a fixed offset from it, or the zone the process runs in.
+     *
+     * Offsets of the local zone come from the C library once per quarter
+     * hour of UTC time and are kept in a small lock-free table, so repeated
+     * conversions around the same times, as in serialization or reminder
+     * checks, don't consult the zone database again. Transitions are taken
+     * to fall on quarter hours, which holds for every zone since 1970. The
+     * table is filled for the zone in effect when first used; a later change
+     * of TZ is not picked up.
+     */
+    class TimeZone
+    {
+    public:
+        static const TimeZone &utc();
+        static const TimeZone &local();
+        // Always offset from UTC by the given amount, e.g. +05:30
+        static TimeZone fixed(std::chrono::minutes offset);
+
+        std::chrono::seconds offsetAt(const std::chrono::system_clock::time_point &time) const;
+
+        CivilTime toCivil(const std::chrono::system_clock::time_point &time) const;
+
+        // Fields out of range carry over, so day 32 is in the next month.
+        // A local time that happens twice resolves to the earlier one, and
+        // one skipped by a change of offset moves forward by the change, as
+        // with mktime. Times the clock can't hold are clamped to its ends.
+        std::chrono::system_clock::time_point fromCivil(const CivilTime &civil) const;
+
+    private:
+        TimeZone(bool isLocal, std::chrono::seconds offset);
+
+        bool m_local;
+        std::chrono::seconds m_offset; // Fixed zones only
+    };
+
+    /**
+     * @brief Calendar arithmetic and ISO-8601 formatting and parsing.
+     *
+     * The ISO functions work on fixed layouts: dates are YYYY-MM-DD and
+     * timestamps YYYY-MM-DDTHH:MM:SS, zone-less and in the given zone, as
+     * every store in data/ writes them. Formatting writes digits straight
+     * into a caller's buffer; parsing checks every position in one pass.
+     */
+    class TimeUtils
+    {
+    public:
+        static constexpr std::size_t kIsoDateLength = 10;
+        static constexpr std::size_t kIsoDateTimeLength = 19;
+
+        // Years a system_clock::time_point holds in full at any resolution
+        // down to nanoseconds. Times built from civil fields beyond them are
+        // clamped to the clock's ends; the ISO parsers reject them.
+        static constexpr int kMinYear = 1678;
+        static constexpr int kMaxYear = 2261;
+
+        // Days since 1970-01-01
+        static int daysFromCivil(int year, int month, int day);
+        static void civilFromDays(int days, int &year, int &month, int &day);
+        // 0 = Monday
+        static int weekday(int days);
+
+        // Local day number of a time, and the first instant of a day
+        static int dayOf(const std::chrono::system_clock::time_point &time, const TimeZone &zone = TimeZone::local());
+        static std::chrono::system_clock::time_point startOfDay(int days, const TimeZone &zone = TimeZone::local());
+
+        // Write into out, which needs room for the length plus a NUL; returns the length
+        static std::size_t formatIsoDate(int days, char *out);
+        static std::size_t formatIsoDateTime(const std::chrono::system_clock::time_point &time, char *out,
+                                             const TimeZone &zone = TimeZone::local());
+
+        static std::string formatIsoDate(int days);
+        static std::string formatIsoDate(const std::chrono::system_clock::time_point &time,
+                                         const TimeZone &zone = TimeZone::local());
+        static std::string formatIsoDateTime(const std::chrono::system_clock::time_point &time,
+                                             const TimeZone &zone = TimeZone::local());
+
+        // "October 19, 2026 at 03:00 PM", or "October 19 at 03:00 PM"
+        static std::string formatReadable(const std::chrono::system_clock::time_point &time, bool withYear = true,
+                                          const TimeZone &zone = TimeZone::local());
+
+        // false, leaving the output alone, unless text is exactly the layout
+        // with every field in range and the year within kMinYear-kMaxYear
+        static bool parseIsoDate(std::string_view text, int &days);
+        static bool parseIsoDateTime(std::string_view text, std::chrono::system_clock::time_point &time,
+                                     const TimeZone &zone = TimeZone::local());
+    };
+
+} // namespace tarius::utils
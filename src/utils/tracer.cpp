@@ -0,0 +1,350 @@
+#include "tracer.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace tarius::utils
+{
+    namespace
+    {
+        constexpr uint64_t kRingCapacity = 1 << 14;
+        constexpr uint64_t kRingMask = kRingCapacity - 1;
+
+        // Shortest stretch of wall time used to convert ticks to microseconds
+        constexpr std::chrono::milliseconds kMinCalibration(20);
+
+        struct Span
+        {
+            const char *name;
+            uint64_t start;
+            uint64_t end;
+        };
+
+        struct Slot
+        {
+            std::atomic<const char *> name{nullptr};
+            std::atomic<uint64_t> start{0};
+            std::atomic<uint64_t> end{0};
+        };
+
+        /**
+         * @brief One thread's span ring, written only by that thread.
+         *
+         * m_begun is raised before a slot is overwritten and m_head after, so
+         * an exporter copying the ring while its owner keeps tracing can tell
+         * which of the copied slots were rewritten under it.
+         */
+        class ThreadBuffer
+        {
+        public:
+            explicit ThreadBuffer(long tid)
+                : m_tid(tid), m_name(nullptr), m_slots(std::make_unique<Slot[]>(kRingCapacity)), m_begun(0), m_head(0)
+            {
+            }
+
+            void record(const char *name, uint64_t start, uint64_t end)
+            {
+                uint64_t pos = m_head.load(std::memory_order_relaxed);
+                m_begun.store(pos + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                Slot &slot = m_slots[pos & kRingMask];
+                slot.name.store(name, std::memory_order_relaxed);
+                slot.start.store(start, std::memory_order_relaxed);
+                slot.end.store(end, std::memory_order_relaxed);
+                m_head.store(pos + 1, std::memory_order_release);
+            }
+
+            std::vector<Span> snapshot() const
+            {
+                uint64_t head = m_head.load(std::memory_order_acquire);
+                uint64_t first = head > kRingCapacity ? head - kRingCapacity : 0;
+
+                std::vector<Span> spans;
+                spans.reserve(head - first);
+                for (uint64_t pos = first; pos < head; pos++)
+                {
+                    const Slot &slot = m_slots[pos & kRingMask];
+                    spans.push_back({slot.name.load(std::memory_order_relaxed),
+                                     slot.start.load(std::memory_order_relaxed),
+                                     slot.end.load(std::memory_order_relaxed)});
+                }
+
+                // Any slot whose copy saw a newer write has its position
+                // within one lap of m_begun; drop those
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t begun = m_begun.load(std::memory_order_relaxed);
+                uint64_t valid = begun > kRingCapacity ? begun - kRingCapacity : 0;
+                if (valid > first)
+                {
+                    spans.erase(spans.begin(), spans.begin() + std::min<uint64_t>(valid - first, spans.size()));
+                }
+                return spans;
+            }
+
+            long tid() const { return m_tid; }
+            const char *name() const { return m_name.load(std::memory_order_relaxed); }
+            void setName(const char *name) { m_name.store(name, std::memory_order_relaxed); }
+
+        private:
+            long m_tid;
+            std::atomic<const char *> m_name;
+            std::unique_ptr<Slot[]> m_slots;
+            alignas(64) std::atomic<uint64_t> m_begun;
+            std::atomic<uint64_t> m_head;
+        };
+
+        // Buffers outlive their threads, so spans from threads that have
+        // exited can still be exported; never freed, like the logger backend
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        };
+
+        Registry &registry()
+        {
+            static Registry *instance = new Registry();
+            return *instance;
+        }
+
+        long currentThreadId()
+        {
+#ifdef __linux__
+            return static_cast<long>(syscall(SYS_gettid));
+#else
+            static std::atomic<long> next{1};
+            return next.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+
+        // A thread gets its ring on its first span, so naming a thread that
+        // never records costs nothing
+        thread_local ThreadBuffer *t_buffer = nullptr;
+        thread_local const char *t_threadName = nullptr;
+
+        ThreadBuffer &localBuffer()
+        {
+            if (!t_buffer)
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                reg.buffers.push_back(std::make_unique<ThreadBuffer>(currentThreadId()));
+                t_buffer = reg.buffers.back().get();
+                t_buffer->setName(t_threadName);
+            }
+            return *t_buffer;
+        }
+
+        int64_t steadyNanoseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Session bounds in ticks, plus the wall time of the start for calibration
+        std::atomic<uint64_t> g_sessionStart{0};
+        std::atomic<uint64_t> g_sessionEnd{0};
+        std::atomic<int64_t> g_sessionStartNs{0};
+        std::mutex g_sessionMutex;
+
+        // Ticks per microsecond, measured against the steady clock since
+        // the session started. Assumes an invariant TSC, as on any recent x86.
+        double ticksPerMicrosecond(uint64_t startTicks, int64_t startNs)
+        {
+            uint64_t ticks = Tracer::now();
+            int64_t ns = steadyNanoseconds();
+            if (ns - startNs < std::chrono::nanoseconds(kMinCalibration).count())
+            {
+                std::this_thread::sleep_for(kMinCalibration);
+                ticks = Tracer::now();
+                ns = steadyNanoseconds();
+            }
+            return static_cast<double>(ticks - startTicks) * 1000.0 / static_cast<double>(ns - startNs);
+        }
+
+        void appendJsonString(fmt::memory_buffer &out, std::string_view text)
+        {
+            out.push_back('"');
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out.push_back('\\');
+                }
+                out.push_back(c);
+            }
+            out.push_back('"');
+        }
+    } // namespace
+
+    std::atomic<bool> Tracer::s_active{false};
+
+    void Tracer::start()
+    {
+        std::lock_guard<std::mutex> lock(g_sessionMutex);
+        g_sessionStartNs.store(steadyNanoseconds(), std::memory_order_relaxed);
+        g_sessionStart.store(now(), std::memory_order_release);
+        s_active.store(true, std::memory_order_relaxed);
+        LOG_INFO("Tracing started");
+    }
+
+    void Tracer::stop()
+    {
+        std::lock_guard<std::mutex> lock(g_sessionMutex);
+        if (!s_active.exchange(false, std::memory_order_relaxed))
+        {
+            return;
+        }
+        g_sessionEnd.store(now(), std::memory_order_release);
+        LOG_INFO("Tracing stopped");
+    }
+
+    void Tracer::setThreadName(const char *name)
+    {
+        t_threadName = name;
+        if (t_buffer)
+        {
+            t_buffer->setName(name);
+        }
+    }
+
+    uint64_t Tracer::now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(steadyNanoseconds());
+#endif
+    }
+
+    void Tracer::record(const char *name, uint64_t start, uint64_t end)
+    {
+        localBuffer().record(name, start, end);
+    }
+
+    bool Tracer::writeChromeTrace(const std::string &path, std::size_t &spanCount)
+    {
+        spanCount = 0;
+
+        uint64_t sessionStart;
+        uint64_t sessionEnd;
+        int64_t sessionStartNs;
+        {
+            std::lock_guard<std::mutex> lock(g_sessionMutex);
+            sessionStart = g_sessionStart.load(std::memory_order_acquire);
+            sessionEnd = isActive() ? now() : g_sessionEnd.load(std::memory_order_acquire);
+            sessionStartNs = g_sessionStartNs.load(std::memory_order_relaxed);
+        }
+        if (sessionStart == 0)
+        {
+            LOG_ERROR("No trace has been recorded");
+            return false;
+        }
+        double ticksPerUs = ticksPerMicrosecond(sessionStart, sessionStartNs);
+
+        std::vector<ThreadBuffer *> buffers;
+        {
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (const auto &buffer : reg.buffers)
+            {
+                buffers.push_back(buffer.get());
+            }
+        }
+
+        fmt::memory_buffer out;
+        auto it = std::back_inserter(out);
+        long pid = static_cast<long>(getpid());
+        fmt::format_to(it, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        auto separate = [&]()
+        {
+            if (!first)
+            {
+                fmt::format_to(it, ",\n");
+            }
+            first = false;
+        };
+
+        for (ThreadBuffer *buffer : buffers)
+        {
+            std::vector<Span> spans = buffer->snapshot();
+
+            separate();
+            fmt::format_to(it, "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":", pid,
+                           buffer->tid());
+            if (const char *name = buffer->name())
+            {
+                appendJsonString(out, name);
+            }
+            else
+            {
+                fmt::format_to(it, "\"thread {}\"", buffer->tid());
+            }
+            fmt::format_to(it, "}}}}");
+
+            for (const Span &span : spans)
+            {
+                if (!span.name || span.start < sessionStart || span.start > sessionEnd)
+                {
+                    continue;
+                }
+
+                std::string_view name(span.name);
+                separate();
+                fmt::format_to(it, "{{\"name\":");
+                appendJsonString(out, name);
+                fmt::format_to(it, ",\"cat\":");
+                appendJsonString(out, name.substr(0, name.find('.')));
+                fmt::format_to(it, ",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+                               static_cast<double>(span.start - sessionStart) / ticksPerUs,
+                               static_cast<double>(span.end - span.start) / ticksPerUs, pid, buffer->tid());
+                spanCount++;
+            }
+        }
+        fmt::format_to(it, "\n]}}\n");
+
+        fs::path parent = fs::path(path).parent_path();
+        std::error_code ec;
+        if (!parent.empty())
+        {
+            fs::create_directories(parent, ec);
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            LOG_ERROR("Failed to open trace file: {}", path);
+            return false;
+        }
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file)
+        {
+            LOG_ERROR("Failed to write trace file: {}", path);
+            return false;
+        }
+
+        LOG_INFO("Wrote {} trace spans to {}", spanCount, path);
+        return true;
+    }
+
+} // namespace tarius::utils
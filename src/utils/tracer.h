@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Times the rest of the enclosing block as a span named by a string literal,
+// e.g. TRACE_SCOPE("llama.decode"). The text before the first '.' becomes the
+// span's category in the viewer.
+#ifdef TARIUS_DISABLE_TRACING
+#define TRACE_SCOPE(name) (void)0
+#else
+#define TARIUS_TRACE_CONCAT_INNER(a, b) a##b
+#define TARIUS_TRACE_CONCAT(a, b) TARIUS_TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) tarius::utils::TraceScope TARIUS_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#endif
+
+namespace tarius::utils
+{
+    /**
+     * @brief Low-overhead span tracer for finding where a slow turn went.
+     *
+     * Each thread writes fixed-size binary records (name pointer, start and
+     * end in TSC ticks) into its own ring buffer, so recording a span takes
+     * no lock and allocates nothing. While tracing is stopped a span costs
+     * one relaxed load. Rings keep the latest 16k spans per thread; older
+     * ones are overwritten.
+     *
+     * writeChromeTrace() converts the spans of the last session to Chrome
+     * trace_event JSON, viewable in chrome://tracing or ui.perfetto.dev.
+     */
+    class Tracer
+    {
+    public:
+        // Begin a session; spans from earlier sessions are not exported
+        static void start();
+        static void stop();
+
+        static bool isActive() { return s_active.load(std::memory_order_relaxed); }
+
+        // Label for the calling thread in the viewer; name must be a literal
+        static void setThreadName(const char *name);
+
+        // Export the last session's spans. Can be called while tracing.
+        static bool writeChromeTrace(const std::string &path, std::size_t &spanCount);
+
+        // Timestamp in TSC ticks where available, else steady-clock nanoseconds
+        static uint64_t now();
+
+        static void record(const char *name, uint64_t start, uint64_t end);
+
+    private:
+        static std::atomic<bool> s_active;
+    };
+
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char *name)
+            : m_name(name), m_start(Tracer::isActive() ? Tracer::now() : 0)
+        {
+        }
+
+        ~TraceScope()
+        {
+            if (m_start)
+            {
+                Tracer::record(m_name, m_start, Tracer::now());
+            }
+        }
+
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+    private:
+        const char *m_name;
+        uint64_t m_start;
+    };
+
+} // namespace tarius::utils